@@ -693,7 +693,15 @@ midi_track_iter_t *MIDI_IterateTrack(const midi_file_t *file, unsigned int track
 
     assert(track < file->num_tracks);
 
-    iter = (midi_track_iter_t*)Z_Malloc(sizeof(*iter));
+    // Iterators are made when a song starts playing, which may be on the
+    // music render thread, so they stay off the zone.
+
+    iter = (midi_track_iter_t*)malloc(sizeof(*iter));
+    if (iter == NULL)
+    {
+        I_Error("MIDI_IterateTrack: out of memory");
+    }
+
     iter->track = &file->tracks[track];
     iter->position = 0;
 
@@ -702,7 +710,7 @@ midi_track_iter_t *MIDI_IterateTrack(const midi_file_t *file, unsigned int track
 
 void MIDI_FreeIterator(midi_track_iter_t *iter)
 {
-    Z_Free(iter);
+    free(iter);
 }
 
 // Get the time until the next MIDI event in a track.
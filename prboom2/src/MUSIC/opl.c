@@ -397,6 +397,11 @@ void OPL_InitRegisters(void)
     OPL_WriteRegister(OPL_REG_FM_MODE,         0x40);
 }
 
+unsigned int OPL_GetTime(void)
+{
+    return current_time;
+}
+
 void OPL_SetPaused(int paused)
 {
     opl_paused = paused;
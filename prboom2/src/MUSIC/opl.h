@@ -119,4 +119,8 @@ void OPL_SetCallback(unsigned int ms, opl_callback_t callback, void *data);
 
 void OPL_ClearCallbacks(void);
 
+// Number of samples rendered since the OPL subsystem was initialized.
+
+unsigned int OPL_GetTime(void);
+
 #endif
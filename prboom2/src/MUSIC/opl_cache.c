@@ -0,0 +1,612 @@
+//
+// Copyright(C) 2023 by Ryan Krafnick
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//     Cache of pre-rendered OPL songs.
+//
+//     Renderings are recorded while a song plays live, and kept in memory
+//     (up to a budget) and on disk, in the data root, so that the next time
+//     the song comes up it can be streamed instead of emulated.
+//
+//     Recording happens on whichever thread renders music, while lookups
+//     that touch the disk happen on the main thread when a song is
+//     registered.  The music code never does both at once, so there is
+//     no locking here; the sample buffers use malloc rather than the zone
+//     for the same reason.
+//
+//     New renderings are written out by a background thread.  Files are
+//     opened, and removed after a failed write, on the main thread, since
+//     the file helpers may use the zone; the writer only writes and closes.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "SDL.h"
+
+#include "lprintf.h"
+#include "m_file.h"
+#include "z_zone.h"
+
+#include "dsda/data_organizer.h"
+#include "dsda/utility.h"
+
+#include "opl_cache.h"
+
+#define OPL_CACHE_MAGIC 0x43504f44 // "DOPC"
+#define OPL_CACHE_VERSION 2
+
+// Total size of the renderings kept in memory
+#define OPL_CACHE_BUDGET (64 * 1024 * 1024)
+
+// Songs longer than this are played live only
+#define OPL_CACHE_MAX_SECONDS (10 * 60)
+
+typedef struct
+{
+    unsigned int magic;
+    unsigned int version;
+    opl_cache_key_t key;
+    unsigned int loop_end;
+    unsigned int length;
+} opl_cache_header_t;
+
+static opl_cache_entry_t *cache_entries;
+static size_t cache_size;
+static unsigned int cache_clock;
+static char *cache_dir;
+
+// A file being written; it has its own copy of the samples, so the entry
+// can be dropped from memory meanwhile.
+
+typedef struct opl_cache_job_s
+{
+    FILE *file;
+    char *filename;
+    opl_cache_header_t header;
+    short *samples;
+    dboolean failed;
+    struct opl_cache_job_s *next;
+} opl_cache_job_t;
+
+static SDL_Thread *save_thread;
+static SDL_mutex *save_mutex;
+static SDL_cond *save_cond;
+static opl_cache_job_t *save_queue;
+static opl_cache_job_t *save_done;
+static dboolean save_quit;
+static dboolean save_sync; // the writer couldn't be started
+
+static size_t EntrySize(const opl_cache_entry_t *entry)
+{
+    return (size_t) entry->capacity * sizeof(*entry->samples);
+}
+
+static dboolean KeysMatch(const opl_cache_key_t *a, const opl_cache_key_t *b)
+{
+    return !memcmp(a->md5, b->md5, sizeof(a->md5))
+        && a->rate == b->rate
+        && a->volume == b->volume
+        && a->gain == b->gain
+        && a->looping == b->looping;
+}
+
+static void FreeEntry(opl_cache_entry_t *entry)
+{
+    free(entry->samples);
+    free(entry);
+}
+
+static void Unlink(opl_cache_entry_t *entry)
+{
+    opl_cache_entry_t **link;
+
+    for (link = &cache_entries; *link; link = &(*link)->next)
+    {
+        if (*link == entry)
+        {
+            *link = entry->next;
+            cache_size -= EntrySize(entry);
+            return;
+        }
+    }
+}
+
+// Drop the least recently used renderings until size more bytes fit.
+
+static void MakeRoom(size_t size, const opl_cache_entry_t *keep)
+{
+    while (cache_size + size > OPL_CACHE_BUDGET)
+    {
+        opl_cache_entry_t *entry;
+        opl_cache_entry_t *oldest = NULL;
+
+        for (entry = cache_entries; entry; entry = entry->next)
+        {
+            if (entry != keep && entry->saved
+             && (!oldest || entry->last_used < oldest->last_used))
+            {
+                oldest = entry;
+            }
+        }
+
+        if (!oldest)
+        {
+            return;
+        }
+
+        Unlink(oldest);
+        FreeEntry(oldest);
+    }
+}
+
+static void Insert(opl_cache_entry_t *entry)
+{
+    MakeRoom(EntrySize(entry), entry);
+
+    entry->next = cache_entries;
+    cache_entries = entry;
+    cache_size += EntrySize(entry);
+}
+
+static const char *CacheDir(void)
+{
+    if (!cache_dir)
+    {
+        dsda_string_t str;
+
+        dsda_StringPrintF(&str, "%s/opl_cache", dsda_DataRoot());
+        cache_dir = str.string;
+
+        M_MakeDir(cache_dir, false);
+    }
+
+    return cache_dir;
+}
+
+static void CacheFileName(dsda_string_t *str, const opl_cache_key_t *key)
+{
+    dsda_cksum_t cksum;
+
+    memcpy(cksum.bytes, key->md5, sizeof(cksum.bytes));
+    dsda_TranslateCheckSum(&cksum);
+
+    dsda_StringPrintF(str, "%s/%s_%u_%d_%d%s.pcm",
+                      CacheDir(), cksum.string, key->rate, key->volume, key->gain,
+                      key->looping ? "_loop" : "");
+}
+
+static opl_cache_entry_t *Load(const opl_cache_key_t *key)
+{
+    dsda_string_t filename;
+    opl_cache_header_t header;
+    opl_cache_entry_t *entry = NULL;
+    FILE *file;
+
+    CacheFileName(&filename, key);
+    file = M_OpenFile(filename.string, "rb");
+    dsda_FreeString(&filename);
+
+    if (!file)
+    {
+        return NULL;
+    }
+
+    if (fread(&header, sizeof(header), 1, file) == 1
+     && header.magic == OPL_CACHE_MAGIC
+     && header.version == OPL_CACHE_VERSION
+     && KeysMatch(&header.key, key)
+     && header.length > 0
+     && header.length <= key->rate * OPL_CACHE_MAX_SECONDS
+     && header.loop_end <= header.length)
+    {
+        entry = (opl_cache_entry_t *) calloc(1, sizeof(*entry));
+        if (entry)
+        {
+            entry->samples = (short *) malloc(header.length * sizeof(*entry->samples));
+        }
+
+        if (entry && entry->samples
+         && fread(entry->samples, sizeof(*entry->samples), header.length, file) == header.length)
+        {
+            entry->key = *key;
+            entry->length = header.length;
+            entry->capacity = header.length;
+            entry->loop_end = header.loop_end;
+            entry->complete = true;
+            entry->saved = true;
+        }
+        else if (entry)
+        {
+            FreeEntry(entry);
+            entry = NULL;
+        }
+    }
+
+    fclose(file);
+
+    return entry;
+}
+
+static void FreeJob(opl_cache_job_t *job)
+{
+    free(job->filename);
+    free(job->samples);
+    free(job);
+}
+
+static dboolean WriteJob(opl_cache_job_t *job)
+{
+    dboolean result;
+
+    result = fwrite(&job->header, sizeof(job->header), 1, job->file) == 1
+          && fwrite(job->samples, sizeof(*job->samples), job->header.length, job->file)
+             == job->header.length;
+
+    if (fclose(job->file))
+    {
+        result = false;
+    }
+
+    job->file = NULL;
+
+    return result;
+}
+
+// Main thread: report and clean up after a written file.
+
+static void FinishJob(opl_cache_job_t *job)
+{
+    if (job->failed)
+    {
+        lprintf(LO_WARN, "OPL_Cache_Save: couldn't write %s\n", job->filename);
+        M_remove(job->filename);
+    }
+
+    FreeJob(job);
+}
+
+static void FinishJobs(void)
+{
+    opl_cache_job_t *job;
+
+    if (!save_thread)
+    {
+        return;
+    }
+
+    SDL_LockMutex(save_mutex);
+    job = save_done;
+    save_done = NULL;
+    SDL_UnlockMutex(save_mutex);
+
+    while (job)
+    {
+        opl_cache_job_t *next = job->next;
+
+        FinishJob(job);
+        job = next;
+    }
+}
+
+static int SaveThread(void *unused)
+{
+    SDL_LockMutex(save_mutex);
+
+    while (1)
+    {
+        opl_cache_job_t *job;
+
+        while (!save_queue && !save_quit)
+        {
+            SDL_CondWait(save_cond, save_mutex);
+        }
+
+        // Everything queued is written before quitting
+        if (!save_queue)
+        {
+            break;
+        }
+
+        job = save_queue;
+        save_queue = job->next;
+        SDL_UnlockMutex(save_mutex);
+
+        job->failed = !WriteJob(job);
+
+        SDL_LockMutex(save_mutex);
+        job->next = save_done;
+        save_done = job;
+    }
+
+    SDL_UnlockMutex(save_mutex);
+
+    return 0;
+}
+
+static dboolean StartSaveThread(void)
+{
+    if (save_thread)
+    {
+        return true;
+    }
+
+    if (save_sync)
+    {
+        return false;
+    }
+
+    save_quit = false;
+    save_mutex = SDL_CreateMutex();
+    save_cond = SDL_CreateCond();
+
+    if (save_mutex && save_cond)
+    {
+        save_thread = SDL_CreateThread(SaveThread, "OPL cache writer", NULL);
+    }
+
+    if (!save_thread)
+    {
+        lprintf(LO_WARN, "OPL_Cache_Save: writer thread failed, writing from main thread\n");
+
+        if (save_cond)
+        {
+            SDL_DestroyCond(save_cond);
+            save_cond = NULL;
+        }
+
+        if (save_mutex)
+        {
+            SDL_DestroyMutex(save_mutex);
+            save_mutex = NULL;
+        }
+
+        save_sync = true;
+
+        return false;
+    }
+
+    return true;
+}
+
+static void StopSaveThread(void)
+{
+    if (!save_thread)
+    {
+        return;
+    }
+
+    SDL_LockMutex(save_mutex);
+    save_quit = true;
+    SDL_CondSignal(save_cond);
+    SDL_UnlockMutex(save_mutex);
+
+    SDL_WaitThread(save_thread, NULL);
+
+    FinishJobs();
+    save_thread = NULL;
+
+    SDL_DestroyCond(save_cond);
+    SDL_DestroyMutex(save_mutex);
+    save_cond = NULL;
+    save_mutex = NULL;
+}
+
+static void Save(opl_cache_entry_t *entry)
+{
+    dsda_string_t filename;
+    opl_cache_job_t *job;
+
+    // Whatever happens, don't try again
+    entry->saved = true;
+
+    job = (opl_cache_job_t *) calloc(1, sizeof(*job));
+    if (!job)
+    {
+        return;
+    }
+
+    CacheFileName(&filename, &entry->key);
+    job->filename = (char *) malloc(strlen(filename.string) + 1);
+    if (job->filename)
+    {
+        strcpy(job->filename, filename.string);
+    }
+    dsda_FreeString(&filename);
+
+    job->samples = (short *) malloc(entry->length * sizeof(*job->samples));
+
+    if (!job->filename || !job->samples)
+    {
+        FreeJob(job);
+        return;
+    }
+
+    memcpy(job->samples, entry->samples, entry->length * sizeof(*job->samples));
+
+    job->header.magic = OPL_CACHE_MAGIC;
+    job->header.version = OPL_CACHE_VERSION;
+    job->header.key = entry->key;
+    job->header.loop_end = entry->loop_end;
+    job->header.length = entry->length;
+
+    job->file = M_OpenFile(job->filename, "wb");
+    if (!job->file)
+    {
+        FreeJob(job);
+        return;
+    }
+
+    if (StartSaveThread())
+    {
+        SDL_LockMutex(save_mutex);
+        job->next = save_queue;
+        save_queue = job;
+        SDL_CondSignal(save_cond);
+        SDL_UnlockMutex(save_mutex);
+    }
+    else
+    {
+        job->failed = !WriteJob(job);
+        FinishJob(job);
+    }
+}
+
+opl_cache_entry_t *OPL_Cache_Find(const opl_cache_key_t *key, dboolean load)
+{
+    opl_cache_entry_t *entry;
+
+    for (entry = cache_entries; entry; entry = entry->next)
+    {
+        if (KeysMatch(&entry->key, key))
+        {
+            entry->last_used = ++cache_clock;
+            return entry;
+        }
+    }
+
+    if (load && (entry = Load(key)))
+    {
+        entry->last_used = ++cache_clock;
+        Insert(entry);
+    }
+
+    return entry;
+}
+
+opl_cache_entry_t *OPL_Cache_Begin(const opl_cache_key_t *key)
+{
+    opl_cache_entry_t *entry;
+
+    if (key->rate == 0)
+    {
+        return NULL;
+    }
+
+    entry = (opl_cache_entry_t *) calloc(1, sizeof(*entry));
+    if (entry)
+    {
+        entry->key = *key;
+    }
+
+    return entry;
+}
+
+dboolean OPL_Cache_Append(opl_cache_entry_t *entry, const short *stereo, unsigned int nsamp)
+{
+    unsigned int i;
+
+    if (entry->length + nsamp > entry->capacity)
+    {
+        unsigned int capacity = entry->capacity ? entry->capacity : entry->key.rate * 16;
+        short *samples;
+
+        while (capacity < entry->length + nsamp)
+        {
+            capacity *= 2;
+        }
+
+        if (capacity > entry->key.rate * OPL_CACHE_MAX_SECONDS)
+        {
+            capacity = entry->key.rate * OPL_CACHE_MAX_SECONDS;
+
+            if (capacity < entry->length + nsamp)
+            {
+                return false;
+            }
+        }
+
+        samples = (short *) realloc(entry->samples, capacity * sizeof(*samples));
+        if (!samples)
+        {
+            return false;
+        }
+
+        entry->samples = samples;
+        entry->capacity = capacity;
+    }
+
+    for (i = 0; i < nsamp; ++i)
+    {
+        entry->samples[entry->length + i] = stereo[i * 2];
+    }
+
+    entry->length += nsamp;
+
+    return true;
+}
+
+void OPL_Cache_Finish(opl_cache_entry_t *entry, unsigned int length, unsigned int loop_end)
+{
+    short *samples;
+
+    entry->length = length;
+    entry->loop_end = loop_end;
+    entry->complete = true;
+    entry->last_used = ++cache_clock;
+
+    // Give back the slack from growing the buffer
+    samples = (short *) realloc(entry->samples, length * sizeof(*samples));
+    if (samples)
+    {
+        entry->samples = samples;
+        entry->capacity = length;
+    }
+
+    Insert(entry);
+}
+
+void OPL_Cache_Discard(opl_cache_entry_t *entry)
+{
+    if (entry->complete)
+    {
+        Unlink(entry);
+    }
+
+    FreeEntry(entry);
+}
+
+void OPL_Cache_Save(void)
+{
+    opl_cache_entry_t *entry;
+
+    FinishJobs();
+
+    for (entry = cache_entries; entry; entry = entry->next)
+    {
+        if (!entry->saved)
+        {
+            Save(entry);
+        }
+    }
+
+    // Anything over budget that couldn't be dropped before can go now
+    MakeRoom(0, NULL);
+}
+
+void OPL_Cache_Shutdown(void)
+{
+    OPL_Cache_Save();
+    StopSaveThread();
+
+    while (cache_entries)
+    {
+        opl_cache_entry_t *entry = cache_entries;
+
+        cache_entries = entry->next;
+        FreeEntry(entry);
+    }
+
+    cache_size = 0;
+}
@@ -0,0 +1,77 @@
+//
+// Copyright(C) 2023 by Ryan Krafnick
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//     Cache of pre-rendered OPL songs.
+//
+
+#ifndef OPL_CACHE_H
+#define OPL_CACHE_H
+
+#include "doomtype.h"
+
+// The OPL output for a song is fully determined by the midi data, the
+// instrument bank, the sample rate, the music volume, the gain and whether
+// it loops, so a rendering can be reused as long as all of them match.
+
+typedef struct
+{
+    byte md5[16]; // GENMIDI lump followed by the midi data
+    unsigned int rate;
+    int volume;
+    int gain;
+    int looping;
+} opl_cache_key_t;
+
+typedef struct opl_cache_entry_s opl_cache_entry_t;
+
+struct opl_cache_entry_s
+{
+    opl_cache_key_t key;
+
+    // Mono samples; the OPL output is the same on both channels.
+    short *samples;
+    unsigned int length;
+    unsigned int capacity;
+
+    // Where the first pass through the song ends.  What follows is how it
+    // carries on: the release tail if the song doesn't loop, or else the
+    // start of the second pass, with the end of the first still ringing,
+    // which is played in place of the start on every pass after the first.
+    unsigned int loop_end;
+
+    dboolean complete;
+    dboolean saved;
+    unsigned int last_used;
+
+    opl_cache_entry_t *next;
+};
+
+// Find a complete rendering.  If load is set, renderings saved by an
+// earlier session are read from disk as well.
+opl_cache_entry_t *OPL_Cache_Find(const opl_cache_key_t *key, dboolean load);
+
+// Start a new rendering, filled in with OPL_Cache_Append.  Returns NULL
+// if the song is too long to be worth caching.
+opl_cache_entry_t *OPL_Cache_Begin(const opl_cache_key_t *key);
+dboolean OPL_Cache_Append(opl_cache_entry_t *entry, const short *stereo, unsigned int nsamp);
+void OPL_Cache_Finish(opl_cache_entry_t *entry, unsigned int length, unsigned int loop_end);
+void OPL_Cache_Discard(opl_cache_entry_t *entry);
+
+// Write out any renderings not yet on disk.  The files are written by a
+// background thread; shutdown waits for it to finish.
+void OPL_Cache_Save(void);
+
+void OPL_Cache_Shutdown(void);
+
+#endif
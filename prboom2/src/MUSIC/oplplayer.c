@@ -37,7 +37,12 @@
 #include "w_wad.h"
 #include "z_zone.h"
 
+#include "md5.h"
+
+#include "dsda/configuration.h"
+
 #include "opl.h"
+#include "opl_cache.h"
 #include "midifile.h"
 
 #include "musicplayer.h"
@@ -316,6 +321,11 @@ static int current_music_volume;
 static const genmidi_instr_t *main_instrs;
 static const genmidi_instr_t *percussion_instrs;
 
+// Hash of the instrument bank, which every cache key starts from: a pwad
+// can replace GENMIDI, and the same song then sounds different.
+
+static struct MD5Context genmidi_md5;
+
 // Voices:
 
 static opl_voice_t voices[OPL_NUM_VOICES];
@@ -329,6 +339,45 @@ static unsigned int num_tracks = 0;
 static unsigned int running_tracks = 0;
 static dboolean song_looping;
 
+// Registered songs.  The cache key identifies the midi data; the volume
+// is filled in when the song is played.
+
+typedef struct
+{
+    midi_file_t *file;
+    opl_cache_key_t key;
+    dboolean cache;
+} opl_song_t;
+
+// Playback of a song either streams a cached rendering or emulates it
+// live, recording the output so that it can be streamed next time.
+
+static const opl_song_t *playing_song;
+static opl_cache_entry_t *stream_entry;
+static opl_cache_entry_t *record_entry;
+static dboolean song_paused;
+
+// Samples played since the song (re)started; for a stream, the position
+// within the current pass.
+
+static unsigned int song_position;
+static dboolean stream_repeat;
+
+// OPL time at the start of the song, and how long the first pass took.
+
+static unsigned int song_start_time;
+static unsigned int song_loop_end;
+static dboolean song_finished;
+
+static int opl_cache_gain;
+
+// How much to record past the end of a song
+
+#define OPL_CACHE_HEAD (2 * opl_sample_rate)
+
+static void StartPlayback(void);
+static void DropRecording(void);
+
 // Configuration file variable, containing the port number for the
 // adlib chip.
 
@@ -339,8 +388,10 @@ int opl_io_port = 0x388;
 static dboolean LoadInstrumentTable(void)
 {
     const byte *lump;
+    int lumpnum;
 
-    lump = (const byte*)W_LumpByName("GENMIDI");
+    lumpnum = W_GetNumForName("GENMIDI");
+    lump = (const byte*)W_LumpByNum(lumpnum);
 
     // Check header
 
@@ -352,6 +403,9 @@ static dboolean LoadInstrumentTable(void)
     main_instrs = (const genmidi_instr_t *) (lump + strlen(GENMIDI_HEADER));
     percussion_instrs = main_instrs + GENMIDI_NUM_INSTRS;
 
+    MD5Init(&genmidi_md5);
+    MD5Update(&genmidi_md5, (const md5byte *) lump, W_LumpLength(lumpnum));
+
     return true;
 }
 
@@ -594,6 +648,29 @@ void I_OPL_SetMusicVolume(int volume)
             SetVoiceVolume(&voices[i], voices[i].note_volume);
         }
     }
+
+    // Renderings are only good for the volume they were made at.
+
+    if (stream_entry != NULL || record_entry != NULL)
+    {
+        const opl_cache_entry_t *entry = stream_entry ? stream_entry : record_entry;
+
+        if (entry->key.volume != opl_vol)
+        {
+            if (song_position == 0)
+            {
+                // Nothing heard yet, so look again.
+
+                StartPlayback();
+            }
+            else if (record_entry != NULL)
+            {
+                DropRecording();
+            }
+
+            // A stream carries on, scaled to the new volume.
+        }
+    }
 }
 
 static void VoiceKeyOff(opl_voice_t *voice)
@@ -1139,6 +1216,14 @@ static void TrackTimerCallback(void *arg)
     {
         --running_tracks;
 
+        // Note where the first pass ended, for the loop point.
+
+        if (running_tracks <= 0 && !song_finished)
+        {
+            song_finished = true;
+            song_loop_end = OPL_GetTime() - song_start_time;
+        }
+
         // When all tracks have finished, restart the song.
 
         if (running_tracks <= 0 && song_looping)
@@ -1209,31 +1294,24 @@ static void StartTrack(const midi_file_t *file, unsigned int track_num)
     ScheduleTrack(track);
 }
 
-// Start playing a mid
+// Start emulating the playing song from the beginning.
 
-static void I_OPL_PlaySong(const void *handle, int looping)
+static void StartLiveSong(void)
 {
-    const midi_file_t *file;
+    const midi_file_t *file = playing_song->file;
     unsigned int i;
 
-    if (!music_initialized || handle == NULL)
+    // Allocate track data.  This runs on the music render thread, so it
+    // stays off the zone.
+
+    tracks = (opl_track_data_t*)malloc(MIDI_NumTracks(file) * sizeof(opl_track_data_t));
+    if (tracks == NULL)
     {
-        return;
+        I_Error("StartLiveSong: out of memory");
     }
 
-    // This is required to interface with OPL (I think)
-    #pragma GCC diagnostic push
-    #pragma GCC diagnostic ignored "-Wcast-qual"
-    file = (midi_file_t*)handle;
-    #pragma GCC diagnostic pop
-
-    // Allocate track data.
-
-    tracks = (opl_track_data_t*)Z_Malloc(MIDI_NumTracks(file) * sizeof(opl_track_data_t));
-
     num_tracks = MIDI_NumTracks(file);
     running_tracks = num_tracks;
-    song_looping = looping;
 
     for (i=0; i<num_tracks; ++i)
     {
@@ -1241,43 +1319,213 @@ static void I_OPL_PlaySong(const void *handle, int looping)
     }
 }
 
-static void I_OPL_PauseSong(void)
+static void StopLiveSong(void)
 {
     unsigned int i;
 
-    if (!music_initialized)
+    // Stop all playback.
+
+    OPL_ClearCallbacks();
+
+    // Free all voices.
+
+    for (i=0; i<OPL_NUM_VOICES; ++i)
     {
-        return;
+        if (voices[i].channel != NULL)
+        {
+            VoiceKeyOff(&voices[i]);
+            ReleaseVoice(&voices[i]);
+        }
     }
 
-    // Pause OPL callbacks.
+    // Free all track data.
 
-    OPL_SetPaused(1);
+    for (i=0; i<num_tracks; ++i)
+    {
+        MIDI_FreeIterator(tracks[i].iter);
+    }
 
-    // Turn off all main instrument voices (not percussion).
-    // This is what Vanilla does.
+    free(tracks);
 
-    for (i=0; i<OPL_NUM_VOICES; ++i)
+    tracks = NULL;
+    num_tracks = 0;
+}
+
+static void DropRecording(void)
+{
+    if (record_entry != NULL)
     {
-        if (voices[i].channel != NULL
-         && voices[i].current_instr < percussion_instrs)
+        OPL_Cache_Discard(record_entry);
+        record_entry = NULL;
+    }
+}
+
+static void StopPlayback(void)
+{
+    stream_entry = NULL;
+    DropRecording();
+    StopLiveSong();
+}
+
+// Start the playing song from the beginning, from the cache if possible.
+
+static void StartPlayback(void)
+{
+    StopPlayback();
+
+    song_position = 0;
+    song_finished = false;
+    song_start_time = OPL_GetTime();
+
+    // A silent rendering couldn't be scaled up again if the volume changes.
+
+    if (playing_song->cache && volume_mapping_table[current_music_volume] > 0)
+    {
+        opl_cache_key_t key = playing_song->key;
+
+        key.volume = current_music_volume;
+        key.looping = song_looping;
+
+        stream_entry = OPL_Cache_Find(&key, false);
+        if (stream_entry != NULL)
         {
-            VoiceKeyOff(&voices[i]);
+            stream_repeat = false;
+            return;
         }
+
+        record_entry = OPL_Cache_Begin(&key);
     }
+
+    StartLiveSong();
 }
 
-static void I_OPL_ResumeSong(void)
+// If the volume changed after the stream started, the rendering is scaled
+// by the ratio of the two volume levels, as a 16.16 gain.  This is close to,
+// but not exactly, what the chip would have played at the new volume; the
+// next time the song starts it is streamed or recorded at the new volume.
+
+static int StreamGain(const opl_cache_entry_t *entry)
 {
-    if (!music_initialized)
+    if (entry->key.volume == current_music_volume)
     {
+        return 1 << 16;
+    }
+
+    return (volume_mapping_table[current_music_volume] << 16)
+         / volume_mapping_table[entry->key.volume];
+}
+
+static void StreamSamples(short *dest, unsigned int nsamp)
+{
+    const opl_cache_entry_t *entry = stream_entry;
+    int gain = StreamGain(entry);
+
+    while (nsamp > 0)
+    {
+        unsigned int end = song_looping ? entry->loop_end : entry->length;
+        unsigned int head = entry->length - entry->loop_end;
+        const short *source;
+        unsigned int count;
+        unsigned int i;
+
+        if (song_paused || song_position >= end)
+        {
+            if (!song_paused && song_looping)
+            {
+                song_position = 0;
+                stream_repeat = true;
+                continue;
+            }
+
+            memset(dest, 0, nsamp * 4);
+            return;
+        }
+
+        // After the first pass, the start of the song comes from the
+        // recording of the second.
+
+        if (stream_repeat && song_position < head)
+        {
+            source = entry->samples + entry->loop_end + song_position;
+            count = MIN(nsamp, head - song_position);
+        }
+        else
+        {
+            source = entry->samples + song_position;
+            count = MIN(nsamp, end - song_position);
+        }
+
+        if (gain == 1 << 16)
+        {
+            for (i = 0; i < count; ++i)
+            {
+                dest[i * 2] = dest[i * 2 + 1] = source[i];
+            }
+        }
+        else
+        {
+            for (i = 0; i < count; ++i)
+            {
+                int sample = (source[i] * gain) >> 16;
+
+                dest[i * 2] = dest[i * 2 + 1] = BETWEEN(-32768, 32767, sample);
+            }
+        }
+
+        dest += count * 2;
+        nsamp -= count;
+        song_position += count;
+    }
+}
+
+static void RecordSamples(const short *dest, unsigned int nsamp)
+{
+    unsigned int length;
+
+    if (!OPL_Cache_Append(record_entry, dest, nsamp))
+    {
+        DropRecording();
         return;
     }
 
-    OPL_SetPaused(0);
+    if (!song_finished)
+    {
+        return;
+    }
+
+    // Keep going past the end of the first pass, for the release tail or
+    // for the start of the second pass, which differs from the first by
+    // whatever is still ringing.
+
+    length = song_loop_end + (song_looping ? MIN(song_loop_end, OPL_CACHE_HEAD) : OPL_CACHE_HEAD);
+
+    if (song_loop_end == 0)
+    {
+        DropRecording();
+    }
+    else if (record_entry->length >= length)
+    {
+        OPL_Cache_Finish(record_entry, length, song_loop_end);
+        record_entry = NULL;
+    }
 }
 
-static void I_OPL_StopSong(void)
+// Start playing a mid
+
+static void I_OPL_PlaySong(const void *handle, int looping)
+{
+    if (!music_initialized || handle == NULL)
+    {
+        return;
+    }
+
+    playing_song = (const opl_song_t *) handle;
+    song_looping = looping;
+
+    StartPlayback();
+}
+
+static void I_OPL_PauseSong(void)
 {
     unsigned int i;
 
@@ -1286,50 +1534,73 @@ static void I_OPL_StopSong(void)
         return;
     }
 
+    // Pause OPL callbacks.
 
-    // Stop all playback.
+    OPL_SetPaused(1);
+    song_paused = true;
 
-    OPL_ClearCallbacks();
+    // A paused recording would have the gap in it.
 
-    // Free all voices.
+    DropRecording();
+
+    // Turn off all main instrument voices (not percussion).
+    // This is what Vanilla does.
 
     for (i=0; i<OPL_NUM_VOICES; ++i)
     {
-        if (voices[i].channel != NULL)
+        if (voices[i].channel != NULL
+         && voices[i].current_instr < percussion_instrs)
         {
             VoiceKeyOff(&voices[i]);
-            ReleaseVoice(&voices[i]);
         }
     }
+}
 
-    // Free all track data.
-
-    for (i=0; i<num_tracks; ++i)
+static void I_OPL_ResumeSong(void)
+{
+    if (!music_initialized)
     {
-        MIDI_FreeIterator(tracks[i].iter);
+        return;
     }
 
-    Z_Free(tracks);
+    OPL_SetPaused(0);
+    song_paused = false;
+}
 
-    tracks = NULL;
-    num_tracks = 0;
+static void I_OPL_StopSong(void)
+{
+    if (!music_initialized)
+    {
+        return;
+    }
 
+    StopPlayback();
+    playing_song = NULL;
 }
 
 static void I_OPL_UnRegisterSong(const void *handle)
 {
+    opl_song_t *song = (opl_song_t *) handle;
+
     if (!music_initialized)
     {
         return;
     }
 
-    if (handle != NULL)
+    if (song != NULL)
     {
-        // This is required to interface with OPL (I think)
-        #pragma GCC diagnostic push
-        #pragma GCC diagnostic ignored "-Wcast-qual"
-        MIDI_FreeFile((midi_file_t *) handle);
-        #pragma GCC diagnostic pop
+        if (playing_song == song)
+        {
+            I_OPL_StopSong();
+        }
+
+        MIDI_FreeFile(song->file);
+        Z_Free(song);
+
+        // Whatever was recorded while it played is safe to keep now.
+        // The files are written in the background.
+
+        OPL_Cache_Save();
     }
 }
 
@@ -1344,6 +1615,7 @@ static dboolean IsMid(byte *mem, int len)
 static const void *I_OPL_RegisterSong(const void *data, unsigned len)
 {
     midi_file_t *result;
+    opl_song_t *song;
     midimem_t mf;
 
     if (!music_initialized)
@@ -1371,10 +1643,35 @@ static const void *I_OPL_RegisterSong(const void *data, unsigned len)
     if (result == NULL)
     {
         lprintf (LO_WARN, "I_OPL_RegisterSong: Failed to load MID.\n");
+        return NULL;
     }
 
+    song = (opl_song_t *) Z_Calloc(1, sizeof(*song));
+    song->file = result;
+    song->cache = dsda_IntConfig(dsda_config_mus_opl_cache);
 
-    return result;
+    if (song->cache)
+    {
+        opl_cache_key_t key;
+        struct MD5Context md5;
+
+        md5 = genmidi_md5;
+        MD5Update(&md5, (const md5byte *) data, len);
+        MD5Final(song->key.md5, &md5);
+
+        song->key.rate = opl_sample_rate;
+        song->key.gain = opl_cache_gain;
+
+        // Pull a rendering from disk now, while the level loads, rather
+        // than when the song starts.  Level music always loops.
+
+        key = song->key;
+        key.volume = current_music_volume;
+        key.looping = true;
+        OPL_Cache_Find(&key, true);
+    }
+
+    return song;
 }
 
 
@@ -1387,6 +1684,7 @@ static void I_OPL_ShutdownMusic(void)
         I_OPL_StopSong();
 
         OPL_Shutdown();
+        OPL_Cache_Shutdown();
 
         music_initialized = false;
     }
@@ -1413,6 +1711,8 @@ int I_OPL_InitMusic(int samplerate)
 
     InitVoices();
 
+    opl_cache_gain = dsda_IntConfig(dsda_config_mus_opl_gain);
+
     tracks = NULL;
     num_tracks = 0;
     music_initialized = true;
@@ -1427,7 +1727,19 @@ const char *I_OPL_SynthName (void)
 
 void I_OPL_RenderSamples (void *dest, unsigned nsamp)
 {
+    if (stream_entry != NULL)
+    {
+        StreamSamples(dest, nsamp);
+        return;
+    }
+
     OPL_Render_Samples (dest, nsamp);
+    song_position += nsamp;
+
+    if (record_entry != NULL)
+    {
+        RecordSamples(dest, nsamp);
+    }
 }
 
 const music_player_t opl_synth_player =
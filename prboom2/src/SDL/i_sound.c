@@ -108,6 +108,8 @@ typedef struct
   int leftvol;
   int rightvol;
   dboolean loop;
+  // data comes from the sfx cache: signed 16 bit at the output rate
+  dboolean converted;
 } channel_info_t;
 
 channel_info_t channelinfo[MAX_CHANNELS];
@@ -121,6 +123,8 @@ int   steptable[256];
 // NSM
 static int dumping_sound = 0;
 
+static dboolean sound_was_initialized;
+
 
 // lock for updating any params related to sfx
 SDL_mutex *sfxmutex;
@@ -159,94 +163,409 @@ static void stopchan(int i)
   }
 }
 
-typedef struct wav_data_s
+//
+// Sound effect cache.
+//
+// Every sound lump is converted once into signed 16 bit mono at the output
+//  rate, sampled exactly where the mixer would step through the original,
+//  so starting a sound never touches the decoder and the mixer just walks
+//  the samples. A worker thread converts everything the sfx table refers
+//  to at startup; a sound played before the worker gets to it plays from
+//  the lump as before, except that wav lumps are converted on the spot.
+//
+
+// Memory the worker may spend on converted sounds
+#define SFX_CACHE_LIMIT (64 * 1024 * 1024)
+
+typedef enum
 {
-  int sfxid;
-  const unsigned char *data;
+  sfx_cache_empty,
+  sfx_cache_working,
+  sfx_cache_ready,
+  sfx_cache_failed,
+} sfx_cache_state_t;
+
+typedef struct
+{
+  SDL_atomic_t state;
+  short *data;
   int samplelen;
-  int samplerate;
-  int bits;
-  struct wav_data_s *next;
-} wav_data_t;
+} sfx_cache_t;
 
-#define WAV_DATA_HASH_SIZE 32
-static wav_data_t *wav_data_hash[WAV_DATA_HASH_SIZE];
+// indexed by lump, so linked sounds share an entry
+static sfx_cache_t *sfx_cache;
 
-static wav_data_t *GetWavData(int sfxid, const unsigned char *data, size_t len)
+typedef struct
 {
-  int key;
-  wav_data_t *target = NULL;
+  int lump;
+  const unsigned char *data;
+  size_t len;
+} sfx_cache_job_t;
 
-  key = (sfxid % WAV_DATA_HASH_SIZE);
+static sfx_cache_job_t *sfx_cache_jobs;
+static int sfx_cache_job_count;
+static SDL_Thread *sfx_cache_thread;
+static SDL_atomic_t sfx_cache_quit;
+static SDL_atomic_t sfx_cache_finished;
 
-  if (wav_data_hash[key])
-  {
-    wav_data_t *rover = wav_data_hash[key];
+static struct
+{
+  int converted;
+  int failed;
+  int skipped;
+  int on_demand;
+  size_t lump_bytes;
+  size_t bytes;
+  Uint32 ms;
+} sfx_cache_stats;
+
+static dboolean I_IsWav(const unsigned char *data, size_t len)
+{
+  return len > 44 && !memcmp(data, "RIFF", 4) && !memcmp(data + 8, "WAVEfmt ", 8);
+}
 
-    while (rover)
-    {
-      if (rover->sfxid == sfxid)
-      {
-        target = rover;
-        break;
-      }
+// Where the mixer starts and stops in a sound lump, as addsfx used to
+//  set up the channel. wav_buffer needs SDL_FreeWAV if set.
+typedef struct
+{
+  const unsigned char *data;
+  const unsigned char *enddata;
+  const unsigned char *bufend;
+  int samplerate;
+  int bits;
+  Uint8 *wav_buffer;
+} sfx_source_t;
 
-      rover = rover->next;
-    }
-  }
+static dboolean I_OpenSfxSource(sfx_source_t *src, const unsigned char *data, size_t len)
+{
+  memset(src, 0, sizeof(*src));
 
-  if (target == NULL &&
-      len > 44 && !memcmp(data, "RIFF", 4) && !memcmp(data + 8, "WAVEfmt ", 8))
+  if (I_IsWav(data, len))
   {
     SDL_RWops *RWops;
     SDL_AudioSpec wav_spec;
     Uint8 *wav_buffer = NULL;
-    int bits, samplelen;
+    Uint32 samplelen;
+    int bits;
 
     RWops = SDL_RWFromConstMem(data, len);
 
     if (SDL_LoadWAV_RW(RWops, 1, &wav_spec, &wav_buffer, &samplelen) == NULL)
     {
       lprintf(LO_WARN, "Could not open wav file: %s\n", SDL_GetError());
-      return NULL;
+      return false;
     }
 
+    bits = SDL_AUDIO_BITSIZE(wav_spec.format);
+
     if (wav_spec.channels != 1)
-    {
       lprintf(LO_WARN, "Only mono WAV file is supported");
-      SDL_FreeWAV(wav_buffer);
-      return NULL;
+    else if (!SDL_AUDIO_ISINT(wav_spec.format))
+      lprintf(LO_WARN, "WAV file in unsupported format");
+    else if (bits != 8 && bits != 16)
+      lprintf(LO_WARN, "Only 8 or 16 bit WAV files are supported");
+    else if (samplelen > 0)
+    {
+      src->data = wav_buffer;
+      src->enddata = wav_buffer + samplelen - 1;
+      src->bufend = wav_buffer + samplelen;
+      src->samplerate = wav_spec.freq;
+      src->bits = bits;
+      src->wav_buffer = wav_buffer;
+      return true;
     }
 
-    if (!SDL_AUDIO_ISINT(wav_spec.format))
+    SDL_FreeWAV(wav_buffer);
+    return false;
+  }
+
+  // DMX format: 8 byte header, then 8 bit unsigned samples
+  if (len <= 16)
+    return false;
+
+  src->data = data + 8;
+  src->enddata = data + len - 9;
+  src->bufend = data + len;
+  src->samplerate = (data[3] << 8) + data[2];
+  src->bits = 8;
+
+  return true;
+}
+
+// Number of frames the mixer plays from a source at the output rate,
+//  matching I_ChannelRunLength from the start of the sound.
+static int I_SfxSourceFrames(const sfx_source_t *src)
+{
+  int bps = src->bits == 16 ? 2 : 1;
+  int64_t rem = src->enddata - src->data;
+  int64_t step = ((int64_t) src->samplerate << 16) / snd_samplerate;
+
+  if (rem <= 0 || step <= 0)
+    return 1;
+
+  return (int) ((((rem + bps - 1) / bps << 16) + step - 1) / step);
+}
+
+// Resample a source the way the mixer does, scaled so that the mixer can
+//  multiply by 256 to get back to its own range.
+static void I_ConvertSfxSource(short *out, int frames, const sfx_source_t *src)
+{
+  int bps = src->bits == 16 ? 2 : 1;
+  int64_t avail = (src->bufend - src->data) / bps;
+  uint64_t step = ((uint64_t) src->samplerate << 16) / snd_samplerate;
+  int i;
+
+  for (i = 0; i < frames; i++)
+  {
+    uint64_t pos = i * step;
+    int64_t index = pos >> 16;
+    int64_t next = index + 1 < avail ? index + 1 : index;
+    int s;
+
+    if (index >= avail)
     {
-      lprintf(LO_WARN, "WAV file in unsupported format");
-      SDL_FreeWAV(wav_buffer);
-      return NULL;
+      out[i] = 0;
+      continue;
     }
 
-    bits = SDL_AUDIO_BITSIZE(wav_spec.format);
-    if (bits != 8 && bits != 16)
+    if (src->bits == 16)
     {
-      lprintf(LO_WARN, "Only 8 or 16 bit WAV files are supported");
-      SDL_FreeWAV(wav_buffer);
-      return NULL;
+      const unsigned char *p = src->data + index * 2;
+      const unsigned char *q = src->data + next * 2;
+      int r = (pos & 0xffff) >> 8;
+
+      s = (short)(p[0] | (p[1] << 8)) * (255 - r)
+        + (short)(q[0] | (q[1] << 8)) * r;
+    }
+    else
+    {
+      unsigned int r = pos & 0xffff;
+
+      s = ((unsigned int) src->data[index] * (0x10000 - r))
+        + ((unsigned int) src->data[next] * r)
+        - 0x800000;
+    }
+
+    out[i] = (short) (s / 256);
+  }
+
+  // the mixer reads one sample ahead
+  out[frames] = out[frames - 1];
+}
+
+// Converts the lump into the entry, which the caller has claimed.
+//  Returns the size used, or 0 if the sound can't be converted. If
+//  limit is non-zero, sounds that would push the total over it are
+//  skipped and left for later.
+static size_t I_ConvertSfx(sfx_cache_t *entry, const unsigned char *data, size_t len, size_t limit)
+{
+  sfx_source_t src;
+  size_t size;
+  int frames;
+
+  if (!I_OpenSfxSource(&src, data, len))
+  {
+    SDL_AtomicSet(&entry->state, sfx_cache_failed);
+    return 0;
+  }
+
+  frames = I_SfxSourceFrames(&src);
+  size = (frames + 1) * sizeof(short);
+
+  if (limit && sfx_cache_stats.bytes + size > limit)
+  {
+    if (src.wav_buffer)
+      SDL_FreeWAV(src.wav_buffer);
+    SDL_AtomicSet(&entry->state, sfx_cache_empty);
+    ++sfx_cache_stats.skipped;
+    return 0;
+  }
+
+  entry->data = malloc(size);
+  if (entry->data)
+  {
+    I_ConvertSfxSource(entry->data, frames, &src);
+    entry->samplelen = frames;
+  }
+
+  if (src.wav_buffer)
+    SDL_FreeWAV(src.wav_buffer);
+
+  SDL_AtomicSet(&entry->state, entry->data ? sfx_cache_ready : sfx_cache_failed);
+
+  return entry->data ? size : 0;
+}
+
+static int I_SfxCacheThread(void *unused)
+{
+  Uint32 start = SDL_GetTicks();
+  int i;
+
+  for (i = 0; i < sfx_cache_job_count && !SDL_AtomicGet(&sfx_cache_quit); i++)
+  {
+    sfx_cache_job_t *job = &sfx_cache_jobs[i];
+    sfx_cache_t *entry = &sfx_cache[job->lump];
+    size_t size;
+
+    // the game may have got there first
+    if (!SDL_AtomicCAS(&entry->state, sfx_cache_empty, sfx_cache_working))
+      continue;
+
+    size = I_ConvertSfx(entry, job->data, job->len, SFX_CACHE_LIMIT);
+
+    if (size)
+    {
+      ++sfx_cache_stats.converted;
+      sfx_cache_stats.lump_bytes += job->len;
+      sfx_cache_stats.bytes += size;
     }
+    else if (SDL_AtomicGet(&entry->state) == sfx_cache_failed)
+      ++sfx_cache_stats.failed;
+  }
+
+  sfx_cache_stats.ms = SDL_GetTicks() - start;
+  SDL_AtomicSet(&sfx_cache_finished, 1);
+
+  return 0;
+}
+
+// Wait for the worker and report what it did.
+static void I_FinishSfxCache(void)
+{
+  if (!sfx_cache_thread)
+    return;
+
+  SDL_WaitThread(sfx_cache_thread, NULL);
+  sfx_cache_thread = NULL;
+
+  Z_Free(sfx_cache_jobs);
+  sfx_cache_jobs = NULL;
+  sfx_cache_job_count = 0;
+
+  lprintf(LO_DEBUG, "I_PrecacheSounds: converted %d sounds (%d KB from %d KB of lumps) "
+          "in %u ms, %d failed, %d over the %d MB limit\n",
+          sfx_cache_stats.converted, (int) (sfx_cache_stats.bytes >> 10),
+          (int) (sfx_cache_stats.lump_bytes >> 10), sfx_cache_stats.ms,
+          sfx_cache_stats.failed, sfx_cache_stats.skipped, SFX_CACHE_LIMIT >> 20);
+}
+
+static void I_ShutdownSfxCache(void)
+{
+  int i;
+
+  SDL_AtomicSet(&sfx_cache_quit, 1);
+  I_FinishSfxCache();
+
+  if (!sfx_cache)
+    return;
+
+  if (sfx_cache_stats.on_demand)
+    lprintf(LO_DEBUG, "I_ShutdownSound: %d sounds converted on demand\n",
+            sfx_cache_stats.on_demand);
+
+  for (i = 0; i < numlumps; i++)
+    free(sfx_cache[i].data);
+
+  Z_Free(sfx_cache);
+  sfx_cache = NULL;
+}
+
+static void I_AllocSfxCache(void)
+{
+  if (!sfx_cache)
+    sfx_cache = Z_Calloc(numlumps, sizeof(*sfx_cache));
+}
+
+//
+// I_PrecacheSounds
+//
+// Start converting every sound in the sfx table in the background.
+// The lumps must already be locked, see dsda_CacheSoundLumps.
+//
+void I_PrecacheSounds(void)
+{
+  int i;
+
+  if (!sound_was_initialized || snd_pcspeaker || sfx_cache_thread)
+    return;
+
+  I_AllocSfxCache();
+
+  sfx_cache_jobs = Z_Malloc(num_sfx * sizeof(*sfx_cache_jobs));
+  sfx_cache_job_count = 0;
+
+  for (i = 1; i < num_sfx; i++)
+  {
+    int lump = S_sfx[i].lumpnum;
+    int j;
+
+    if (lump < 0 || W_LumpLength(lump) <= 8)
+      continue;
+
+    for (j = 0; j < sfx_cache_job_count; j++)
+      if (sfx_cache_jobs[j].lump == lump)
+        break;
+
+    if (j < sfx_cache_job_count)
+      continue;
+
+    sfx_cache_jobs[sfx_cache_job_count].lump = lump;
+    sfx_cache_jobs[sfx_cache_job_count].data = W_LockLumpNum(lump);
+    sfx_cache_jobs[sfx_cache_job_count].len = W_LumpLength(lump);
+    sfx_cache_job_count++;
+  }
 
-    target = Z_Malloc(sizeof(*target));
+  SDL_AtomicSet(&sfx_cache_quit, 0);
+  SDL_AtomicSet(&sfx_cache_finished, 0);
 
-    target->sfxid = sfxid;
-    target->data = wav_buffer;
-    target->samplelen = samplelen;
-    target->samplerate = wav_spec.freq;
-    target->bits = bits;
+  sfx_cache_thread = SDL_CreateThread(I_SfxCacheThread, "sfx cache", NULL);
 
-    // use head insertion
-    target->next = wav_data_hash[key];
-    wav_data_hash[key] = target;
+  if (!sfx_cache_thread)
+  {
+    lprintf(LO_WARN, "I_PrecacheSounds: couldn't start thread (%s)\n", SDL_GetError());
+    Z_Free(sfx_cache_jobs);
+    sfx_cache_jobs = NULL;
+    sfx_cache_job_count = 0;
   }
+}
+
+// The converted sound for a lump, or NULL to play it straight from the lump.
+static const sfx_cache_t *I_CachedSfx(int lump, const unsigned char *data, size_t len)
+{
+  sfx_cache_t *entry;
+
+  if (sfx_cache_thread && SDL_AtomicGet(&sfx_cache_finished))
+    I_FinishSfxCache();
 
-  return target;
+  I_AllocSfxCache();
+  entry = &sfx_cache[lump];
+
+  while (1)
+  {
+    switch (SDL_AtomicGet(&entry->state))
+    {
+      case sfx_cache_ready:
+        return entry;
+      case sfx_cache_failed:
+        return NULL;
+      case sfx_cache_working:
+        // the worker has it; this takes well under a millisecond
+        SDL_Delay(0);
+        break;
+      default:
+        // dmx sounds can play from the lump until the worker is done,
+        //  but wav sounds have to be decoded first
+        if (!I_IsWav(data, len))
+          return NULL;
+
+        if (SDL_AtomicCAS(&entry->state, sfx_cache_empty, sfx_cache_working))
+        {
+          ++sfx_cache_stats.on_demand;
+          I_ConvertSfx(entry, data, len, 0);
+        }
+        break;
+    }
+  }
 }
 
 //
@@ -256,19 +575,20 @@ static wav_data_t *GetWavData(int sfxid, const unsigned char *data, size_t len)
 //  (eight, usually) of internal channels.
 // Returns a handle.
 //
-static int addsfx(int sfxid, int channel, const unsigned char *data, size_t len)
+static int addsfx(int sfxid, int channel, const unsigned char *data, size_t len,
+                  const sfx_cache_t *cached)
 {
   channel_info_t *ci = channelinfo + channel;
-  wav_data_t *wav_data = GetWavData(sfxid, data, len);
 
   stopchan(channel);
 
-  if (wav_data)
+  if (cached)
   {
-    ci->data = wav_data->data;
-    ci->enddata = ci->data + wav_data->samplelen - 1;
-    ci->samplerate = wav_data->samplerate;
-    ci->bits = wav_data->bits;
+    ci->data = (const unsigned char *) cached->data;
+    ci->enddata = ci->data + cached->samplelen * 2;
+    ci->samplerate = snd_samplerate;
+    ci->bits = 16;
+    ci->converted = true;
   }
   else
   {
@@ -278,6 +598,7 @@ static int addsfx(int sfxid, int channel, const unsigned char *data, size_t len)
     ci->samplerate = (ci->data[3] << 8) + ci->data[2];
     ci->data += 8; /* Skip header */
     ci->bits = 8;
+    ci->converted = false;
   }
 
   ci->stepremainder = 0;
@@ -463,6 +784,7 @@ int I_GetSfxLumpNum(sfxinfo_t *sfx)
 int I_StartSound(int id, int channel, sfx_params_t *params)
 {
   const unsigned char *data;
+  const sfx_cache_t *cached;
   int lump;
   size_t len;
 
@@ -494,10 +816,12 @@ int I_StartSound(int id, int channel, sfx_params_t *params)
   // not in a memory mapped one
   data = (const unsigned char *)W_LockLumpNum(lump);
 
+  cached = I_CachedSfx(lump, data, len + 8);
+
   SDL_LockMutex (sfxmutex);
 
   // Returns a handle (not used).
-  addsfx(id, channel, data, len);
+  addsfx(id, channel, data, len, cached);
   updateSoundParams(channel, params);
 
   SDL_UnlockMutex (sfxmutex);
@@ -569,24 +893,184 @@ dboolean I_AnySoundStillPlaying(void)
 //
 
 static void UpdateMusic (void *buff, unsigned nsamp);
+static void I_StopMusicRender (void);
 
 // from pcsound_sdl.c
 void PCSound_Mix_Callback(void *udata, Uint8 *stream, int len);
 
+// Frames mixed per pass; sized so the accumulator stays in L1.
+#define MIX_CHUNK 512
+
+// Number of frames a channel can play before its data pointer
+//  reaches the end, counting the frame that gets it there.
+static int I_ChannelRunLength(const channel_info_t *ci, int maxframes)
+{
+  int bps = ci->bits == 16 ? 2 : 1;
+  int64_t rem = ci->enddata - ci->data;
+  int64_t target, n;
+
+  if (rem <= 0)
+    return 1;
+
+  if (!ci->step)
+    return maxframes;
+
+  // data >= enddata once (stepremainder + n * step) >> 16 samples have passed
+  target = ((rem + bps - 1) / bps) << 16;
+  n = (target - (int64_t) ci->stepremainder + ci->step - 1) / ci->step;
+  if (n < 1)
+    n = 1;
+
+  return n < maxframes ? (int) n : maxframes;
+}
+
+// Scales a run of resampled channel data by the channel volumes
+//  and adds it to the accumulator. Kept apart from the resampling
+//  so the compiler can vectorise it; the byte gathers cannot be.
+static void I_MixSamples(int *acc, const int *samples, int leftvol, int rightvol, int frames)
+{
+  int i;
+
+  // full loudness (vol=127) is actually 127/191
+  for (i = 0; i < frames; i++)
+  {
+    acc[2 * i]     += leftvol * samples[i] / 49152;
+    acc[2 * i + 1] += rightvol * samples[i] / 49152;
+  }
+}
+
+// Resamples one channel over a run of frames into the accumulator.
+// The position of every frame is derived from the run start, so
+//  there is no loop-carried state besides the output.
+static void I_MixChannel8(int *acc, const channel_info_t *ci, int frames)
+{
+  int samples[MIX_CHUNK];
+  const unsigned char *data = ci->data;
+  unsigned int frac = ci->stepremainder;
+  unsigned int step = ci->step;
+  int i;
+
+  for (i = 0; i < frames; i++)
+  {
+    unsigned int pos = frac + i * step;
+    const unsigned char *p = data + (pos >> 16);
+    unsigned int r = pos & 0xffff;
+    int s;
+
+    // linear filtering
+    // the old SRC did linear interpolation back into 8 bit, and then expanded to 16 bit.
+    // this does interpolation and 8->16 at same time, allowing slightly higher quality
+    s = ((unsigned int)p[0] * (0x10000 - r))
+      + ((unsigned int)p[1] * r)
+      - 0x800000; // convert to signed
+
+    samples[i] = s;
+  }
+
+  I_MixSamples(acc, samples, ci->leftvol, ci->rightvol, frames);
+}
+
+static void I_MixChannel16(int *acc, const channel_info_t *ci, int frames)
+{
+  int samples[MIX_CHUNK];
+  const unsigned char *data = ci->data;
+  unsigned int frac = ci->stepremainder;
+  unsigned int step = ci->step;
+  int i;
+
+  for (i = 0; i < frames; i++)
+  {
+    unsigned int pos = frac + i * step;
+    const unsigned char *p = data + (pos >> 16) * 2;
+    int r = (pos & 0xffff) >> 8;
+    int s;
+
+    s = (short)(p[0] | (p[1] << 8)) * (255 - r)
+      + (short)(p[2] | (p[3] << 8)) * r;
+
+    samples[i] = s;
+  }
+
+  I_MixSamples(acc, samples, ci->leftvol, ci->rightvol, frames);
+}
+
+// Converted data is already at the output rate, so unless the sound is
+//  pitched this is a straight copy.
+static void I_MixChannelConverted(int *acc, const channel_info_t *ci, int frames)
+{
+  int samples[MIX_CHUNK];
+  const short *data = (const short *) ci->data;
+  unsigned int frac = ci->stepremainder;
+  unsigned int step = ci->step;
+  int i;
+
+  if (step == 0x10000 && frac == 0)
+  {
+    for (i = 0; i < frames; i++)
+      samples[i] = data[i] * 256;
+  }
+  else
+  {
+    for (i = 0; i < frames; i++)
+    {
+      unsigned int pos = frac + i * step;
+      const short *p = data + (pos >> 16);
+      int r = (pos & 0xffff) >> 8;
+
+      samples[i] = p[0] * (256 - r) + p[1] * r;
+    }
+  }
+
+  I_MixSamples(acc, samples, ci->leftvol, ci->rightvol, frames);
+}
+
+// Plays a channel over the whole chunk, handling looping and the end
+//  of the sample. Leaves the channel exactly where the per-frame
+//  stepping of the old mixer would have.
+static void I_MixChannel(int chan, int *acc, int frames)
+{
+  channel_info_t *ci = channelinfo + chan;
+
+  while (frames > 0 && ci->data)
+  {
+    int bps = ci->bits == 16 ? 2 : 1;
+    int run = I_ChannelRunLength(ci, frames);
+    unsigned int advance;
+
+    if (ci->converted)
+      I_MixChannelConverted(acc, ci, run);
+    else if (ci->bits == 16)
+      I_MixChannel16(acc, ci, run);
+    else
+      I_MixChannel8(acc, ci, run);
+
+    advance = ci->stepremainder + (unsigned int) run * ci->step;
+    ci->data += (advance >> 16) * bps;
+    ci->stepremainder = advance & 0xffff;
+
+    acc += run * 2;
+    frames -= run;
+
+    // Check whether we are done.
+    if (ci->data >= ci->enddata)
+    {
+      if (ci->loop)
+        ci->data = ci->startdata;
+      else
+        stopchan(chan);
+    }
+  }
+}
+
 static void I_UpdateSound(void *unused, Uint8 *stream, int len)
 {
-  // Mix current sound data.
-  // Data, from raw sound, for right and left.
-  // register unsigned char sample;
-  register int    dl;
-  register int    dr;
+  // Channel-major mixing into a 32 bit accumulator,
+  //  then a single clamp back to the stream.
+  static int mixbuffer[MIX_CHUNK * 2];
 
-  // Pointers in audio stream, left, right, end.
-  signed short   *leftout;
-  signed short   *rightout;
-  signed short   *leftend;
-  // Step in stream, left and right, thus two.
-  int       step;
+  // Pointer in audio stream, left and right alternating.
+  signed short *out;
+  int frames;
 
   // Mixing channel index.
   int       chan;
@@ -601,11 +1085,7 @@ static void I_UpdateSound(void *unused, Uint8 *stream, int len)
 
   // do music update
   if (registered_non_rw)
-  {
-    SDL_LockMutex (musmutex);
     UpdateMusic (stream, len / 4);
-    SDL_UnlockMutex (musmutex);
-  }
 
   if (snd_pcspeaker)
   {
@@ -615,121 +1095,34 @@ static void I_UpdateSound(void *unused, Uint8 *stream, int len)
   }
 
   SDL_LockMutex (sfxmutex);
-  // Left and right channel
-  //  are in audio stream, alternating.
-  leftout = (signed short *)stream;
-  rightout = ((signed short *)stream) + 1;
-  step = 2;
-
-  // Determine end, for left channel only
-  //  (right channel is implicit).
-  leftend = leftout + (len / 4) * step;
-
-  // Mix sounds into the mixing buffer.
-  // Loop over step*SAMPLECOUNT,
-  //  that is 512 values for two channels.
-  while (leftout != leftend)
-  {
-    // Reset left/right value.
-    //dl = 0;
-    //dr = 0;
-    dl = *leftout;
-    dr = *rightout;
-
-    // Love thy L2 chache - made this a loop.
-    // Now more channels could be set at compile time
-    //  as well. Thus loop those  channels.
-    for ( chan = 0; chan < numChannels; chan++ )
-    {
-      channel_info_t *ci = channelinfo + chan;
-
-      // Check channel, if active.
-      if (ci->data)
-      {
-        int s;
-        // Get the raw data from the channel.
-        // no filtering
-        //int s = channelinfo[chan].data[0] * 0x10000 - 0x800000;
-
-        // linear filtering
-        // the old SRC did linear interpolation back into 8 bit, and then expanded to 16 bit.
-        // this does interpolation and 8->16 at same time, allowing slightly higher quality
-        if (ci->bits == 16)
-        {
-          s = (short)(ci->data[0] | (ci->data[1] << 8)) * (255 - (ci->stepremainder >> 8))
-            + (short)(ci->data[2] | (ci->data[3] << 8)) * (ci->stepremainder >> 8);
-        }
-        else
-        {
-          s = ((unsigned int)ci->data[0] * (0x10000 - ci->stepremainder))
-            + ((unsigned int)ci->data[1] * (ci->stepremainder))
-            - 0x800000; // convert to signed
-        }
-
-
-        // Add left and right part
-        //  for this channel (sound)
-        //  to the current data.
-        // Adjust volume accordingly.
-
-        // full loudness (vol=127) is actually 127/191
-
-        dl += ci->leftvol * s / 49152;  // >> 15;
-        dr += ci->rightvol * s / 49152; // >> 15;
-
-        // Increment index ???
-        ci->stepremainder += ci->step;
-
-        // MSB is next sample???
-        if (ci->bits == 16)
-          ci->data += (ci->stepremainder >> 16) * 2;
-        else
-          ci->data += ci->stepremainder >> 16;
 
-        // Limit to LSB???
-        ci->stepremainder &= 0xffff;
+  out = (signed short *)stream;
+  frames = len / 4;
 
-        // Check whether we are done.
-        if (ci->data >= ci->enddata)
-        {
-          if (ci->loop)
-            ci->data = ci->startdata;
-          else
-            stopchan(chan);
-        }
-      }
-    }
+  while (frames > 0)
+  {
+    int chunk = MIN(frames, MIX_CHUNK);
+    int i;
 
-    // Clamp to range. Left hardware channel.
-    // Has been char instead of short.
-    // if (dl > 127) *leftout = 127;
-    // else if (dl < -128) *leftout = -128;
-    // else *leftout = dl;
+    // Start from whatever music is already in the stream.
+    for (i = 0; i < chunk * 2; i++)
+      mixbuffer[i] = out[i];
 
-    if (dl > SHRT_MAX)
-      *leftout = SHRT_MAX;
-    else if (dl < SHRT_MIN)
-      *leftout = SHRT_MIN;
-    else
-      *leftout = (signed short)dl;
+    for (chan = 0; chan < numChannels; chan++)
+      if (channelinfo[chan].data)
+        I_MixChannel(chan, mixbuffer, chunk);
 
-    // Same for right hardware channel.
-    if (dr > SHRT_MAX)
-      *rightout = SHRT_MAX;
-    else if (dr < SHRT_MIN)
-      *rightout = SHRT_MIN;
-    else
-      *rightout = (signed short)dr;
+    // Clamp to range.
+    for (i = 0; i < chunk * 2; i++)
+      out[i] = (signed short) BETWEEN(SHRT_MIN, SHRT_MAX, mixbuffer[i]);
 
-    // Increment current pointers in stream
-    leftout += step;
-    rightout += step;
+    out += chunk * 2;
+    frames -= chunk;
   }
+
   SDL_UnlockMutex (sfxmutex);
 }
 
-static dboolean sound_was_initialized;
-
 void I_ShutdownSound(void)
 {
   if (sound_was_initialized)
@@ -737,6 +1130,8 @@ void I_ShutdownSound(void)
     Mix_CloseAudio();
     SDL_CloseAudio();
 
+    I_ShutdownSfxCache();
+
     sound_was_initialized = false;
 
     if (sfxmutex)
@@ -813,6 +1208,9 @@ void I_InitSound(void)
 void I_SetSoundCap (void)
 {
   dumping_sound = 1;
+
+  // music has to be rendered on demand to stay in sync with the frames
+  I_StopMusicRender ();
 }
 
 // grabs len samples of audio (16 bit interleaved)
@@ -958,17 +1356,290 @@ static const void *music_handle = NULL;
 
 static void *mus2mid_conversion_data = NULL;
 
+//
+// Music render-ahead.
+//
+// The active player renders on its own thread into a single-producer,
+//  single-consumer ring of s16 stereo frames, so the audio callback only
+//  has to copy.  Control calls (play, pause, volume, song changes...) are
+//  queued as commands and carried out by the render thread between chunks;
+//  commands that make the audio already in the ring stale also flush it.
+// Without a render thread (video capture, or if it failed to start) the
+//  commands run immediately and the player renders on demand, as before.
+//
+
+#define MUSIC_RING_FRAMES   4096 // power of two
+#define MUSIC_RENDER_FRAMES 512  // must divide MUSIC_RING_FRAMES
+#define MUSIC_QUEUE_SIZE    32
+
+typedef enum
+{
+  music_cmd_setsong,
+  music_cmd_release,
+  music_cmd_play,
+  music_cmd_pause,
+  music_cmd_resume,
+  music_cmd_stop,
+  music_cmd_volume,
+} music_cmd_type_t;
+
+typedef struct
+{
+  music_cmd_type_t type;
+  int player;
+  const void *handle;
+  int value;
+} music_cmd_t;
+
+static SDL_Thread *music_thread;
+static SDL_sem *music_wakeup;
+static SDL_cond *music_cmd_cond;
+static SDL_atomic_t music_quit;
+static SDL_atomic_t music_sleeping;
+static dboolean music_render_ahead;
+
+// command queue, protected by musmutex
+static music_cmd_t music_queue[MUSIC_QUEUE_SIZE];
+static int music_queue_count;
+static unsigned int music_cmd_posted;
+static unsigned int music_cmd_done;
+
+// frame counters: read is owned by the audio callback, write by the
+//  render thread.  a flush asks the callback to skip ahead to flush_pos.
+static short music_ring[MUSIC_RING_FRAMES * 2];
+static SDL_atomic_t music_ring_read;
+static SDL_atomic_t music_ring_write;
+static SDL_atomic_t music_flush_pos;
+static SDL_atomic_t music_flush_seq;
+
+// player state as seen by the renderer
+static int render_player = -1;
+static const void *render_handle = NULL;
+
+// the renderer only waits on music_wakeup once it has set music_sleeping,
+//  and only whoever clears the flag posts, so the semaphore never holds
+//  more than the one wakeup the renderer is about to consume.
+static void I_WakeMusicRender (void)
+{
+  if (SDL_AtomicCAS (&music_sleeping, 1, 0))
+    SDL_SemPost (music_wakeup);
+}
+
+// returns true if audio rendered before the command is now stale
+static dboolean I_RunMusicCommand (const music_cmd_t *cmd)
+{
+  if (cmd->type == music_cmd_setsong)
+  {
+    render_player = cmd->player;
+    render_handle = cmd->handle;
+    return true;
+  }
+
+  if (!render_handle)
+    return false;
+
+  switch (cmd->type)
+  {
+    case music_cmd_release:
+      render_handle = NULL;
+      return true;
+    case music_cmd_play:
+      music_players[render_player]->play (render_handle, cmd->value);
+      return true;
+    case music_cmd_pause:
+      music_players[render_player]->pause ();
+      return true;
+    case music_cmd_resume:
+      music_players[render_player]->resume ();
+      return true;
+    case music_cmd_stop:
+      music_players[render_player]->stop ();
+      return true;
+    case music_cmd_volume:
+      music_players[render_player]->setvolume (cmd->value);
+      return false;
+    default:
+      return false;
+  }
+}
+
+// queue a command for the current song.  commands don't wait for the
+//  renderer, except a release: once it returns the renderer has let go of
+//  the song, so the player is the game thread's to unregister, free and
+//  register again until the next setsong.  the renderer never touches the
+//  zone, so that wait is at most one render chunk.
+static void I_QueueMusicCommand (music_cmd_type_t type, int value)
+{
+  music_cmd_t cmd;
+  unsigned int serial;
+
+  cmd.type = type;
+  cmd.player = current_player;
+  cmd.handle = music_handle;
+  cmd.value = value;
+
+  SDL_LockMutex (musmutex);
+
+  if (!music_thread)
+  {
+    I_RunMusicCommand (&cmd);
+    SDL_UnlockMutex (musmutex);
+    return;
+  }
+
+  while (music_queue_count == MUSIC_QUEUE_SIZE)
+    SDL_CondWait (music_cmd_cond, musmutex);
+
+  music_queue[music_queue_count++] = cmd;
+  serial = ++music_cmd_posted;
+  I_WakeMusicRender ();
+
+  if (type == music_cmd_release)
+    while ((int) (music_cmd_done - serial) < 0)
+      SDL_CondWait (music_cmd_cond, musmutex);
+
+  SDL_UnlockMutex (musmutex);
+}
+
+static dboolean I_MusicRenderHasWork (void)
+{
+  unsigned int write = SDL_AtomicGet (&music_ring_write);
+  unsigned int read = SDL_AtomicGet (&music_ring_read);
+  dboolean queued;
+
+  SDL_LockMutex (musmutex);
+  queued = music_queue_count > 0;
+  SDL_UnlockMutex (musmutex);
+
+  return SDL_AtomicGet (&music_quit) || queued ||
+         (render_handle && write - read <= MUSIC_RING_FRAMES - MUSIC_RENDER_FRAMES);
+}
+
+static int I_MusicRenderThread (void *unused)
+{
+  music_cmd_t cmds[MUSIC_QUEUE_SIZE];
+
+  while (!SDL_AtomicGet (&music_quit))
+  {
+    unsigned int write = SDL_AtomicGet (&music_ring_write);
+    unsigned int read = SDL_AtomicGet (&music_ring_read);
+    dboolean flush = false;
+    int count, i;
+
+    SDL_LockMutex (musmutex);
+    count = music_queue_count;
+    if (count)
+      memcpy (cmds, music_queue, count * sizeof (*cmds));
+    music_queue_count = 0;
+    SDL_UnlockMutex (musmutex);
+
+    if (count)
+    {
+      for (i = 0; i < count; i++)
+        flush |= I_RunMusicCommand (&cmds[i]);
+
+      if (flush)
+      {
+        SDL_AtomicSet (&music_flush_pos, write);
+        SDL_AtomicAdd (&music_flush_seq, 1);
+        read = write;
+      }
+
+      SDL_LockMutex (musmutex);
+      music_cmd_done += count;
+      SDL_CondBroadcast (music_cmd_cond);
+      SDL_UnlockMutex (musmutex);
+    }
+
+    if (render_handle && write - read <= MUSIC_RING_FRAMES - MUSIC_RENDER_FRAMES)
+    {
+      short *dest = music_ring + (write & (MUSIC_RING_FRAMES - 1)) * 2;
+
+      music_players[render_player]->render (dest, MUSIC_RENDER_FRAMES);
+      SDL_AtomicSet (&music_ring_write, write + MUSIC_RENDER_FRAMES);
+    }
+    else
+    {
+      // ring full or nothing to play; the callback and new commands wake us.
+      //  look again after raising the flag, so a wakeup can't slip past.
+      SDL_AtomicSet (&music_sleeping, 1);
+
+      if (!I_MusicRenderHasWork () || !SDL_AtomicCAS (&music_sleeping, 1, 0))
+        SDL_SemWait (music_wakeup);
+    }
+  }
+
+  return 0;
+}
+
+static void I_StartMusicRender (void)
+{
+  music_wakeup = SDL_CreateSemaphore (0);
+  music_cmd_cond = SDL_CreateCond ();
+  SDL_AtomicSet (&music_quit, 0);
+  SDL_AtomicSet (&music_sleeping, 0);
+
+  if (music_wakeup && music_cmd_cond)
+    music_thread = SDL_CreateThread (I_MusicRenderThread, "music render", NULL);
+
+  if (!music_thread)
+  {
+    lprintf (LO_WARN, "I_InitMusic: couldn't start music render thread (%s)\n", SDL_GetError ());
+    return;
+  }
+
+  music_render_ahead = true;
+}
+
+static void I_StopMusicRender (void)
+{
+  int i;
+
+  if (!music_thread)
+    return;
+
+  SDL_AtomicSet (&music_quit, 1);
+  I_WakeMusicRender ();
+  SDL_WaitThread (music_thread, NULL);
+
+  // the callback keeps reading the ring until here
+  SDL_LockMutex (musmutex);
+  music_thread = NULL;
+  music_render_ahead = false;
+
+  for (i = 0; i < music_queue_count; i++)
+    I_RunMusicCommand (&music_queue[i]);
+  music_cmd_done += music_queue_count;
+  music_queue_count = 0;
+  SDL_CondBroadcast (music_cmd_cond);
+  SDL_UnlockMutex (musmutex);
+}
+
 void I_ShutdownMusic(void)
 {
   int i;
   S_StopMusic ();
 
+  I_StopMusicRender ();
+
   for (i = 0; music_players[i]; i++)
   {
     if (music_player_was_init[i])
       music_players[i]->shutdown ();
   }
 
+  if (music_cmd_cond)
+  {
+    SDL_DestroyCond (music_cmd_cond);
+    music_cmd_cond = NULL;
+  }
+
+  if (music_wakeup)
+  {
+    SDL_DestroySemaphore (music_wakeup);
+    music_wakeup = NULL;
+  }
+
   if (musmutex)
   {
     SDL_DestroyMutex (musmutex);
@@ -985,6 +1656,9 @@ void I_InitMusic(void)
   for (i = 0; music_players[i]; i++)
     music_player_was_init[i] = music_players[i]->init (snd_samplerate);
 
+  if (!dumping_sound)
+    I_StartMusicRender ();
+
   I_AtExit(I_ShutdownMusic, true, "I_ShutdownMusic", exit_priority_normal);
 }
 
@@ -1006,11 +1680,7 @@ void I_ResetMusicVolume(void)
   Mix_VolumeMusic(music_volume * 8);
 
   if (music_handle)
-  {
-    SDL_LockMutex(musmutex);
-    music_players[current_player]->setvolume(music_volume);
-    SDL_UnlockMutex(musmutex);
-  }
+    I_QueueMusicCommand(music_cmd_volume, music_volume);
 }
 
 void I_PlaySong(int handle, int looping)
@@ -1156,10 +1826,8 @@ static void PlaySong(int handle, int looping)
 {
   if (music_handle)
   {
-    SDL_LockMutex (musmutex);
-    music_players[current_player]->play (music_handle, looping);
-    music_players[current_player]->setvolume (music_volume);
-    SDL_UnlockMutex (musmutex);
+    I_QueueMusicCommand (music_cmd_play, looping);
+    I_QueueMusicCommand (music_cmd_volume, music_volume);
   }
 }
 
@@ -1168,19 +1836,17 @@ static void PauseSong (int handle)
   if (!music_handle)
     return;
 
-  SDL_LockMutex (musmutex);
   switch (dsda_IntConfig(dsda_config_mus_pause_opt))
   {
     case 0:
-      music_players[current_player]->stop ();
+      I_QueueMusicCommand (music_cmd_stop, 0);
       break;
     case 1:
-      music_players[current_player]->pause ();
+      I_QueueMusicCommand (music_cmd_pause, 0);
       break;
     default: // Default - let music continue
       break;
   }
-  SDL_UnlockMutex (musmutex);
 }
 
 static void ResumeSong (int handle)
@@ -1188,37 +1854,33 @@ static void ResumeSong (int handle)
   if (!music_handle)
     return;
 
-  SDL_LockMutex (musmutex);
   switch (dsda_IntConfig(dsda_config_mus_pause_opt))
   {
     case 0: // i'm not sure why we can guarantee looping=true here,
             // but that's what the old code did
-      music_players[current_player]->play (music_handle, 1);
+      I_QueueMusicCommand (music_cmd_play, 1);
       break;
     case 1:
-      music_players[current_player]->resume ();
+      I_QueueMusicCommand (music_cmd_resume, 0);
       break;
     default: // Default - music was never stopped
       break;
   }
-  SDL_UnlockMutex (musmutex);
 }
 
 static void StopSong(int handle)
 {
   if (music_handle)
-  {
-    SDL_LockMutex (musmutex);
-    music_players[current_player]->stop ();
-    SDL_UnlockMutex (musmutex);
-  }
+    I_QueueMusicCommand (music_cmd_stop, 0);
 }
 
 static void UnRegisterSong(int handle)
 {
   if (music_handle)
   {
-    SDL_LockMutex (musmutex);
+    // the renderer must let go of the song before it can be freed
+    I_QueueMusicCommand (music_cmd_release, 0);
+
     music_players[current_player]->unregistersong (music_handle);
     music_handle = NULL;
     if (mus2mid_conversion_data)
@@ -1226,7 +1888,6 @@ static void UnRegisterSong(int handle)
       Z_Free (mus2mid_conversion_data);
       mus2mid_conversion_data = NULL;
     }
-    SDL_UnlockMutex (musmutex);
   }
 }
 
@@ -1270,10 +1931,9 @@ static int RegisterSongEx (const void *data, size_t len, int try_mus2mid)
             const void *temp_handle = music_players[i]->registersong (data, len);
             if (temp_handle)
             {
-              SDL_LockMutex (musmutex);
               current_player = i;
               music_handle = temp_handle;
-              SDL_UnlockMutex (musmutex);
+              I_QueueMusicCommand (music_cmd_setsong, 0);
               lprintf(LO_DEBUG, "RegisterSongEx: Using player %s\n", music_players[i]->name ());
               return 1;
             }
@@ -1361,13 +2021,53 @@ static int RegisterSong (const void *data, size_t len)
 
 static void UpdateMusic (void *buff, unsigned nsamp)
 {
-  if (!music_handle)
+  static int flush_seq;
+  short *out = (short *) buff;
+  unsigned int read, avail;
+  int seq;
+
+  if (!music_render_ahead)
   {
-    memset (buff, 0, nsamp * 4);
+    SDL_LockMutex (musmutex);
+    if (render_handle)
+      music_players[render_player]->render (buff, nsamp);
+    else
+      memset (buff, 0, nsamp * 4);
+    SDL_UnlockMutex (musmutex);
     return;
   }
 
-  music_players[current_player]->render (buff, nsamp);
+  seq = SDL_AtomicGet (&music_flush_seq);
+  read = SDL_AtomicGet (&music_ring_read);
+  if (seq != flush_seq)
+  {
+    unsigned int pos = SDL_AtomicGet (&music_flush_pos);
+
+    flush_seq = seq;
+    if ((int) (pos - read) > 0)
+      read = pos;
+  }
+
+  avail = (unsigned int) SDL_AtomicGet (&music_ring_write) - read;
+
+  while (nsamp && avail)
+  {
+    unsigned int index = read & (MUSIC_RING_FRAMES - 1);
+    unsigned int count = MIN(MIN(nsamp, avail), MUSIC_RING_FRAMES - index);
+
+    memcpy (out, music_ring + index * 2, count * 4);
+    out += count * 2;
+    read += count;
+    avail -= count;
+    nsamp -= count;
+  }
+
+  // underrun: the renderer fell behind, or nothing is playing
+  if (nsamp)
+    memset (out, 0, nsamp * 4);
+
+  SDL_AtomicSet (&music_ring_read, read);
+  I_WakeMusicRender ();
 }
 
 void M_ChangeMIDIPlayer(void)
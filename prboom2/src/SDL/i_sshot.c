@@ -37,6 +37,7 @@
 #endif
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "SDL.h"
 
@@ -49,6 +50,7 @@
 #include "doomtype.h"
 #include "v_video.h"
 #include "i_video.h"
+#include "i_system.h"
 #include "z_zone.h"
 #include "lprintf.h"
 
@@ -70,34 +72,304 @@ void I_UpdateRenderSize(void)
   }
 }
 
+// Reads the current frame as RGB24 into *pixels, growing it as needed
+dboolean I_GrabScreenInto(unsigned char **pixels, int *pixels_size)
+{
+  int size;
+
+  I_UpdateRenderSize();
+
+  size = renderW * renderH * 3;
+  if (size <= 0)
+    return false;
+
+  if (!*pixels || size > *pixels_size)
+  {
+    *pixels_size = size;
+    *pixels = (unsigned char*)Z_Realloc(*pixels, size);
+  }
+
+  if (V_IsOpenGLMode())
+  {
+    unsigned char *gl_pixels = gld_ReadScreen();
+
+    if (!gl_pixels)
+      return false;
+
+    memcpy(*pixels, gl_pixels, size);
+  }
+  else
+  {
+    SDL_Rect screen = { 0, 0, renderW, renderH };
+    SDL_RenderReadPixels(sdl_renderer, &screen, SDL_PIXELFORMAT_RGB24, *pixels, renderW * 3);
+  }
+
+  return true;
+}
+
 //
-// I_ScreenShot // Modified to work with SDL2 resizeable window and fullscreen desktop - DTIED
+// Asynchronous screenshot writer
+//
+// The game thread only grabs the frame into one of a small ring of
+// preallocated buffers; encoding and writing happen on worker threads.
+// When every slot is in use the caller waits for one to free up, and
+// all pending shots are flushed at exit. Write failures are reported by
+// the worker as they happen. If no worker can be started, shots are
+// written synchronously from then on.
 //
 
-int I_ScreenShot(const char *fname)
+#define SCREENSHOT_SLOTS   4
+#define SCREENSHOT_WORKERS 2
+
+typedef enum
+{
+  shot_free,
+  shot_queued,
+  shot_writing,
+} shot_state_t;
+
+typedef struct
+{
+  unsigned char *pixels;
+  int pixels_size;
+  int width;
+  int height;
+  char *fname;
+  shot_state_t state;
+} shot_slot_t;
+
+static shot_slot_t shot_slots[SCREENSHOT_SLOTS];
+static int shot_head; // next slot to fill
+static int shot_tail; // next slot to write
+static int shot_pending;
+static dboolean shot_quit;
+static dboolean shot_sync; // no workers could be started
+
+static SDL_mutex *shot_mutex;
+static SDL_cond *shot_cond;
+static SDL_Thread *shot_threads[SCREENSHOT_WORKERS];
+
+static int I_WriteScreenShot(const shot_slot_t *slot)
 {
   int result = -1;
-  unsigned char *pixels = I_GrabScreen();
-  SDL_Surface *screenshot = NULL;
+  SDL_Surface *screenshot;
 
-  if (pixels)
-  {
-    screenshot = SDL_CreateRGBSurfaceFrom(pixels, renderW, renderH, 24,
-      renderW * 3, 0x000000ff, 0x0000ff00, 0x00ff0000, 0);
-  }
+  screenshot = SDL_CreateRGBSurfaceFrom(slot->pixels, slot->width, slot->height, 24,
+    slot->width * 3, 0x000000ff, 0x0000ff00, 0x00ff0000, 0);
 
   if (screenshot)
   {
 #ifdef HAVE_LIBSDL2_IMAGE
-    result = IMG_SavePNG(screenshot, fname);
+    result = IMG_SavePNG(screenshot, slot->fname);
 #else
-    result = SDL_SaveBMP(screenshot, fname);
+    result = SDL_SaveBMP(screenshot, slot->fname);
 #endif
     SDL_FreeSurface(screenshot);
   }
+
   return result;
 }
 
+static int I_ScreenShotWorker(void *unused)
+{
+  SDL_LockMutex(shot_mutex);
+
+  while (1)
+  {
+    shot_slot_t *slot;
+    int result;
+
+    while (!shot_quit && shot_slots[shot_tail].state != shot_queued)
+      SDL_CondWait(shot_cond, shot_mutex);
+
+    if (shot_slots[shot_tail].state != shot_queued)
+      break;
+
+    slot = &shot_slots[shot_tail];
+    slot->state = shot_writing;
+    shot_tail = (shot_tail + 1) % SCREENSHOT_SLOTS;
+
+    SDL_UnlockMutex(shot_mutex);
+
+    // The slot can't be reused until it is marked free below
+    result = I_WriteScreenShot(slot);
+    if (result != 0)
+      lprintf(LO_WARN, "I_ScreenShot: Error writing %s\n", slot->fname);
+
+    SDL_LockMutex(shot_mutex);
+
+    slot->state = shot_free;
+    --shot_pending;
+    SDL_CondBroadcast(shot_cond);
+  }
+
+  SDL_UnlockMutex(shot_mutex);
+
+  return 0;
+}
+
+static void I_ShutdownScreenShots(void)
+{
+  int i;
+
+  if (!shot_mutex)
+    return;
+
+  I_FlushScreenShots();
+
+  SDL_LockMutex(shot_mutex);
+  shot_quit = true;
+  SDL_CondBroadcast(shot_cond);
+  SDL_UnlockMutex(shot_mutex);
+
+  for (i = 0; i < SCREENSHOT_WORKERS; ++i)
+    if (shot_threads[i])
+    {
+      SDL_WaitThread(shot_threads[i], NULL);
+      shot_threads[i] = NULL;
+    }
+
+  SDL_DestroyCond(shot_cond);
+  SDL_DestroyMutex(shot_mutex);
+  shot_cond = NULL;
+  shot_mutex = NULL;
+
+  for (i = 0; i < SCREENSHOT_SLOTS; ++i)
+  {
+    Z_Free(shot_slots[i].pixels);
+    Z_Free(shot_slots[i].fname);
+  }
+  memset(shot_slots, 0, sizeof(shot_slots));
+}
+
+static dboolean I_InitScreenShots(void)
+{
+  int i;
+  int started;
+
+  if (shot_mutex)
+    return true;
+
+  if (shot_sync)
+    return false;
+
+  shot_mutex = SDL_CreateMutex();
+  shot_cond = SDL_CreateCond();
+
+  if (!shot_mutex || !shot_cond)
+  {
+    if (shot_cond)
+      SDL_DestroyCond(shot_cond);
+    if (shot_mutex)
+      SDL_DestroyMutex(shot_mutex);
+    shot_cond = NULL;
+    shot_mutex = NULL;
+    shot_sync = true;
+    return false;
+  }
+
+  shot_head = shot_tail = shot_pending = 0;
+  shot_quit = false;
+
+  started = 0;
+  for (i = 0; i < SCREENSHOT_WORKERS; ++i)
+  {
+    shot_threads[i] = SDL_CreateThread(I_ScreenShotWorker, "I_ScreenShotWorker", NULL);
+    if (shot_threads[i])
+      ++started;
+  }
+
+  if (started < SCREENSHOT_WORKERS)
+    lprintf(LO_WARN, "I_InitScreenShots: Unable to create worker thread: %s\n", SDL_GetError());
+
+  // Workers that did start keep the mutex and cond until shutdown joins them
+  if (!started)
+  {
+    SDL_DestroyCond(shot_cond);
+    SDL_DestroyMutex(shot_mutex);
+    shot_cond = NULL;
+    shot_mutex = NULL;
+    shot_sync = true;
+    return false;
+  }
+
+  I_AtExit(I_ShutdownScreenShots, true, "I_ShutdownScreenShots", exit_priority_normal);
+
+  return true;
+}
+
+//
+// I_FlushScreenShots
+// Blocks until every queued screenshot has been written
+//
+
+void I_FlushScreenShots(void)
+{
+  if (!shot_mutex)
+    return;
+
+  SDL_LockMutex(shot_mutex);
+  while (shot_pending)
+    SDL_CondWait(shot_cond, shot_mutex);
+  SDL_UnlockMutex(shot_mutex);
+}
+
+//
+// I_ScreenShot // Modified to work with SDL2 resizeable window and fullscreen desktop - DTIED
+//
+// Returns nonzero if this frame could not be written, or could not be
+// queued for writing. Queued shots report their own write errors.
+//
+
+int I_ScreenShot(const char *fname)
+{
+  shot_slot_t *slot;
+  int size;
+
+  if (!I_InitScreenShots())
+  {
+    // No worker threads available; write synchronously
+    shot_slot_t sync_slot = { 0 };
+    int result = -1;
+
+    sync_slot.pixels = I_GrabScreen();
+    sync_slot.width = renderW;
+    sync_slot.height = renderH;
+    sync_slot.fname = (char *) fname;
+
+    if (sync_slot.pixels)
+      result = I_WriteScreenShot(&sync_slot);
+
+    return result;
+  }
+
+  // Backpressure: wait for the next slot in the ring to be written
+  SDL_LockMutex(shot_mutex);
+  slot = &shot_slots[shot_head];
+  while (slot->state != shot_free)
+    SDL_CondWait(shot_cond, shot_mutex);
+  SDL_UnlockMutex(shot_mutex);
+
+  // The slot is ours until it is queued, so the zone calls stay on this thread
+  if (!I_GrabScreenInto(&slot->pixels, &slot->pixels_size))
+    return -1;
+
+  size = strlen(fname) + 1;
+  slot->fname = Z_Realloc(slot->fname, size);
+  memcpy(slot->fname, fname, size);
+  slot->width = renderW;
+  slot->height = renderH;
+
+  SDL_LockMutex(shot_mutex);
+  slot->state = shot_queued;
+  ++shot_pending;
+  shot_head = (shot_head + 1) % SCREENSHOT_SLOTS;
+  SDL_CondBroadcast(shot_cond);
+  SDL_UnlockMutex(shot_mutex);
+
+  return 0;
+}
+
 // NSM
 // returns current screen contents as RGB24 (raw)
 // returned pointer should be freed when done
@@ -109,7 +381,6 @@ unsigned char *I_GrabScreen(void)
 {
   static unsigned char *pixels = NULL;
   static int pixels_size = 0;
-  int size;
 
   I_UpdateRenderSize();
 
@@ -118,18 +389,7 @@ unsigned char *I_GrabScreen(void)
     return gld_ReadScreen();
   }
 
-  size = renderW * renderH * 3;
-  if (!pixels || size > pixels_size)
-  {
-    pixels_size = size;
-    pixels = (unsigned char*)Z_Realloc(pixels, size);
-  }
-
-  if (pixels && size)
-  {
-    SDL_Rect screen = { 0, 0, renderW, renderH };
-    SDL_RenderReadPixels(sdl_renderer, &screen, SDL_PIXELFORMAT_RGB24, pixels, renderW * 3);
-  }
+  I_GrabScreenInto(&pixels, &pixels_size);
 
   return pixels;
 }
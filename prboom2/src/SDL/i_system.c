@@ -184,6 +184,7 @@ void I_Read(int fd, void* vbuf, size_t sz)
       I_Error("I_Read: read failed: %s", rc ? strerror(errno) : "EOF");
     }
     sz -= rc; buf += rc;
+    dsda_CountBytesRead(rc);
   }
 }
 
@@ -1650,114 +1650,270 @@ static automap_style_t AM_wallStyle(int i)
   return ams_invisible;
 }
 
-static void AM_drawWalls(void)
+//
+// Lines are sorted into a coarse grid over the map when the level is set up,
+// so that only the lines near the part of the map in view are looked at.
+// Polyobject lines move around, so they are kept apart and always checked.
+//
+
+#define AM_GRID_SHIFT (MAPBITS + 9) // 512 units
+
+static fixed_t am_grid_x, am_grid_y;
+static int am_grid_width, am_grid_height;
+static int *am_grid_start;          // first entry of each cell in am_grid_lines
+static int *am_grid_lines;
+static int *am_poly_lines;
+static int am_poly_line_count;
+static int *am_line_frame;          // last frame each line was looked at
+static int am_grid_frame;
+
+static void AM_lineGridBox(int i, int *left, int *right, int *bottom, int *top)
+{
+  *left = ((lines[i].bbox[BOXLEFT] >> FRACTOMAPBITS) - am_grid_x) >> AM_GRID_SHIFT;
+  *right = ((lines[i].bbox[BOXRIGHT] >> FRACTOMAPBITS) - am_grid_x) >> AM_GRID_SHIFT;
+  *bottom = ((lines[i].bbox[BOXBOTTOM] >> FRACTOMAPBITS) - am_grid_y) >> AM_GRID_SHIFT;
+  *top = ((lines[i].bbox[BOXTOP] >> FRACTOMAPBITS) - am_grid_y) >> AM_GRID_SHIFT;
+}
+
+void AM_InitLineGrid(void)
+{
+  int i, j, x, y;
+  int left, right, bottom, top;
+  fixed_t max_gx, max_gy;
+  byte *poly_line;
+  int *cell_fill;
+
+  am_grid_start = NULL;
+  am_grid_lines = NULL;
+  am_poly_lines = NULL;
+  am_poly_line_count = 0;
+  am_grid_width = am_grid_height = 0;
+  am_line_frame = NULL;
+  am_grid_frame = 0;
+
+  if (!numlines)
+    return;
+
+  poly_line = Z_Calloc(numlines, sizeof(*poly_line));
+
+  for (i = 0; i < po_NumPolyobjs; i++)
+    for (j = 0; j < polyobjs[i].numsegs; j++)
+      if (polyobjs[i].segs[j]->linedef)
+      {
+        int line = polyobjs[i].segs[j]->linedef - lines;
+
+        if (!poly_line[line])
+        {
+          poly_line[line] = true;
+          am_poly_line_count++;
+        }
+      }
+
+  am_grid_x = am_grid_y = INT_MAX;
+  max_gx = max_gy = INT_MIN;
+
+  for (i = 0; i < numlines; i++)
+  {
+    am_grid_x = MIN(am_grid_x, lines[i].bbox[BOXLEFT] >> FRACTOMAPBITS);
+    am_grid_y = MIN(am_grid_y, lines[i].bbox[BOXBOTTOM] >> FRACTOMAPBITS);
+    max_gx = MAX(max_gx, lines[i].bbox[BOXRIGHT] >> FRACTOMAPBITS);
+    max_gy = MAX(max_gy, lines[i].bbox[BOXTOP] >> FRACTOMAPBITS);
+  }
+
+  am_grid_width = ((max_gx - am_grid_x) >> AM_GRID_SHIFT) + 1;
+  am_grid_height = ((max_gy - am_grid_y) >> AM_GRID_SHIFT) + 1;
+
+  // Count the lines in each cell, then fill them in
+  am_grid_start = Z_CallocLevel(am_grid_width * am_grid_height + 1, sizeof(*am_grid_start));
+
+  for (i = 0; i < numlines; i++)
+  {
+    if (poly_line[i])
+      continue;
+
+    AM_lineGridBox(i, &left, &right, &bottom, &top);
+
+    for (y = bottom; y <= top; y++)
+      for (x = left; x <= right; x++)
+        am_grid_start[y * am_grid_width + x + 1]++;
+  }
+
+  for (i = 0; i < am_grid_width * am_grid_height; i++)
+    am_grid_start[i + 1] += am_grid_start[i];
+
+  am_grid_lines = Z_MallocLevel(MAX(1, am_grid_start[am_grid_width * am_grid_height]) *
+                                sizeof(*am_grid_lines));
+  cell_fill = Z_Malloc(am_grid_width * am_grid_height * sizeof(*cell_fill));
+  memcpy(cell_fill, am_grid_start, am_grid_width * am_grid_height * sizeof(*cell_fill));
+
+  for (i = 0; i < numlines; i++)
+  {
+    if (poly_line[i])
+      continue;
+
+    AM_lineGridBox(i, &left, &right, &bottom, &top);
+
+    for (y = bottom; y <= top; y++)
+      for (x = left; x <= right; x++)
+        am_grid_lines[cell_fill[y * am_grid_width + x]++] = i;
+  }
+
+  if (am_poly_line_count)
+  {
+    am_poly_lines = Z_MallocLevel(am_poly_line_count * sizeof(*am_poly_lines));
+
+    for (i = 0, j = 0; i < numlines; i++)
+      if (poly_line[i])
+        am_poly_lines[j++] = i;
+  }
+
+  am_line_frame = Z_CallocLevel(numlines, sizeof(*am_line_frame));
+
+  Z_Free(cell_fill);
+  Z_Free(poly_line);
+}
+
+static void AM_drawWall(int i, int hide_locks)
 {
-  int i;
   automap_style_t automap_style;
   static mline_t l;
-  int hide_locks;
 
-  hide_locks = map_blinking_locks && (gametic & 16);
+  if (lines[i].bbox[BOXLEFT] >> FRACTOMAPBITS > am_frame.bbox[BOXRIGHT] ||
+    lines[i].bbox[BOXRIGHT] >> FRACTOMAPBITS < am_frame.bbox[BOXLEFT] ||
+    lines[i].bbox[BOXBOTTOM] >> FRACTOMAPBITS > am_frame.bbox[BOXTOP] ||
+    lines[i].bbox[BOXTOP] >> FRACTOMAPBITS < am_frame.bbox[BOXBOTTOM])
+  {
+    return;
+  }
 
-  // draw the unclipped visible portions of all lines
-  for (i=0;i<numlines;i++)
+  l.a.x = lines[i].v1->x >> FRACTOMAPBITS;
+  l.a.y = lines[i].v1->y >> FRACTOMAPBITS;
+  l.b.x = lines[i].v2->x >> FRACTOMAPBITS;
+  l.b.y = lines[i].v2->y >> FRACTOMAPBITS;
+
+  if (automap_rotate)
   {
-    if (lines[i].bbox[BOXLEFT] >> FRACTOMAPBITS > am_frame.bbox[BOXRIGHT] ||
-      lines[i].bbox[BOXRIGHT] >> FRACTOMAPBITS < am_frame.bbox[BOXLEFT] ||
-      lines[i].bbox[BOXBOTTOM] >> FRACTOMAPBITS > am_frame.bbox[BOXTOP] ||
-      lines[i].bbox[BOXTOP] >> FRACTOMAPBITS < am_frame.bbox[BOXBOTTOM])
-    {
-      continue;
-    }
+    AM_rotatePoint(&l.a);
+    AM_rotatePoint(&l.b);
+  }
+  else
+  {
+    AM_SetMPointFloatValue(&l.a);
+    AM_SetMPointFloatValue(&l.b);
+  }
 
-    l.a.x = lines[i].v1->x >> FRACTOMAPBITS;
-    l.a.y = lines[i].v1->y >> FRACTOMAPBITS;
-    l.b.x = lines[i].v2->x >> FRACTOMAPBITS;
-    l.b.y = lines[i].v2->y >> FRACTOMAPBITS;
+  automap_style = AM_wallStyle(i);
 
-    if (automap_rotate)
-    {
-      AM_rotatePoint(&l.a);
-      AM_rotatePoint(&l.b);
-    }
-    else
-    {
-      AM_SetMPointFloatValue(&l.a);
-      AM_SetMPointFloatValue(&l.b);
-    }
+  switch (automap_style)
+  {
+    case ams_invisible:
+      return;
 
-    automap_style = AM_wallStyle(i);
+    case ams_locked:
+      if (hide_locks)
+      {
+        AM_drawMline(&l, *mapcolor_grid_p);
+        return;
+      }
 
-    switch (automap_style)
-    {
-      case ams_invisible:
-        continue;
+      switch (dsda_DoorType(i))
+      {
+        case 0: // red
+          AM_drawMline(&l, (*mapcolor_rdor_p)? (*mapcolor_rdor_p) : (*mapcolor_cchg_p));
+          return;
+        case 1: // blue
+          AM_drawMline(&l, (*mapcolor_bdor_p)? (*mapcolor_bdor_p) : (*mapcolor_cchg_p));
+          return;
+        case 2: // yellow
+          AM_drawMline(&l, (*mapcolor_ydor_p)? (*mapcolor_ydor_p) : (*mapcolor_cchg_p));
+          return;
+        default:
+          AM_drawMline(&l, (*mapcolor_clsd_p)? (*mapcolor_clsd_p) : (*mapcolor_cchg_p));
+          return;
+      }
 
-      case ams_locked:
-        if (hide_locks)
-        {
-          AM_drawMline(&l, *mapcolor_grid_p);
-          continue;
-        }
+    case ams_exit:
+      AM_drawMline(&l, (*mapcolor_exit_p));
+      return;
 
-        switch (dsda_DoorType(i))
-        {
-          case 0: // red
-            AM_drawMline(&l, (*mapcolor_rdor_p)? (*mapcolor_rdor_p) : (*mapcolor_cchg_p));
-            continue;
-          case 1: // blue
-            AM_drawMline(&l, (*mapcolor_bdor_p)? (*mapcolor_bdor_p) : (*mapcolor_cchg_p));
-            continue;
-          case 2: // yellow
-            AM_drawMline(&l, (*mapcolor_ydor_p)? (*mapcolor_ydor_p) : (*mapcolor_cchg_p));
-            continue;
-          default:
-            AM_drawMline(&l, (*mapcolor_clsd_p)? (*mapcolor_clsd_p) : (*mapcolor_cchg_p));
-            continue;
-        }
+    case ams_one_sided:
+      AM_drawMline(&l, (*mapcolor_wall_p));
+      return;
 
-      case ams_exit:
-        AM_drawMline(&l, (*mapcolor_exit_p));
-        continue;
+    case ams_secret:
+    case ams_unseen_secret:
+      AM_drawMline(&l, (*mapcolor_secr_p));
+      return;
 
-      case ams_one_sided:
-        AM_drawMline(&l, (*mapcolor_wall_p));
-        continue;
+    case ams_revealed_secret:
+      AM_drawMline(&l, (*mapcolor_revsecr_p));
+      return;
 
-      case ams_secret:
-      case ams_unseen_secret:
-        AM_drawMline(&l, (*mapcolor_secr_p));
-        continue;
+    case ams_teleport:
+      AM_drawMline(&l, (*mapcolor_tele_p));
+      return;
 
-      case ams_revealed_secret:
-        AM_drawMline(&l, (*mapcolor_revsecr_p));
-        continue;
+    case ams_closed_door:
+      AM_drawMline(&l, (*mapcolor_clsd_p));
+      return;
 
-      case ams_teleport:
-        AM_drawMline(&l, (*mapcolor_tele_p));
-        continue;
+    case ams_floor_diff:
+      AM_drawMline(&l, (*mapcolor_fchg_p));
+      return;
 
-      case ams_closed_door:
-        AM_drawMline(&l, (*mapcolor_clsd_p));
-        continue;
+    case ams_ceiling_diff:
+      AM_drawMline(&l, (*mapcolor_cchg_p));
+      return;
 
-      case ams_floor_diff:
-        AM_drawMline(&l, (*mapcolor_fchg_p));
-        continue;
+    case ams_two_sided:
+      AM_drawMline(&l, (*mapcolor_flat_p));
+      return;
 
-      case ams_ceiling_diff:
-        AM_drawMline(&l, (*mapcolor_cchg_p));
-        continue;
+    case ams_unseen:
+      AM_drawMline(&l, (*mapcolor_unsn_p));
+      return;
+  }
+}
 
-      case ams_two_sided:
-        AM_drawMline(&l, (*mapcolor_flat_p));
-        continue;
+static void AM_drawWalls(void)
+{
+  int i, x, y;
+  int left, right, bottom, top;
+  int hide_locks;
 
-      case ams_unseen:
-        AM_drawMline(&l, (*mapcolor_unsn_p));
-        continue;
-    }
+  hide_locks = map_blinking_locks && (gametic & 16);
+
+  // draw the unclipped visible portions of all lines
+  if (am_grid_width)
+  {
+    // Lines spanning several cells are only drawn once
+    am_grid_frame++;
+
+    left = MAX(0, (am_frame.bbox[BOXLEFT] - am_grid_x) >> AM_GRID_SHIFT);
+    right = MIN(am_grid_width - 1, (am_frame.bbox[BOXRIGHT] - am_grid_x) >> AM_GRID_SHIFT);
+    bottom = MAX(0, (am_frame.bbox[BOXBOTTOM] - am_grid_y) >> AM_GRID_SHIFT);
+    top = MIN(am_grid_height - 1, (am_frame.bbox[BOXTOP] - am_grid_y) >> AM_GRID_SHIFT);
+
+    for (y = bottom; y <= top; y++)
+      for (x = left; x <= right; x++)
+      {
+        int cell = y * am_grid_width + x;
+
+        for (i = am_grid_start[cell]; i < am_grid_start[cell + 1]; i++)
+        {
+          int line = am_grid_lines[i];
+
+          if (am_line_frame[line] == am_grid_frame)
+            continue;
+
+          am_line_frame[line] = am_grid_frame;
+          AM_drawWall(line, hide_locks);
+        }
+      }
   }
+
+  for (i = 0; i < am_poly_line_count; i++)
+    AM_drawWall(am_poly_lines[i], hide_locks);
 }
 
 //
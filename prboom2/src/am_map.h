@@ -76,6 +76,9 @@ void AM_Stop (void);
 
 void AM_Start(dboolean full_automap);
 
+// Called by P_SetupLevel once the lines and polyobjects are in place.
+void AM_InitLineGrid(void);
+
 //jff 4/16/98 make externally available
 
 void AM_clearMarks(void);
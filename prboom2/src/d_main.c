@@ -82,6 +82,7 @@
 #include "lprintf.h"  // jff 08/03/98 - declaration of lprintf
 #include "am_map.h"
 #include "e6y.h"
+#include "gl_struct.h"
 
 #include "dsda/args.h"
 #include "dsda/configuration.h"
@@ -1557,6 +1558,9 @@ static void D_DoomMainSetup(void)
     I_SafeExit(0);
   }
 
+  if (dsda_Flag(dsda_arg_clipper_replay))
+    I_SafeExit(gld_clipper_Replay(dsda_Arg(dsda_arg_clipper_replay)->value.v_string) ? 0 : 1);
+
   // figgi 09/18/00-- added switch to force classic bsp nodes
   if (dsda_Flag(dsda_arg_forceoldbsp))
     forceOldBsp = true;
@@ -1705,7 +1709,9 @@ static void D_DoomMainSetup(void)
 
   //jff 9/3/98 use logical output routine
   lprintf(LO_DEBUG, "W_Init: Init WADfiles.\n");
+  dsda_BeginTimedPhase("W_Init");
   W_Init(); // CPhipps - handling of wadfiles init changed
+  dsda_EndTimedPhase();
 
   if (hexen)
   {
@@ -1829,7 +1835,9 @@ static void D_DoomMainSetup(void)
 
   //jff 9/3/98 use logical output routine
   lprintf(LO_DEBUG, "R_Init: Init DOOM refresh daemon - ");
+  dsda_BeginTimedPhase("R_Init");
   R_Init();
+  dsda_EndTimedPhase();
 
   dsda_LoadMapInfo();
 
@@ -1905,7 +1913,9 @@ static void D_DoomMainSetup(void)
 
 void D_DoomMain(void)
 {
+  dsda_BeginTimedPhase("D_DoomMainSetup");
   D_DoomMainSetup(); // CPhipps - setup out of main execution stack
+  dsda_EndTimedPhase();
 
   D_DoomLoop ();  // never returns
 }
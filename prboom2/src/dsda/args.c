@@ -318,6 +318,26 @@ static arg_config_t arg_config[dsda_arg_count] = {
     "writes level stats to levelstat.txt",
     arg_null,
   },
+  [dsda_arg_timeline] = {
+    "-timeline", NULL, NULL,
+    "writes a timeline of startup and level loading to the log",
+    arg_null,
+  },
+  [dsda_arg_timeline_file] = {
+    "-timeline_file", NULL, NULL,
+    "appends the startup and level loading timeline to the given file",
+    arg_string,
+  },
+  [dsda_arg_clipper_dump] = {
+    "-clipperdump", NULL, NULL,
+    "records the OpenGL clipper calls of every frame to the given file",
+    arg_string,
+  },
+  [dsda_arg_clipper_replay] = {
+    "-clipperreplay", NULL, NULL,
+    "times a -clipperdump recording against the clipper and exits",
+    arg_string,
+  },
   [dsda_arg_export_text_file] = {
     "-export_text_file", NULL, NULL,
     "export a dsda-format text file template",
@@ -74,6 +74,10 @@ typedef enum {
   dsda_arg_update,
   dsda_arg_analysis,
   dsda_arg_levelstat,
+  dsda_arg_timeline,
+  dsda_arg_timeline_file,
+  dsda_arg_clipper_dump,
+  dsda_arg_clipper_replay,
   dsda_arg_export_text_file,
   dsda_arg_export_ghost,
   dsda_arg_import_ghost,
@@ -618,6 +618,14 @@ dsda_config_t dsda_config[dsda_config_count] = {
     "gl_usevbo", dsda_config_gl_usevbo,
     CONF_BOOL(1), NULL, NOT_STRICT
   },
+  [dsda_config_gl_hires_cache] = {
+    "gl_hires_cache", dsda_config_gl_hires_cache,
+    CONF_BOOL(0)
+  },
+  [dsda_config_gl_hires_cache_size] = { // megabytes
+    "gl_hires_cache_size", dsda_config_gl_hires_cache_size,
+    dsda_config_int, 16, 65536, { 1024 }
+  },
   [dsda_config_use_mouse] = {
     "use_mouse", dsda_config_use_mouse,
     CONF_BOOL(1), NULL, NOT_STRICT, I_InitMouse
@@ -754,6 +762,10 @@ dsda_config_t dsda_config[dsda_config_count] = {
     "mus_opl_gain", dsda_config_mus_opl_gain,
     dsda_config_int, 0, 1000, { 50 }
   },
+  [dsda_config_mus_opl_cache] = {
+    "mus_opl_cache", dsda_config_mus_opl_cache,
+    CONF_BOOL(0)
+  },
   [dsda_config_mus_portmidi_reset_type] = {
     "mus_portmidi_reset_type", dsda_config_mus_portmidi_reset_type,
     CONF_STRING("gm") // none, gs, gm, gm2, xg
@@ -780,7 +792,7 @@ dsda_config_t dsda_config[dsda_config_count] = {
   },
   [dsda_config_cap_videocommand] = {
     "cap_videocommand", dsda_config_cap_videocommand,
-    CONF_STRING("ffmpeg -f rawvideo -pix_fmt rgb24 -r %r -s %wx%h -i - -c:v libx264 -y temp_v.nut")
+    CONF_STRING("ffmpeg -f rawvideo -pix_fmt %p -r %r -s %wx%h -i - -c:v libx264 -y temp_v.nut")
   },
   [dsda_config_cap_muxcommand] = {
     "cap_muxcommand", dsda_config_cap_muxcommand,
@@ -806,6 +818,10 @@ dsda_config_t dsda_config[dsda_config_count] = {
     "cap_fps", dsda_config_cap_fps,
     dsda_config_int, 16, 300, { 60 }
   },
+  [dsda_config_cap_yuv420] = {
+    "cap_yuv420", dsda_config_cap_yuv420,
+    CONF_BOOL(0)
+  },
   [dsda_config_hudadd_crosshair_color] = {
     "hudadd_crosshair_color", dsda_config_hudadd_crosshair_color,
     CONF_CR(3)
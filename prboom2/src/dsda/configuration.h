@@ -125,6 +125,8 @@ typedef enum {
   dsda_config_gl_lightmode,
   dsda_config_gl_health_bar,
   dsda_config_gl_usevbo,
+  dsda_config_gl_hires_cache,
+  dsda_config_gl_hires_cache_size,
   dsda_config_use_mouse,
   dsda_config_mouse_sensitivity_horiz,
   dsda_config_mouse_sensitivity_vert,
@@ -159,6 +161,7 @@ typedef enum {
   dsda_config_mus_fluidsynth_reverb,
   dsda_config_mus_fluidsynth_gain,
   dsda_config_mus_opl_gain,
+  dsda_config_mus_opl_cache,
   dsda_config_mus_portmidi_reset_type,
   dsda_config_mus_portmidi_reset_delay,
   dsda_config_mus_portmidi_filter_sysex,
@@ -172,6 +175,7 @@ typedef enum {
   dsda_config_cap_remove_tempfiles,
   dsda_config_cap_wipescreen,
   dsda_config_cap_fps,
+  dsda_config_cap_yuv420,
   dsda_config_hudadd_crosshair_color,
   dsda_config_hudadd_crosshair_target_color,
   dsda_config_hud_displayed,
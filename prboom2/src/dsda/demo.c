@@ -32,6 +32,7 @@
 #include "dsda/args.h"
 #include "dsda/configuration.h"
 #include "dsda/data_organizer.h"
+#include "dsda/demo_stream.h"
 #include "dsda/excmd.h"
 #include "dsda/exdemo.h"
 #include "dsda/features.h"
@@ -44,6 +45,9 @@
 
 #define INITIAL_DEMO_BUFFER_SIZE 0x20000
 
+// How often the recording is mirrored to disk
+#define DEMO_STREAM_FLUSH_TICS 35
+
 static char* dsda_demo_name_base;
 static byte* dsda_demo_write_buffer;
 static byte* dsda_demo_write_buffer_p;
@@ -51,6 +55,25 @@ static int dsda_demo_write_buffer_length;
 static int dsda_extra_demo_header_data_offset;
 static int largest_real_offset;
 static int demo_tics;
+
+// The recording buffer is also a journal that in-memory key frames point
+//   into, rather than each carrying a copy of everything recorded so far.
+// The buffer is only overwritten when recording resumes from an earlier
+//   point, so a reference holds until something is written below its end.
+// Such writes are kept as truncations, and a reference is stale if one
+//   made after it went below its end. Only the earliest truncation matters
+//   for any reference, so the list is kept with rising offsets.
+typedef struct {
+  unsigned int serial;
+  int offset;
+} demo_truncation_t;
+
+static demo_truncation_t* journal_truncations;
+static int journal_truncation_count;
+static int journal_truncation_capacity;
+static unsigned int journal_serial;
+static int journal_reference_end;
+
 static int compatibility_level_unspecified;
 
 #define DSDA_DEMO_VERSION 2
@@ -174,6 +197,53 @@ void dsda_EvaluateBytesPerTic(void) {
   if (dsda_ExCmdDemo()) bytes_per_tic++;
 }
 
+static void dsda_TruncateDemoJournal(int offset) {
+  if (offset >= journal_reference_end) return;
+
+  // Key frames that must outlive this take their copy while it's intact
+  dsda_DetachKeyFramesFromJournal(offset);
+
+  while (
+    journal_truncation_count &&
+    journal_truncations[journal_truncation_count - 1].offset >= offset
+  )
+    --journal_truncation_count;
+
+  if (journal_truncation_count == journal_truncation_capacity) {
+    journal_truncation_capacity = journal_truncation_capacity ? journal_truncation_capacity * 2 : 16;
+    journal_truncations =
+      Z_Realloc(journal_truncations, journal_truncation_capacity * sizeof(*journal_truncations));
+  }
+
+  journal_truncations[journal_truncation_count].serial = ++journal_serial;
+  journal_truncations[journal_truncation_count].offset = offset;
+  ++journal_truncation_count;
+
+  journal_reference_end = offset;
+}
+
+static dboolean dsda_DemoJournalIntact(unsigned int serial, int offset) {
+  int i;
+
+  for (i = journal_truncation_count; i > 0; --i)
+    if (journal_truncations[i - 1].serial <= serial)
+      break;
+
+  return i == journal_truncation_count || journal_truncations[i].offset >= offset;
+}
+
+// The extra header data is rewritten in place when a demo is exported,
+//   so references keep their own copy of it.
+static int dsda_JournalHeaderSize(int offset) {
+  int size;
+
+  if (!dsda_demo_version) return 0;
+
+  size = dsda_demo_header_data_size[dsda_demo_version];
+
+  return offset >= dsda_extra_demo_header_data_offset + size ? size : 0;
+}
+
 static void dsda_EnsureDemoBufferSpace(size_t length) {
   int offset;
 
@@ -263,6 +333,8 @@ void dsda_InitDemoRecording(void) {
 
   dsda_ForgetAutoKeyFrames();
 
+  dsda_TruncateDemoJournal(0);
+
   dsda_demo_write_buffer = Z_Malloc(INITIAL_DEMO_BUFFER_SIZE);
   if (dsda_demo_write_buffer == NULL)
     I_Error("dsda_InitDemo: unable to initialize demo buffer!");
@@ -272,6 +344,20 @@ void dsda_InitDemoRecording(void) {
   dsda_demo_write_buffer_length = INITIAL_DEMO_BUFFER_SIZE;
 
   demo_tics = 0;
+
+  if (dsda_demo_name_base) {
+    unsigned int counter = 2;
+    dsda_string_t base_name;
+    char* stream_name;
+
+    dsda_StringPrintF(&base_name, "%s.partial", dsda_demo_name_base);
+    stream_name = dsda_GenerateDemoName(&counter, base_name.string);
+
+    dsda_OpenDemoStream(stream_name);
+
+    Z_Free(stream_name);
+    dsda_FreeString(&base_name);
+  }
 }
 
 static void dsda_SetDemoBufferOffset(int offset) {
@@ -292,6 +378,8 @@ static void dsda_SetDemoBufferOffset(int offset) {
 }
 
 void dsda_WriteToDemo(const void* buffer, size_t length) {
+  dsda_TruncateDemoJournal(dsda_DemoBufferOffset());
+  dsda_DemoStreamChanged(dsda_DemoBufferOffset());
   dsda_EnsureDemoBufferSpace(length);
 
   memcpy(dsda_demo_write_buffer_p, buffer, length);
@@ -308,9 +396,14 @@ void dsda_WriteQueueToDemo(const void* buffer, size_t length) {
   dsda_SetDemoBufferOffset(old_offset);
 }
 
+static void dsda_FlushDemoRecording(void);
+
 void dsda_WriteTicToDemo(const void* buffer, size_t length) {
   dsda_WriteToDemo(buffer, length);
   ++demo_tics;
+
+  if (demo_tics % DEMO_STREAM_FLUSH_TICS == 0)
+    dsda_FlushDemoRecording();
 }
 
 static void dsda_WriteIntToHeader(byte** p, int value) {
@@ -354,6 +447,25 @@ static void dsda_SetExtraDemoHeaderFlag(byte flag) {
   header_p = dsda_demo_write_buffer + dsda_extra_demo_header_data_offset;
   header_p += 8; // skip other fields
   *header_p |= flag;
+
+  dsda_DemoStreamChanged(header_p - dsda_demo_write_buffer);
+}
+
+// Mirror the recording so far to disk, as if it ended here
+static void dsda_FlushDemoRecording(void) {
+  byte header[8];
+  byte* header_p = header;
+  int length;
+
+  length = dsda_DemoBufferOffset();
+
+  if (dsda_demo_version) {
+    dsda_WriteIntToHeader(&header_p, length);
+    dsda_WriteIntToHeader(&header_p, demo_tics);
+  }
+
+  dsda_FlushDemoStream(dsda_demo_write_buffer, length,
+                       header, dsda_extra_demo_header_data_offset, header_p - header);
 }
 
 dboolean dsda_StartDemoSegment(const char* demo_name) {
@@ -370,7 +482,7 @@ dboolean dsda_StartDemoSegment(const char* demo_name) {
     dsda_key_frame_t key_frame;
 
     memset(&key_frame, 0, sizeof(key_frame));
-    dsda_StoreKeyFrame(&key_frame, false, false);
+    dsda_StoreKeyFrame(&key_frame, false, true);
     dsda_WriteToDemo(&key_frame.buffer_length, sizeof(key_frame.buffer_length));
     dsda_WriteToDemo(key_frame.buffer, key_frame.buffer_length);
     Z_Free(key_frame.buffer);
@@ -460,6 +572,9 @@ static int dsda_ExportDemoToFile(const char* demo_name) {
 }
 
 static void dsda_FreeDemoBuffer(void) {
+  dsda_TruncateDemoJournal(0);
+  dsda_CloseDemoStream();
+
   Z_Free(dsda_demo_write_buffer);
   dsda_demo_write_buffer = NULL;
   dsda_demo_write_buffer_p = NULL;
@@ -563,7 +678,10 @@ void dsda_ExportDemo(const char* name) {
 int dsda_DemoDataSize(byte complete) {
   int buffer_size;
 
-  buffer_size = complete ? dsda_DemoBufferOffset() : 0;
+  if (complete == DEMO_DATA_JOURNAL)
+    buffer_size = sizeof(journal_serial) + dsda_JournalHeaderSize(dsda_DemoBufferOffset());
+  else
+    buffer_size = complete ? dsda_DemoBufferOffset() : 0;
 
   return sizeof(buffer_size) + sizeof(demo_tics) + buffer_size;
 }
@@ -576,17 +694,92 @@ void dsda_StoreDemoData(byte complete) {
   P_SAVE_X(demo_write_buffer_offset);
   P_SAVE_X(demo_tics);
 
-  if (complete && demo_write_buffer_offset)
+  if (complete == DEMO_DATA_JOURNAL) {
+    P_SAVE_X(journal_serial);
+    P_SAVE_SIZE(dsda_demo_write_buffer + dsda_extra_demo_header_data_offset,
+                dsda_JournalHeaderSize(demo_write_buffer_offset));
+
+    if (demo_write_buffer_offset > journal_reference_end)
+      journal_reference_end = demo_write_buffer_offset;
+  }
+  else if (complete && demo_write_buffer_offset)
     P_SAVE_SIZE(dsda_demo_write_buffer, demo_write_buffer_offset);
 }
 
+// A journal reference, as stored by dsda_StoreDemoData, takes up size
+//   bytes; as a copy of the recording it refers to, it takes copy_size.
+int dsda_DemoJournalDataSize(const byte* source, int* copy_size) {
+  int demo_write_buffer_offset;
+
+  memcpy(&demo_write_buffer_offset, source, sizeof(demo_write_buffer_offset));
+
+  *copy_size = sizeof(demo_write_buffer_offset) + sizeof(demo_tics) + demo_write_buffer_offset;
+
+  return sizeof(demo_write_buffer_offset) + sizeof(demo_tics) + sizeof(journal_serial) +
+         dsda_JournalHeaderSize(demo_write_buffer_offset);
+}
+
+// Write out a journal reference as the copy that key frames on disk carry
+void dsda_CopyDemoJournalData(byte* dest, const byte* source) {
+  int demo_write_buffer_offset;
+  int header_size;
+  unsigned int serial;
+
+  memcpy(&demo_write_buffer_offset, source, sizeof(demo_write_buffer_offset));
+  memcpy(&serial, source + sizeof(demo_write_buffer_offset) + sizeof(demo_tics), sizeof(serial));
+
+  if (
+    demo_write_buffer_offset &&
+    (dsda_demo_write_buffer == NULL || !dsda_DemoJournalIntact(serial, demo_write_buffer_offset))
+  )
+    I_Error("dsda_CopyDemoJournalData: key frame refers to overwritten demo data.");
+
+  // The offset and tic count are the same in both forms
+  memcpy(dest, source, sizeof(demo_write_buffer_offset) + sizeof(demo_tics));
+  dest += sizeof(demo_write_buffer_offset) + sizeof(demo_tics);
+  source += sizeof(demo_write_buffer_offset) + sizeof(demo_tics) + sizeof(serial);
+
+  if (!demo_write_buffer_offset)
+    return;
+
+  memcpy(dest, dsda_demo_write_buffer, demo_write_buffer_offset);
+
+  header_size = dsda_JournalHeaderSize(demo_write_buffer_offset);
+  memcpy(dest + dsda_extra_demo_header_data_offset, source, header_size);
+}
+
 void dsda_RestoreDemoData(byte complete) {
   int demo_write_buffer_offset;
 
   P_LOAD_X(demo_write_buffer_offset);
   P_LOAD_X(demo_tics);
 
-  if (complete && demo_write_buffer_offset) {
+  if (complete == DEMO_DATA_JOURNAL) {
+    unsigned int serial;
+    int current_offset;
+
+    P_LOAD_X(serial);
+
+    if (!dsda_DemoJournalIntact(serial, demo_write_buffer_offset))
+      I_Error("dsda_RestoreDemoData: key frame refers to overwritten demo data.");
+
+    if (dsda_demo_write_buffer == NULL) {
+      save_p += dsda_JournalHeaderSize(demo_write_buffer_offset);
+      return;
+    }
+
+    P_LOAD_SIZE(dsda_demo_write_buffer + dsda_extra_demo_header_data_offset,
+                dsda_JournalHeaderSize(demo_write_buffer_offset));
+
+    // The recording up to the key frame is still in place,
+    //   so this may move forward as well as back
+    current_offset = dsda_DemoBufferOffset();
+    if (current_offset > largest_real_offset)
+      largest_real_offset = current_offset;
+
+    dsda_demo_write_buffer_p = dsda_demo_write_buffer + demo_write_buffer_offset;
+  }
+  else if (complete && demo_write_buffer_offset) {
     dsda_SetDemoBufferOffset(0);
     dsda_WriteToDemo(save_p, demo_write_buffer_offset);
     save_p += demo_write_buffer_offset;
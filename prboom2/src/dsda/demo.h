@@ -46,9 +46,16 @@ void dsda_ApplyDSDADemoFormat(byte** demo_p);
 void dsda_GetDemoCheckSum(dsda_cksum_t* cksum, byte* features, byte* demo, size_t demo_size);
 void dsda_GetDemoRecordingCheckSum(dsda_cksum_t* cksum);
 void dsda_EndDemoRecording(void);
+// What a key frame keeps of the demo recording buffer
+#define DEMO_DATA_POSITION 0 // the current position only
+#define DEMO_DATA_COPY     1 // a copy of everything recorded so far
+#define DEMO_DATA_JOURNAL  2 // a reference into the buffer, in memory only
+
 int dsda_DemoDataSize(byte complete);
 void dsda_StoreDemoData(byte complete);
 void dsda_RestoreDemoData(byte complete);
+int dsda_DemoJournalDataSize(const byte* source, int* copy_size);
+void dsda_CopyDemoJournalData(byte* dest, const byte* source);
 int dsda_DemoTicsCount(const byte* p, const byte* demobuffer, int demolength);
 const byte* dsda_DemoMarkerPosition(byte* buffer, size_t file_size);
 
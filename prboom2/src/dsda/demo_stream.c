@@ -0,0 +1,245 @@
+//
+// Copyright(C) 2023 by Ryan Krafnick
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	DSDA Demo Stream
+//
+//  While recording, the demo is mirrored to a file next to where it will
+//  be saved, so that a crash doesn't take the whole run with it. Each
+//  flush hands the part of the recording that changed since the last one
+//  to a writer thread, which writes it in place, closes the file with an
+//  end marker, and patches the header fields that are normally filled in
+//  on export. The file is always a playable demo up to the last flush.
+//  It is removed once the demo has been written out normally.
+//
+
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "SDL.h"
+
+#include "g_game.h"
+#include "lprintf.h"
+#include "m_file.h"
+#include "z_zone.h"
+
+#include "demo_stream.h"
+
+typedef struct {
+  byte* data;
+  int offset;
+  int length;
+  byte header[DEMO_STREAM_HEADER_SIZE];
+  int header_offset;
+  int header_length;
+} demo_stream_job_t;
+
+static FILE* stream_file;
+static char* stream_name;
+
+static SDL_Thread* stream_thread;
+static SDL_mutex* stream_mutex;
+static SDL_cond* stream_cond;
+static demo_stream_job_t stream_job;
+static dboolean stream_job_pending;
+static dboolean stream_quit;
+
+// How much of the recording the file has been sent,
+//   and the earliest byte that changed since
+static int stream_sent;
+static int stream_changed;
+
+static void dsda_TruncateStreamFile(int length) {
+#ifdef _WIN32
+  _chsize(_fileno(stream_file), length);
+#else
+  if (ftruncate(fileno(stream_file), length)) {}
+#endif
+}
+
+static void dsda_WriteStreamJob(demo_stream_job_t* job) {
+  byte end_marker = DEMOMARKER;
+
+  if (
+    fseek(stream_file, job->offset, SEEK_SET) ||
+    fwrite(job->data, 1, job->length - job->offset, stream_file) != job->length - job->offset ||
+    fwrite(&end_marker, 1, 1, stream_file) != 1
+  ) {
+    lprintf(LO_WARN, "dsda_WriteStreamJob: couldn't write %s\n", stream_name);
+    return;
+  }
+
+  fflush(stream_file);
+
+  // The recording may have been rewound
+  dsda_TruncateStreamFile(job->length + 1);
+
+  if (job->header_length) {
+    fseek(stream_file, job->header_offset, SEEK_SET);
+    fwrite(job->header, 1, job->header_length, stream_file);
+  }
+
+  fflush(stream_file);
+}
+
+static int dsda_DemoStreamThread(void* unused) {
+  SDL_LockMutex(stream_mutex);
+
+  while (1) {
+    demo_stream_job_t job;
+
+    while (!stream_job_pending && !stream_quit)
+      SDL_CondWait(stream_cond, stream_mutex);
+
+    if (stream_quit)
+      break;
+
+    job = stream_job;
+    stream_job.data = NULL;
+    stream_job_pending = false;
+    SDL_UnlockMutex(stream_mutex);
+
+    dsda_WriteStreamJob(&job);
+    free(job.data);
+
+    SDL_LockMutex(stream_mutex);
+  }
+
+  SDL_UnlockMutex(stream_mutex);
+
+  return 0;
+}
+
+void dsda_OpenDemoStream(const char* name) {
+  dsda_CloseDemoStream();
+
+  stream_file = M_OpenFile(name, "w+b");
+  if (!stream_file) {
+    lprintf(LO_WARN, "dsda_OpenDemoStream: couldn't open %s\n", name);
+    return;
+  }
+
+  stream_name = Z_Strdup(name);
+  stream_sent = 0;
+  stream_changed = 0;
+  stream_quit = false;
+  stream_job_pending = false;
+
+  stream_mutex = SDL_CreateMutex();
+  stream_cond = SDL_CreateCond();
+  if (stream_mutex && stream_cond)
+    stream_thread = SDL_CreateThread(dsda_DemoStreamThread, "dsda_DemoStreamThread", NULL);
+
+  if (!stream_thread)
+    lprintf(LO_WARN, "dsda_OpenDemoStream: writer thread failed, writing from game thread\n");
+
+  lprintf(LO_INFO, "Streaming demo to %s\n", name);
+}
+
+void dsda_CloseDemoStream(void) {
+  if (!stream_file)
+    return;
+
+  if (stream_thread) {
+    SDL_LockMutex(stream_mutex);
+    stream_quit = true;
+    SDL_CondSignal(stream_cond);
+    SDL_UnlockMutex(stream_mutex);
+
+    SDL_WaitThread(stream_thread, NULL);
+    stream_thread = NULL;
+  }
+
+  if (stream_cond) {
+    SDL_DestroyCond(stream_cond);
+    stream_cond = NULL;
+  }
+
+  if (stream_mutex) {
+    SDL_DestroyMutex(stream_mutex);
+    stream_mutex = NULL;
+  }
+
+  free(stream_job.data);
+  stream_job.data = NULL;
+  stream_job_pending = false;
+
+  fclose(stream_file);
+  stream_file = NULL;
+
+  M_remove(stream_name);
+  Z_Free(stream_name);
+  stream_name = NULL;
+}
+
+void dsda_DemoStreamChanged(int offset) {
+  if (offset < stream_changed)
+    stream_changed = offset;
+}
+
+void dsda_FlushDemoStream(const byte* buffer, int length,
+                          const byte* header, int header_offset, int header_length) {
+  demo_stream_job_t* job;
+  int offset;
+
+  if (!stream_file)
+    return;
+
+  offset = MIN(stream_changed, stream_sent);
+  offset = MIN(offset, length);
+
+  if (stream_thread) {
+    SDL_LockMutex(stream_mutex);
+
+    // The writer hasn't caught up, so fold this flush into the last one
+    if (stream_job_pending)
+      offset = MIN(offset, stream_job.offset);
+
+    free(stream_job.data);
+  }
+
+  job = &stream_job;
+  job->data = malloc(MAX(length - offset, 1));
+  if (!job->data)
+    I_Error("dsda_FlushDemoStream: out of memory!");
+
+  memcpy(job->data, buffer + offset, length - offset);
+  job->offset = offset;
+  job->length = length;
+  job->header_offset = header_offset;
+  job->header_length = MIN(header_length, DEMO_STREAM_HEADER_SIZE);
+  if (job->header_length)
+    memcpy(job->header, header, job->header_length);
+
+  stream_sent = length;
+  stream_changed = INT_MAX;
+
+  if (stream_thread) {
+    stream_job_pending = true;
+    SDL_CondSignal(stream_cond);
+    SDL_UnlockMutex(stream_mutex);
+  }
+  else {
+    dsda_WriteStreamJob(job);
+    free(job->data);
+    job->data = NULL;
+  }
+}
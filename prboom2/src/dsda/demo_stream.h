@@ -0,0 +1,31 @@
+//
+// Copyright(C) 2023 by Ryan Krafnick
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//	DSDA Demo Stream
+//
+
+#ifndef __DSDA_DEMO_STREAM__
+#define __DSDA_DEMO_STREAM__
+
+#include "doomtype.h"
+
+#define DEMO_STREAM_HEADER_SIZE 16
+
+void dsda_OpenDemoStream(const char* name);
+void dsda_CloseDemoStream(void);
+void dsda_DemoStreamChanged(int offset);
+void dsda_FlushDemoStream(const byte* buffer, int length,
+                          const byte* header, int header_offset, int header_length);
+
+#endif
@@ -16,6 +16,8 @@
 //
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "am_map.h"
 #include "doomstat.h"
@@ -31,6 +33,7 @@
 #include "dsda/hud_components.h"
 #include "dsda/render_stats.h"
 #include "dsda/settings.h"
+#include "dsda/time.h"
 #include "dsda/utility.h"
 
 #include "exhud.h"
@@ -368,6 +371,13 @@ static exhud_component_t* components;
 
 int dsda_show_render_stats;
 
+// Time spent updating and drawing each component, for the render stats
+static unsigned long long component_cost[exhud_component_count];
+static int cost_frames;
+static dsda_exhud_cost_t exhud_costs[exhud_component_count];
+static int exhud_cost_count;
+static int exhud_total_cost;
+
 int dsda_ExHudVerticalOffset(void) {
   if (container && container->status_bar)
     return g_st_height;
@@ -609,9 +619,12 @@ static void dsda_ResetOffsets(void) {
 }
 
 static void dsda_RefreshHUD(void) {
+  void dsda_InvalidateHudInputs(void);
+
   if (!dsda_HUDActive())
     return;
 
+  dsda_InvalidateHudInputs();
   dsda_ResetOffsets();
 
   if (dsda_show_render_stats)
@@ -642,6 +655,70 @@ void dsda_InitExHud(void) {
   dsda_RefreshHUD();
 }
 
+static void dsda_RunComponent(int id, void (*func)(void* data), void* data) {
+  if (!dsda_show_render_stats) {
+    func(data);
+    return;
+  }
+
+  dsda_StartTimer(dsda_timer_hud_component);
+  func(data);
+  component_cost[id] += dsda_ElapsedTimeNS(dsda_timer_hud_component);
+}
+
+static void dsda_ResetCosts(void) {
+  memset(component_cost, 0, sizeof(component_cost));
+  cost_frames = 0;
+  dsda_StartTimer(dsda_timer_hud_stats);
+}
+
+static int dsda_CompareCosts(const void* a, const void* b) {
+  return ((const dsda_exhud_cost_t*) b)->cost - ((const dsda_exhud_cost_t*) a)->cost;
+}
+
+static void dsda_UpdateCosts(void) {
+  int i;
+
+  if (!dsda_show_render_stats)
+    return;
+
+  ++cost_frames;
+
+  if (dsda_ElapsedTimeMS(dsda_timer_hud_stats) < 1000)
+    return;
+
+  exhud_cost_count = 0;
+  exhud_total_cost = 0;
+
+  for (i = 0; i < exhud_component_count; ++i)
+    if (component_cost[i]) {
+      exhud_costs[exhud_cost_count].name = components_template[i].name;
+      exhud_costs[exhud_cost_count].cost = component_cost[i] / cost_frames;
+      exhud_total_cost += exhud_costs[exhud_cost_count].cost;
+      ++exhud_cost_count;
+    }
+
+  qsort(exhud_costs, exhud_cost_count, sizeof(*exhud_costs), dsda_CompareCosts);
+
+  dsda_ResetCosts();
+}
+
+// Fills in the most expensive components over the last second,
+// and returns the total for the whole hud
+int dsda_ExHudCosts(dsda_exhud_cost_t* costs, int max) {
+  int i;
+
+  for (i = 0; i < max; ++i)
+    if (i < exhud_cost_count)
+      costs[i] = exhud_costs[i];
+    else {
+      costs[i].name = NULL;
+      costs[i].cost = 0;
+    }
+
+  return exhud_total_cost;
+}
+
 static void dsda_UpdateComponents(exhud_component_t* update_components) {
   int i;
 
@@ -651,7 +728,7 @@ static void dsda_UpdateComponents(exhud_component_t* update_components) {
       !update_components[i].not_level &&
       (!update_components[i].strict || !dsda_StrictMode())
     )
-      update_components[i].update(update_components[i].data);
+      dsda_RunComponent(i, update_components[i].update, update_components[i].data);
 }
 
 void dsda_UpdateExHud(void) {
@@ -677,7 +754,9 @@ static void dsda_DrawComponents(exhud_component_t* draw_components) {
       !draw_components[i].not_level &&
       (!draw_components[i].strict || !dsda_StrictMode())
     )
-      draw_components[i].draw(draw_components[i].data);
+      dsda_RunComponent(i, draw_components[i].draw, draw_components[i].data);
+
+  dsda_UpdateCosts();
 }
 
 void dsda_DrawExHud(void) {
@@ -719,6 +798,7 @@ void dsda_ToggleRenderStats(void) {
     dsda_TurnComponentOff(exhud_render_stats);
   else if (!components[exhud_render_stats].on && dsda_show_render_stats) {
     dsda_BeginRenderStats();
+    dsda_ResetCosts();
     dsda_TurnComponentOn(exhud_render_stats);
   }
 }
@@ -18,6 +18,11 @@
 #ifndef __DSDA_EXHUD__
 #define __DSDA_EXHUD__
 
+typedef struct {
+  const char* name;
+  int cost; // nanoseconds per frame
+} dsda_exhud_cost_t;
+
 void dsda_InitExHud(void);
 void dsda_UpdateExHud(void);
 void dsda_DrawExHud(void);
@@ -32,5 +37,6 @@ void dsda_RefreshMapCoordinates(void);
 void dsda_RefreshMapTotals(void);
 void dsda_RefreshMapTime(void);
 void dsda_RefreshMapTitle(void);
+int dsda_ExHudCosts(dsda_exhud_cost_t* costs, int max);
 
 #endif
@@ -126,6 +126,16 @@ void dsda_UpdateAmmoTextHC(void* data) {
   local = data;
 
   for (i = 0; i < component_config->count; ++i) {
+    player_t* player;
+    int type;
+
+    player = &players[displayplayer];
+    type = component_config->ammo_type[i];
+
+    if (!dsda_HudInputsChanged(&local->component[i].inputs, 2,
+                               player->ammo[type], player->maxammo[type]))
+      continue;
+
     dsda_UpdateComponentText(local->component[i].msg, sizeof(local->component[i].msg), i);
     dsda_RefreshHudText(&local->component[i]);
   }
@@ -66,8 +66,17 @@ void dsda_InitArmorTextHC(int x_offset, int y_offset, int vpt, int* args, int ar
 }
 
 void dsda_UpdateArmorTextHC(void* data) {
+  player_t* player;
+
   local = data;
 
+  player = &players[displayplayer];
+
+  if (!dsda_HudInputsChanged(&local->component.inputs, 2,
+                             hexen ? dsda_HexenArmor(player) : player->armorpoints[ARMOR_ARMOR],
+                             player->armortype))
+    return;
+
   dsda_UpdateComponentText(local->component.msg, sizeof(local->component.msg));
   dsda_RefreshHudText(&local->component);
 }
@@ -51,6 +51,13 @@ void dsda_InitAttemptsHC(int x_offset, int y_offset, int vpt, int* args, int arg
 void dsda_UpdateAttemptsHC(void* data) {
   local = data;
 
+  if (!demorecording)
+    return;
+
+  if (!dsda_HudInputsChanged(&local->component.inputs, 2,
+                             dsda_SessionAttempts(), dsda_DemoAttempts()))
+    return;
+
   dsda_UpdateComponentText(local->component.msg, sizeof(local->component.msg));
   dsda_RefreshHudText(&local->component);
 }
@@ -16,11 +16,14 @@
 //
 
 #include <math.h>
+#include <stdarg.h>
+
+#include "lprintf.h"
 
 #include "base.h"
 
-static char digit_lump[9];
-static const char* digit_lump_format;
+static int digit_lumpnum[10];
+static int input_generation = 1;
 
 int dsda_HudComponentY(int y_offset, int vpt, double ratio) {
   int dsda_ExHudVerticalOffset(void);
@@ -82,10 +85,21 @@ void dsda_InitPatchHC(dsda_patch_component_t* component, int x_offset, int y_off
   component->y = y;
   component->vpt = vpt;
 
-  if (raven)
-    digit_lump_format = "IN%.1d";
-  else
-    digit_lump_format = "STTNUM%.1d";
+  DO_ONCE
+    int i;
+    char digit_lump[9];
+    const char* digit_lump_format;
+
+    if (raven)
+      digit_lump_format = "IN%.1d";
+    else
+      digit_lump_format = "STTNUM%.1d";
+
+    for (i = 0; i < 10; ++i) {
+      snprintf(digit_lump, sizeof(digit_lump), digit_lump_format, i);
+      digit_lumpnum[i] = W_GetNumForName(digit_lump);
+    }
+  END_ONCE
 }
 
 int dsda_HexenArmor(player_t* player) {
@@ -100,8 +114,7 @@ static void dsda_DrawBigDigit(int x, int y, int cm, int vpt, int digit) {
   if (digit > 9 || digit < 0)
     return;
 
-  snprintf(digit_lump, sizeof(digit_lump), digit_lump_format, digit);
-  V_DrawNamePatch(x, y, FG, digit_lump, cm, vpt | VPT_TRANS);
+  V_DrawNumPatch(x, y, FG, digit_lumpnum[digit], cm, vpt | VPT_TRANS);
 }
 
 static int digit_mod[6] = { 1, 10, 100, 1000, 10000, 100000 };
@@ -147,8 +160,48 @@ void dsda_DrawBasicText(dsda_text_t* component) {
 void dsda_RefreshHudText(dsda_text_t* component) {
   const char* s;
 
+  // Keep the laid out text if nothing changed
+  if (!strcmp(component->text.l, component->msg))
+    return;
+
   HUlib_clearTextLine(&component->text);
 
   s = component->msg;
   while (*s) HUlib_addCharToTextLine(&component->text, *(s++));
 }
+
+// Components declare the values their text depends on, and only format it
+// again when one of them is different from the last update.
+dboolean dsda_HudInputsChanged(dsda_hud_inputs_t* inputs, int count, ...) {
+  int i;
+  int value;
+  dboolean changed;
+  va_list args;
+
+  if (count > DSDA_INPUT_LIMIT)
+    I_Error("dsda_HudInputsChanged: too many inputs (%d)", count);
+
+  changed = inputs->count != count || inputs->generation != input_generation;
+
+  va_start(args, count);
+  for (i = 0; i < count; ++i) {
+    value = va_arg(args, int);
+
+    if (inputs->value[i] != value) {
+      inputs->value[i] = value;
+      changed = true;
+    }
+  }
+  va_end(args);
+
+  inputs->count = count;
+  inputs->generation = input_generation;
+
+  return changed;
+}
+
+// Everything is formatted again after the hud is refreshed,
+// in case something it depends on has changed.
+void dsda_InvalidateHudInputs(void) {
+  ++input_generation;
+}
@@ -47,10 +47,19 @@
 #define DSDA_TEXT_SIZE 200
 #define DSDA_CHAR_HEIGHT 8
 #define DSDA_CHAR_WIDTH 6
+#define DSDA_INPUT_LIMIT 16
+
+// The values a component's text is formatted from, as of the last update
+typedef struct {
+  int value[DSDA_INPUT_LIMIT];
+  int count;
+  int generation;
+} dsda_hud_inputs_t;
 
 typedef struct {
   hu_textline_t text;
   char msg[DSDA_TEXT_SIZE];
+  dsda_hud_inputs_t inputs;
 } dsda_text_t;
 
 typedef struct {
@@ -67,5 +76,7 @@ fixed_t dsda_HexenArmor(player_t* player);
 void dsda_DrawBigNumber(int x, int y, int delta_x, int delta_y, int cm, int vpt, int count, int n);
 void dsda_DrawBasicText(dsda_text_t* component);
 void dsda_RefreshHudText(dsda_text_t* component);
+dboolean dsda_HudInputsChanged(dsda_hud_inputs_t* inputs, int count, ...);
+void dsda_InvalidateHudInputs(void);
 
 #endif
@@ -73,6 +73,11 @@ void dsda_InitCompositeTimeHC(int x_offset, int y_offset, int vpt, int* args, in
 void dsda_UpdateCompositeTimeHC(void* data) {
   local = data;
 
+  if (!dsda_HudInputsChanged(&local->component.inputs, 2,
+                             hexen ? players[consoleplayer].worldTimer : totalleveltimes,
+                             leveltime))
+    return;
+
   dsda_UpdateComponentText(local->component.msg, sizeof(local->component.msg));
   dsda_RefreshHudText(&local->component);
 }
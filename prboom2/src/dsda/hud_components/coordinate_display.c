@@ -180,6 +180,12 @@ void dsda_UpdateCoordinateDisplayHC(void* data) {
 
   mo = players[displayplayer].mo;
 
+  // Every line is worked out from these
+  if (!dsda_HudInputsChanged(&local->dsda_x_display.inputs, 8,
+                             mo->x, mo->y, mo->z, mo->angle, mo->momx, mo->momy,
+                             mo->x - mo->PrevX, mo->y - mo->PrevY))
+    return;
+
   dsda_WriteCoordinate(&local->dsda_x_display, mo->x, "X");
   dsda_WriteCoordinate(&local->dsda_y_display, mo->y, "Y");
   dsda_WriteCoordinate(&local->dsda_z_display, mo->z, "Z");
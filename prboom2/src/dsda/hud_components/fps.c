@@ -46,8 +46,13 @@ void dsda_InitFPSHC(int x_offset, int y_offset, int vpt, int* args, int arg_coun
 }
 
 void dsda_UpdateFPSHC(void* data) {
+  extern int dsda_render_stats_fps;
+
   local = data;
 
+  if (!dsda_HudInputsChanged(&local->component.inputs, 1, dsda_render_stats_fps))
+    return;
+
   dsda_UpdateComponentText(local->component.msg, sizeof(local->component.msg));
   dsda_RefreshHudText(&local->component);
 }
@@ -52,6 +52,10 @@ void dsda_InitHealthTextHC(int x_offset, int y_offset, int vpt, int* args, int a
 void dsda_UpdateHealthTextHC(void* data) {
   local = data;
 
+  if (!dsda_HudInputsChanged(&local->component.inputs, 4, players[displayplayer].health,
+                             hud_health_red, hud_health_yellow, hud_health_green))
+    return;
+
   dsda_UpdateComponentText(local->component.msg, sizeof(local->component.msg));
   dsda_RefreshHudText(&local->component);
 }
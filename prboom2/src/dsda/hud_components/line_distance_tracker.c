@@ -15,11 +15,13 @@
 //	DSDA Line Distance Tracker HUD Component
 //
 
+#include "dsda/tracker.h"
+
 #include "base.h"
 
 #include "line_distance_tracker.h"
 
-void dsda_LineDistanceTrackerHC(char* str, size_t max_size, int id) {
+void dsda_LineDistanceTrackerHC(dsda_text_t* component, int id) {
   line_t* line;
   mobj_t* mo;
   double distance;
@@ -27,17 +29,25 @@ void dsda_LineDistanceTrackerHC(char* str, size_t max_size, int id) {
 
   line = &lines[id];
   mo = players[displayplayer].mo;
+
+  if (!dsda_HudInputsChanged(&component->inputs, 9, dsda_tracker_line_distance, id,
+                             line->v1->x, line->v1->y, line->v2->x, line->v2->y,
+                             mo->x, mo->y, mo->radius))
+    return;
+
   radius = (double) mo->radius / FRACUNIT;
   distance = dsda_DistancePointToLine(line->v1->x, line->v1->y, line->v2->x, line->v2->y,
                                       mo->x, mo->y);
 
   snprintf(
-    str,
-    max_size,
+    component->msg,
+    sizeof(component->msg),
     "%sld %d: %.03f",
     distance < radius ? dsda_TextColor(dsda_tc_exhud_line_close) :
                         dsda_TextColor(dsda_tc_exhud_line_far),
     id,
     distance
   );
+
+  dsda_RefreshHudText(component);
 }
@@ -18,6 +18,6 @@
 #ifndef __DSDA_HUD_COMPONENT_LINE_DISTANCE_TRACKER__
 #define __DSDA_HUD_COMPONENT_LINE_DISTANCE_TRACKER__
 
-void dsda_LineDistanceTrackerHC(char* str, size_t max_size, int id);
+void dsda_LineDistanceTrackerHC(dsda_text_t* component, int id);
 
 #endif
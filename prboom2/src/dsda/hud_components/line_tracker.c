@@ -15,14 +15,20 @@
 //	DSDA Line Tracker HUD Component
 //
 
+#include "dsda/tracker.h"
+
 #include "base.h"
 
 #include "line_tracker.h"
 
-void dsda_LineTrackerHC(char* str, size_t max_size, int id) {
+void dsda_LineTrackerHC(dsda_text_t* component, int id) {
+  if (!dsda_HudInputsChanged(&component->inputs, 4, dsda_tracker_line, id,
+                             lines[id].special, lines[id].player_activations))
+    return;
+
   snprintf(
-    str,
-    max_size,
+    component->msg,
+    sizeof(component->msg),
     "%sl %d: %d %d",
     lines[id].special ? dsda_TextColor(dsda_tc_exhud_line_special) :
                         dsda_TextColor(dsda_tc_exhud_line_normal),
@@ -30,4 +36,6 @@ void dsda_LineTrackerHC(char* str, size_t max_size, int id) {
     lines[id].special,
     lines[id].player_activations
   );
+
+  dsda_RefreshHudText(component);
 }
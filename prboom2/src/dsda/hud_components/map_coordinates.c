@@ -49,6 +49,12 @@ void dsda_InitMapCoordinatesHC(int x_offset, int y_offset, int vpt, int* args, i
 void dsda_UpdateMapCoordinatesHC(void* data) {
   local = data;
 
+  if (!dsda_HudInputsChanged(&local->component.inputs, 3,
+                             players[displayplayer].mo->x >> FRACBITS,
+                             players[displayplayer].mo->y >> FRACBITS,
+                             players[displayplayer].mo->z >> FRACBITS))
+    return;
+
   dsda_UpdateComponentText(local->component.msg, sizeof(local->component.msg));
   dsda_RefreshHudText(&local->component);
 }
@@ -68,8 +68,18 @@ void dsda_InitMapTimeHC(int x_offset, int y_offset, int vpt, int* args, int arg_
 }
 
 void dsda_UpdateMapTimeHC(void* data) {
+  int total_time;
+
   local = data;
 
+  total_time = hexen ?
+               players[consoleplayer].worldTimer :
+               totalleveltimes + leveltime;
+
+  // Only whole seconds are shown
+  if (!dsda_HudInputsChanged(&local->component.inputs, 2, total_time / 35, leveltime / 35))
+    return;
+
   dsda_UpdateComponentText(local->component.msg, sizeof(local->component.msg));
   dsda_RefreshHudText(&local->component);
 }
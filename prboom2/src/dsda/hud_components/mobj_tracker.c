@@ -15,11 +15,13 @@
 //	DSDA Mobj Tracker HUD Component
 //
 
+#include "dsda/tracker.h"
+
 #include "base.h"
 
 #include "mobj_tracker.h"
 
-void dsda_MobjTrackerHC(char* str, size_t max_size, int id, mobj_t* mobj) {
+void dsda_MobjTrackerHC(dsda_text_t* component, int id, mobj_t* mobj) {
   int health;
 
   health = mobj->health;
@@ -27,12 +29,17 @@ void dsda_MobjTrackerHC(char* str, size_t max_size, int id, mobj_t* mobj) {
   if (mobj->thinker.function == P_RemoveThinkerDelayed)
     health = 0;
 
+  if (!dsda_HudInputsChanged(&component->inputs, 3, dsda_tracker_mobj, id, health))
+    return;
+
   snprintf(
-    str,
-    max_size,
+    component->msg,
+    sizeof(component->msg),
     "%sm %d: %d",
     health > 0 ? dsda_TextColor(dsda_tc_exhud_mobj_alive) :
                  dsda_TextColor(dsda_tc_exhud_mobj_dead),
     id, health
   );
+
+  dsda_RefreshHudText(component);
 }
@@ -20,6 +20,6 @@
 
 #include "p_mobj.h"
 
-void dsda_MobjTrackerHC(char* str, size_t max_size, int id, mobj_t* mobj);
+void dsda_MobjTrackerHC(dsda_text_t* component, int id, mobj_t* mobj);
 
 #endif
@@ -19,6 +19,7 @@
 
 #include "null.h"
 
-void dsda_NullHC(char* str, size_t max_size) {
-  str[0] = '\0';
+void dsda_NullHC(dsda_text_t* component) {
+  component->msg[0] = '\0';
+  dsda_RefreshHudText(component);
 }
@@ -18,6 +18,6 @@
 #ifndef __DSDA_HUD_COMPONENT_NULL__
 #define __DSDA_HUD_COMPONENT_NULL__
 
-void dsda_NullHC(char* str, size_t max_size);
+void dsda_NullHC(dsda_text_t* component);
 
 #endif
@@ -15,19 +15,26 @@
 //	DSDA Player Tracker HUD Component
 //
 
+#include "dsda/tracker.h"
+
 #include "base.h"
 
 #include "player_tracker.h"
 
-void dsda_PlayerTrackerHC(char* str, size_t max_size) {
+void dsda_PlayerTrackerHC(dsda_text_t* component) {
   extern int player_damage_last_tic;
 
+  if (!dsda_HudInputsChanged(&component->inputs, 2, dsda_tracker_player, player_damage_last_tic))
+    return;
+
   snprintf(
-    str,
-    max_size,
+    component->msg,
+    sizeof(component->msg),
     "%sp: %d",
     player_damage_last_tic > 0 ? dsda_TextColor(dsda_tc_exhud_player_damage)
                                : dsda_TextColor(dsda_tc_exhud_player_neutral),
     player_damage_last_tic
   );
+
+  dsda_RefreshHudText(component);
 }
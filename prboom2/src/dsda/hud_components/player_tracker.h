@@ -18,6 +18,6 @@
 #ifndef __DSDA_HUD_COMPONENT_PLAYER_TRACKER__
 #define __DSDA_HUD_COMPONENT_PLAYER_TRACKER__
 
-void dsda_PlayerTrackerHC(char* str, size_t max_size);
+void dsda_PlayerTrackerHC(dsda_text_t* component);
 
 #endif
@@ -60,8 +60,30 @@ void dsda_InitReadyAmmoTextHC(int x_offset, int y_offset, int vpt, int* args, in
 }
 
 void dsda_UpdateReadyAmmoTextHC(void* data) {
+  player_t* player;
+  dboolean changed;
+
   local = data;
 
+  player = &players[displayplayer];
+
+  if (hexen)
+    changed = dsda_HudInputsChanged(&local->component.inputs, 2, player->ammo[0], player->ammo[1]);
+  else {
+    ammotype_t ammo_type;
+
+    ammo_type = weaponinfo[player->readyweapon].ammo;
+
+    if (ammo_type == am_noammo)
+      changed = dsda_HudInputsChanged(&local->component.inputs, 1, ammo_type);
+    else
+      changed = dsda_HudInputsChanged(&local->component.inputs, 3, ammo_type,
+                                      player->ammo[ammo_type], player->maxammo[ammo_type]);
+  }
+
+  if (!changed)
+    return;
+
   dsda_UpdateComponentText(local->component.msg, sizeof(local->component.msg));
   dsda_RefreshHudText(&local->component);
 }
@@ -21,16 +21,20 @@
 
 #include "render_stats.h"
 
+#define COST_COUNT 3
+#define COST_LINE 2
+
 typedef struct {
-  dsda_text_t component[2];
+  dsda_text_t component[COST_LINE + 1 + COST_COUNT];
 } local_component_t;
 
 static local_component_t* local;
 
-static void dsda_UpdateCurrentComponentText(char* str, size_t max_size) {
-  extern dsda_render_stats_t dsda_render_stats;
-  extern int dsda_render_stats_fps;
+extern dsda_render_stats_t dsda_render_stats;
+extern dsda_render_stats_t dsda_render_stats_max;
+extern int dsda_render_stats_fps;
 
+static void dsda_UpdateCurrentComponentText(char* str, size_t max_size) {
   snprintf(
     str, max_size,
     "%sFPS %s%4d %sSEGS %s%4d %sPLANES %s%4d %sSPRITES %s%4d",
@@ -54,8 +58,6 @@ static void dsda_UpdateCurrentComponentText(char* str, size_t max_size) {
 }
 
 static void dsda_UpdateMaxComponentText(char* str, size_t max_size) {
-  extern dsda_render_stats_t dsda_render_stats_max;
-
   snprintf(
     str, max_size,
     "%sMAX      SEGS %s%4d %sPLANES %s%4d %sSPRITES %s%4d",
@@ -74,26 +76,81 @@ static void dsda_UpdateMaxComponentText(char* str, size_t max_size) {
   );
 }
 
+static void dsda_UpdateCostComponentText(dsda_text_t* component, int total) {
+  snprintf(
+    component->msg, sizeof(component->msg),
+    "%sHUD %s%7.1f US",
+    dsda_TextColor(dsda_tc_exhud_render_label),
+    total > 1000000 ? dsda_TextColor(dsda_tc_exhud_render_bad) :
+                      dsda_TextColor(dsda_tc_exhud_render_good),
+    (double) total / 1000
+  );
+}
+
+static void dsda_UpdateComponentCostText(dsda_text_t* component, dsda_exhud_cost_t* cost) {
+  if (cost->name)
+    snprintf(
+      component->msg, sizeof(component->msg),
+      "%s  %-18s %s%5.1f US",
+      dsda_TextColor(dsda_tc_exhud_render_label),
+      cost->name,
+      dsda_TextColor(dsda_tc_exhud_render_good),
+      (double) cost->cost / 1000
+    );
+  else
+    component->msg[0] = '\0';
+}
+
 void dsda_InitRenderStatsHC(int x_offset, int y_offset, int vpt, int* args, int arg_count, void** data) {
+  int i;
+
   *data = Z_Calloc(1, sizeof(local_component_t));
   local = *data;
 
-  dsda_InitTextHC(&local->component[0], x_offset, y_offset, vpt);
-  dsda_InitTextHC(&local->component[1], x_offset, y_offset + 8, vpt);
+  for (i = 0; i < COST_LINE + 1 + COST_COUNT; ++i)
+    dsda_InitTextHC(&local->component[i], x_offset, y_offset + i * 8, vpt);
 }
 
 void dsda_UpdateRenderStatsHC(void* data) {
+  int i;
+  int total;
+  dsda_exhud_cost_t costs[COST_COUNT];
+
   local = data;
 
-  dsda_UpdateCurrentComponentText(local->component[0].msg, sizeof(local->component[0].msg));
-  dsda_UpdateMaxComponentText(local->component[1].msg, sizeof(local->component[1].msg));
-  dsda_RefreshHudText(&local->component[0]);
-  dsda_RefreshHudText(&local->component[1]);
+  if (dsda_HudInputsChanged(&local->component[0].inputs, 4,
+                            dsda_render_stats_fps, dsda_render_stats.drawsegs,
+                            dsda_render_stats.visplanes, dsda_render_stats.vissprites)) {
+    dsda_UpdateCurrentComponentText(local->component[0].msg, sizeof(local->component[0].msg));
+    dsda_RefreshHudText(&local->component[0]);
+  }
+
+  if (dsda_HudInputsChanged(&local->component[1].inputs, 3,
+                            dsda_render_stats_max.drawsegs, dsda_render_stats_max.visplanes,
+                            dsda_render_stats_max.vissprites)) {
+    dsda_UpdateMaxComponentText(local->component[1].msg, sizeof(local->component[1].msg));
+    dsda_RefreshHudText(&local->component[1]);
+  }
+
+  // The breakdown is only published once a second, along with the total
+  total = dsda_ExHudCosts(costs, COST_COUNT);
+
+  if (dsda_HudInputsChanged(&local->component[COST_LINE].inputs, 1, total)) {
+    dsda_UpdateCostComponentText(&local->component[COST_LINE], total);
+    dsda_RefreshHudText(&local->component[COST_LINE]);
+
+    for (i = 0; i < COST_COUNT; ++i) {
+      dsda_UpdateComponentCostText(&local->component[COST_LINE + 1 + i], &costs[i]);
+      dsda_RefreshHudText(&local->component[COST_LINE + 1 + i]);
+    }
+  }
 }
 
 void dsda_DrawRenderStatsHC(void* data) {
+  int i;
+
   local = data;
 
-  dsda_DrawBasicText(&local->component[0]);
-  dsda_DrawBasicText(&local->component[1]);
+  for (i = 0; i < COST_LINE + 1 + COST_COUNT; ++i)
+    dsda_DrawBasicText(&local->component[i]);
 }
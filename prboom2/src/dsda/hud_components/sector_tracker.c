@@ -15,20 +15,26 @@
 //	DSDA Sector Tracker HUD Component
 //
 
+#include "dsda/tracker.h"
+
 #include "base.h"
 
 #include "sector_tracker.h"
 
-void dsda_SectorTrackerHC(char* str, size_t max_size, int id) {
+void dsda_SectorTrackerHC(dsda_text_t* component, int id) {
   dboolean active;
   int special;
 
   active = P_PlaneActive(&sectors[id]);
   special = sectors[id].special;
 
+  if (!dsda_HudInputsChanged(&component->inputs, 5, dsda_tracker_sector, id,
+                             special, active, sectors[id].floorheight >> FRACBITS))
+    return;
+
   snprintf(
-    str,
-    max_size,
+    component->msg,
+    sizeof(component->msg),
     "%ss %d: %d %d %d",
     active ? dsda_TextColor(dsda_tc_exhud_sector_active)
            : special ? dsda_TextColor(dsda_tc_exhud_sector_special)
@@ -36,4 +42,6 @@ void dsda_SectorTrackerHC(char* str, size_t max_size, int id) {
     id, special, active,
     sectors[id].floorheight >> FRACBITS
   );
+
+  dsda_RefreshHudText(component);
 }
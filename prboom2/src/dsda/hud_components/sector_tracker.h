@@ -18,6 +18,6 @@
 #ifndef __DSDA_HUD_COMPONENT_SECTOR_TRACKER__
 #define __DSDA_HUD_COMPONENT_SECTOR_TRACKER__
 
-void dsda_SectorTrackerHC(char* str, size_t max_size, int id);
+void dsda_SectorTrackerHC(dsda_text_t* component, int id);
 
 #endif
@@ -58,6 +58,9 @@ void dsda_InitSpeedTextHC(int x_offset, int y_offset, int vpt, int* args, int ar
 void dsda_UpdateSpeedTextHC(void* data) {
   local = data;
 
+  if (!dsda_HudInputsChanged(&local->component.inputs, 1, dsda_RealticClockRate()))
+    return;
+
   dsda_UpdateComponentText(local->component.msg, sizeof(local->component.msg));
   dsda_RefreshHudText(&local->component);
 }
@@ -29,36 +29,15 @@ typedef struct {
 
 static local_component_t* local;
 
-static void dsda_UpdateComponentText(char* str, size_t max_size) {
-  int i;
+static void dsda_UpdateComponentText(char* str, size_t max_size,
+                                     int fullkillcount, int max_kill_requirement,
+                                     int fullitemcount, int fullsecretcount) {
   size_t length;
-  int fullkillcount, fullitemcount, fullsecretcount;
   const char* killcolor;
   const char* itemcolor;
   const char* secretcolor;
-  int kill_percent_count;
-  int max_kill_requirement;
 
   length = 0;
-  fullkillcount = 0;
-  fullitemcount = 0;
-  fullsecretcount = 0;
-  kill_percent_count = 0;
-  max_kill_requirement = dsda_MaxKillRequirement();
-
-  for (i = 0; i < g_maxplayers; ++i) {
-    if (playeringame[i]) {
-      fullkillcount += players[i].killcount - players[i].maxkilldiscount;
-      fullitemcount += players[i].itemcount;
-      fullsecretcount += players[i].secretcount;
-      kill_percent_count += players[i].killcount;
-    }
-  }
-
-  if (respawnmonsters) {
-    fullkillcount = kill_percent_count;
-    max_kill_requirement = totalkills;
-  }
 
   killcolor = (fullkillcount >= max_kill_requirement ? dsda_TextColor(dsda_tc_exhud_totals_max) :
                                                        dsda_TextColor(dsda_tc_exhud_totals_value));
@@ -126,9 +105,42 @@ void dsda_InitStatTotalsHC(int x_offset, int y_offset, int vpt, int* args, int a
 }
 
 void dsda_UpdateStatTotalsHC(void* data) {
+  int i;
+  int fullkillcount, fullitemcount, fullsecretcount;
+  int kill_percent_count;
+  int max_kill_requirement;
+
   local = data;
 
-  dsda_UpdateComponentText(local->component.msg, sizeof(local->component.msg));
+  fullkillcount = 0;
+  fullitemcount = 0;
+  fullsecretcount = 0;
+  kill_percent_count = 0;
+  max_kill_requirement = dsda_MaxKillRequirement();
+
+  for (i = 0; i < g_maxplayers; ++i) {
+    if (playeringame[i]) {
+      fullkillcount += players[i].killcount - players[i].maxkilldiscount;
+      fullitemcount += players[i].itemcount;
+      fullsecretcount += players[i].secretcount;
+      kill_percent_count += players[i].killcount;
+    }
+  }
+
+  if (respawnmonsters) {
+    fullkillcount = kill_percent_count;
+    max_kill_requirement = totalkills;
+  }
+
+  if (!dsda_HudInputsChanged(&local->component.inputs, 7,
+                             fullkillcount, max_kill_requirement,
+                             fullitemcount, players[displayplayer].itemcount, totalitems,
+                             fullsecretcount, totalsecret))
+    return;
+
+  dsda_UpdateComponentText(local->component.msg, sizeof(local->component.msg),
+                           fullkillcount, max_kill_requirement,
+                           fullitemcount, fullsecretcount);
   dsda_RefreshHudText(&local->component);
 }
 
@@ -54,26 +54,24 @@ void dsda_UpdateTrackerHC(void* data) {
   for (i = 0; i < TRACKER_LIMIT; ++i) {
     switch (dsda_tracker[i].type) {
       case dsda_tracker_nothing:
-        dsda_NullHC(local->component[i].msg, sizeof(local->component[i].msg));
+        dsda_NullHC(&local->component[i]);
         break;
       case dsda_tracker_line:
-        dsda_LineTrackerHC(local->component[i].msg, sizeof(local->component[i].msg), dsda_tracker[i].id);
+        dsda_LineTrackerHC(&local->component[i], dsda_tracker[i].id);
         break;
       case dsda_tracker_line_distance:
-        dsda_LineDistanceTrackerHC(local->component[i].msg, sizeof(local->component[i].msg), dsda_tracker[i].id);
+        dsda_LineDistanceTrackerHC(&local->component[i], dsda_tracker[i].id);
         break;
       case dsda_tracker_sector:
-        dsda_SectorTrackerHC(local->component[i].msg, sizeof(local->component[i].msg), dsda_tracker[i].id);
+        dsda_SectorTrackerHC(&local->component[i], dsda_tracker[i].id);
         break;
       case dsda_tracker_mobj:
-        dsda_MobjTrackerHC(local->component[i].msg, sizeof(local->component[i].msg), dsda_tracker[i].id, dsda_tracker[i].mobj);
+        dsda_MobjTrackerHC(&local->component[i], dsda_tracker[i].id, dsda_tracker[i].mobj);
         break;
       case dsda_tracker_player:
-        dsda_PlayerTrackerHC(local->component[i].msg, sizeof(local->component[i].msg));
+        dsda_PlayerTrackerHC(&local->component[i]);
         break;
     }
-
-    dsda_RefreshHudText(&local->component[i]);
   }
 }
 
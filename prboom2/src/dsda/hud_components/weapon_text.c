@@ -86,8 +86,22 @@ void dsda_InitWeaponTextHC(int x_offset, int y_offset, int vpt, int* args, int a
 }
 
 void dsda_UpdateWeaponTextHC(void* data) {
+  int i;
+  int owned;
+  player_t* player;
+
   local = data;
 
+  player = &players[displayplayer];
+
+  for (i = 0, owned = 0; i < 9; ++i)
+    if (player->weaponowned[i])
+      owned |= 1 << i;
+
+  if (!dsda_HudInputsChanged(&local->component.inputs, 2,
+                             owned, player->powers[pw_strength] != 0))
+    return;
+
   dsda_UpdateComponentText(local->component.msg, sizeof(local->component.msg));
   dsda_RefreshHudText(&local->component);
 }
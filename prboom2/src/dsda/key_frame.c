@@ -34,6 +34,8 @@
 
 #include "heretic/sb_bar.h"
 
+#include "hexen/sv_save.h"
+
 #include "dsda.h"
 #include "dsda/args.h"
 #include "dsda/build.h"
@@ -161,6 +163,27 @@ void dsda_CopyKeyFrame(dsda_key_frame_t* dest, dsda_key_frame_t* source) {
   *dest = *source;
   dest->buffer = Z_Malloc(dest->buffer_length);
   memcpy(dest->buffer, source->buffer, dest->buffer_length);
+  dest->map_archives = SV_CopyMapArchiveRefs(source->map_archives);
+}
+
+static void dsda_FreeAutoKeyFrames(void) {
+  int i;
+
+  if (!auto_key_frames)
+    return;
+
+  for (i = 0; i < auto_kf_size; ++i) {
+    Z_Free(auto_key_frames[i].kf.buffer);
+    SV_ReleaseMapArchiveRefs(auto_key_frames[i].kf.map_archives);
+  }
+
+  Z_Free(auto_key_frames);
+  auto_key_frames = NULL;
+  last_auto_kf = NULL;
+
+  // These may point into the ring
+  dsda_ResetParentKF(&first_kf);
+  dsda_ResetParentKF(&quick_kf);
 }
 
 void dsda_InitKeyFrame(void) {
@@ -170,15 +193,12 @@ void dsda_InitKeyFrame(void) {
   dsda_auto_key_frame_depth = dsda_IntConfig(dsda_config_auto_key_frame_depth);
   dsda_auto_key_frame_timeout = dsda_IntConfig(dsda_config_auto_key_frame_timeout);
 
+  dsda_FreeAutoKeyFrames();
+
   auto_kf_size = autoKeyFrameDepth();
 
-  if (!auto_kf_size) {
-    last_auto_kf = NULL;
+  if (!auto_kf_size)
     return;
-  }
-
-  if (auto_key_frames != NULL)
-    Z_Free(auto_key_frames);
 
   ++auto_kf_size; // chain includes a terminator
 
@@ -196,9 +216,61 @@ void dsda_InitKeyFrame(void) {
   last_auto_kf = &auto_key_frames[auto_kf_size - 1];
 }
 
-void dsda_ExportKeyFrame(byte* buffer, int length) {
+// Key frames in memory point into the demo journal for their demo data;
+//   this makes a buffer with a copy of it instead, as key frames on disk have.
+static byte* dsda_ExpandKeyFrame(const dsda_key_frame_t* key_frame, int* length) {
+  const byte* source;
+  byte* buffer;
+  int journal_size;
+  int copy_size;
+  int tail_size;
+
+  source = key_frame->buffer + key_frame->demo_data_offset;
+  journal_size = dsda_DemoJournalDataSize(source, &copy_size);
+  tail_size = key_frame->buffer_length - key_frame->demo_data_offset - journal_size;
+
+  *length = key_frame->demo_data_offset + copy_size + tail_size;
+  buffer = Z_Malloc(*length);
+
+  memcpy(buffer, key_frame->buffer, key_frame->demo_data_offset);
+  buffer[0] = DEMO_DATA_COPY;
+  dsda_CopyDemoJournalData(buffer + key_frame->demo_data_offset, source);
+  memcpy(buffer + key_frame->demo_data_offset + copy_size, source + journal_size, tail_size);
+
+  return buffer;
+}
+
+static dboolean dsda_KeyFrameInJournal(const dsda_key_frame_t* key_frame) {
+  return key_frame->buffer && key_frame->buffer[0] == DEMO_DATA_JOURNAL;
+}
+
+// The quick key frame can be restored after rewinding and recording over
+//   what it refers to, so it takes its own copy before that happens.
+void dsda_DetachKeyFramesFromJournal(int offset) {
+  int demo_write_buffer_offset;
+  byte* buffer;
+  int length;
+
+  if (!dsda_KeyFrameInJournal(&quick_kf))
+    return;
+
+  memcpy(&demo_write_buffer_offset, quick_kf.buffer + quick_kf.demo_data_offset,
+         sizeof(demo_write_buffer_offset));
+
+  if (demo_write_buffer_offset <= offset)
+    return;
+
+  buffer = dsda_ExpandKeyFrame(&quick_kf, &length);
+  Z_Free(quick_kf.buffer);
+  quick_kf.buffer = buffer;
+  quick_kf.buffer_length = length;
+}
+
+void dsda_ExportKeyFrame(dsda_key_frame_t* key_frame) {
   char name[40];
   int timestamp;
+  byte* buffer;
+  int length;
 
   timestamp = totalleveltimes + leveltime;
 
@@ -207,14 +279,34 @@ void dsda_ExportKeyFrame(byte* buffer, int length) {
   if (M_FileExists(name))
     snprintf(name, sizeof(name), "backup-%010d-%lld.kf", timestamp, (long long) time(NULL));
 
+  // Only now is the recording up to the key frame copied out
+  if (dsda_KeyFrameInJournal(key_frame))
+    buffer = dsda_ExpandKeyFrame(key_frame, &length);
+  else {
+    buffer = key_frame->buffer;
+    length = key_frame->buffer_length;
+  }
+
   if (!M_WriteFile(name, buffer, length))
     I_Error("dsda_ExportKeyFrame: Failed to write key frame.");
+
+  if (buffer != key_frame->buffer)
+    Z_Free(buffer);
 }
 
 // Stripped down version of G_DoSaveGame
+// Key frames that never leave memory refer to the shared hub map archives
+//   instead of carrying their own copies; pass export for anything written out.
 void dsda_StoreKeyFrame(dsda_key_frame_t* key_frame, byte complete, byte export) {
+  int demo_data_offset;
+
   key_frame->game_tic_count = logictic;
 
+  // In memory, key frames point into the demo journal;
+  //   the recording is only copied out when one is exported
+  if (complete)
+    complete = DEMO_DATA_JOURNAL;
+
   P_InitSaveBuffer();
 
   P_SAVE_BYTE(complete);
@@ -224,14 +316,20 @@ void dsda_StoreKeyFrame(dsda_key_frame_t* key_frame, byte complete, byte export)
   dsda_StorePlaybackPosition();
 
   // Store state of demo recording buffer
+  demo_data_offset = save_p - savebuffer;
   dsda_StoreDemoData(complete);
 
+  SV_ShareMapArchives(!export);
   dsda_ArchiveAll();
+  SV_ShareMapArchives(false);
 
   if (key_frame->buffer != NULL) Z_Free(key_frame->buffer);
+  SV_ReleaseMapArchiveRefs(key_frame->map_archives);
 
+  key_frame->map_archives = SV_TakeMapArchiveRefs();
   key_frame->buffer = savebuffer;
   key_frame->buffer_length = save_p - savebuffer;
+  key_frame->demo_data_offset = demo_data_offset;
 
   P_ForgetSaveBuffer();
 
@@ -239,7 +337,7 @@ void dsda_StoreKeyFrame(dsda_key_frame_t* key_frame, byte complete, byte export)
 
   if (complete) {
     if (demorecording && export)
-      dsda_ExportKeyFrame(key_frame->buffer, key_frame->buffer_length);
+      dsda_ExportKeyFrame(key_frame);
 
     doom_printf("Stored key frame");
   }
@@ -31,7 +31,9 @@ typedef struct {
   byte* buffer;
   int buffer_length;
   int game_tic_count;
+  int demo_data_offset; // where the demo data starts in the buffer
   parent_kf_t parent;
+  struct map_archive_refs_s* map_archives;
 } dsda_key_frame_t;
 
 typedef struct auto_kf_s {
@@ -53,5 +55,6 @@ void dsda_RewindAutoKeyFrame(void);
 void dsda_ResetAutoKeyFrameTimeout(void);
 void dsda_UpdateAutoKeyFrames(void);
 void dsda_ForgetAutoKeyFrames(void);
+void dsda_DetachKeyFramesFromJournal(int offset);
 
 #endif
@@ -15,12 +15,18 @@
 //	DSDA Time
 //
 
+#include <stdio.h>
 #include <time.h>
 #include <string.h>
 
 #include "i_system.h"
+#include "lprintf.h"
+#include "m_file.h"
+#include "z_zone.h"
 
+#include "dsda/args.h"
 #include "dsda/configuration.h"
+#include "dsda/utility.h"
 
 #include "time.h"
 
@@ -71,6 +77,16 @@ unsigned long long dsda_ElapsedTimeMS(int timer) {
   return dsda_ElapsedTime(timer) / 1000;
 }
 
+// For timing things that take well under a microsecond
+unsigned long long dsda_ElapsedTimeNS(int timer) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  return (now.tv_nsec - dsda_time[timer].tv_nsec) +
+         (now.tv_sec - dsda_time[timer].tv_sec) * 1000000000ull;
+}
+
 static void dsda_Throttle(int timer, unsigned long long target_time) {
   unsigned long long elapsed_time;
   unsigned long long remaining_time;
@@ -199,3 +215,139 @@ void dsda_ResetTimeFunctions(int fastdemo) {
     dsda_TickElapsedTime = dsda_TickElapsedRealTime;
   }
 }
+
+// Load timeline
+//
+// Startup and level loading are split into nested phases. With -timeline
+//   or -timeline_file, each phase records its wall time, the zone
+//   allocations made and the bytes read from disk while it ran, and the
+//   whole tree is written out when the outermost phase ends.
+
+#define TIMELINE_MAX_DEPTH 16
+#define TIMELINE_MAX_PHASES 256
+
+typedef struct {
+  char name[32];
+  int depth;
+  struct timespec start;
+  unsigned long long elapsed;
+  unsigned long long alloc_count;
+  unsigned long long alloc_bytes;
+  unsigned long long bytes_read;
+} timed_phase_t;
+
+static timed_phase_t timeline[TIMELINE_MAX_PHASES];
+static int timeline_count;
+static int timeline_dropped;
+static int timeline_stack[TIMELINE_MAX_DEPTH];
+static int timeline_depth;
+static unsigned long long timeline_bytes_read;
+
+static dboolean dsda_TimelineEnabled(void) {
+  return dsda_Flag(dsda_arg_timeline) || dsda_Flag(dsda_arg_timeline_file);
+}
+
+void dsda_CountBytesRead(unsigned long long bytes) {
+  timeline_bytes_read += bytes;
+}
+
+static void dsda_WriteTimeline(void) {
+  dsda_string_t str;
+  dsda_arg_t* arg;
+  int i;
+
+  dsda_StringPrintF(&str, "Timeline:\n%9s %8s %11s %10s  %s\n",
+                    "ms", "allocs", "alloc KiB", "read KiB", "phase");
+
+  for (i = 0; i < timeline_count; ++i) {
+    timed_phase_t* phase = &timeline[i];
+
+    dsda_StringCatF(&str, "%9.3f %8llu %11llu %10llu  %*s%s\n",
+                    phase->elapsed / 1000.0,
+                    phase->alloc_count,
+                    phase->alloc_bytes / 1024,
+                    phase->bytes_read / 1024,
+                    2 * phase->depth, "", phase->name);
+  }
+
+  if (timeline_dropped)
+    dsda_StringCatF(&str, "(%d more phases not recorded)\n", timeline_dropped);
+
+  if (dsda_Flag(dsda_arg_timeline))
+    lprintf(LO_INFO, "%s", str.string);
+
+  arg = dsda_Arg(dsda_arg_timeline_file);
+  if (arg->found) {
+    FILE* file;
+
+    file = M_OpenFile(arg->value.v_string, "a");
+    if (file) {
+      fputs(str.string, file);
+      fclose(file);
+    }
+    else
+      lprintf(LO_WARN, "dsda_WriteTimeline: couldn't open %s\n", arg->value.v_string);
+  }
+
+  dsda_FreeString(&str);
+}
+
+void dsda_BeginTimedPhase(const char* name) {
+  timed_phase_t* phase;
+
+  if (!dsda_TimelineEnabled())
+    return;
+
+  if (timeline_depth == TIMELINE_MAX_DEPTH)
+    I_Error("dsda_BeginTimedPhase: %s is nested too deeply", name);
+
+  // Keep the stack balanced even when the phase isn't recorded
+  if (timeline_count == TIMELINE_MAX_PHASES) {
+    timeline_stack[timeline_depth++] = -1;
+    ++timeline_dropped;
+    return;
+  }
+
+  timeline_stack[timeline_depth] = timeline_count;
+
+  phase = &timeline[timeline_count++];
+  snprintf(phase->name, sizeof(phase->name), "%s", name);
+  phase->depth = timeline_depth++;
+  phase->bytes_read = timeline_bytes_read;
+  Z_AllocationStats(&phase->alloc_count, &phase->alloc_bytes);
+  clock_gettime(CLOCK_MONOTONIC, &phase->start);
+}
+
+void dsda_EndTimedPhase(void) {
+  int index;
+
+  if (!dsda_TimelineEnabled())
+    return;
+
+  if (!timeline_depth)
+    I_Error("dsda_EndTimedPhase: no phase to end");
+
+  index = timeline_stack[--timeline_depth];
+
+  if (index >= 0) {
+    timed_phase_t* phase = &timeline[index];
+    struct timespec now;
+    unsigned long long alloc_count;
+    unsigned long long alloc_bytes;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    Z_AllocationStats(&alloc_count, &alloc_bytes);
+
+    phase->elapsed = (now.tv_nsec - phase->start.tv_nsec) / 1000 +
+                     (now.tv_sec - phase->start.tv_sec) * 1000000;
+    phase->alloc_count = alloc_count - phase->alloc_count;
+    phase->alloc_bytes = alloc_bytes - phase->alloc_bytes;
+    phase->bytes_read = timeline_bytes_read - phase->bytes_read;
+  }
+
+  if (!timeline_depth) {
+    dsda_WriteTimeline();
+    timeline_count = 0;
+    timeline_dropped = 0;
+  }
+}
@@ -24,6 +24,9 @@ typedef enum {
   dsda_timer_key_frame,
   dsda_timer_brute_force,
   dsda_timer_render_stats,
+  dsda_timer_hud_component,
+  dsda_timer_hud_stats,
+  dsda_timer_clipper_replay,
   DSDA_TIMER_COUNT
 } dsda_timer_t;
 
@@ -33,8 +36,12 @@ extern unsigned long long (*dsda_TickElapsedTime)(void);
 void dsda_StartTimer(int timer);
 unsigned long long dsda_ElapsedTime(int timer);
 unsigned long long dsda_ElapsedTimeMS(int timer);
+unsigned long long dsda_ElapsedTimeNS(int timer);
 void dsda_LimitFPS(void);
 int dsda_GetTickRealTime(void);
 void dsda_ResetTimeFunctions(int fastdemo);
+void dsda_CountBytesRead(unsigned long long bytes);
+void dsda_BeginTimedPhase(const char* name);
+void dsda_EndTimedPhase(void);
 
 #endif
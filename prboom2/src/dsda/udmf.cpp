@@ -14,10 +14,26 @@
 // DESCRIPTION:
 //	DSDA UDMF
 //
+//  TEXTMAP is tokenized in place over the lump data. A sequential pass
+//  finds the boundaries of every block, then the blocks are decoded in
+//  parallel straight into the final arrays. Keys are dispatched through
+//  a perfect hash built from the field tables below.
+//
+//  The tokenizer mirrors the generic Scanner token for token, so the
+//  resulting structures are identical to what the Scanner would produce.
+//
 
+#include <cctype>
+#include <cstddef>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <string>
 #include <vector>
 
+#include "SDL.h"
+
 extern "C" {
 char *Z_StrdupLevel(const char *s);
 void *Z_MallocLevel(size_t size);
@@ -33,841 +49,1437 @@ std::vector<udmf_vertex_t> udmf_vertices;
 std::vector<udmf_sector_t> udmf_sectors;
 std::vector<udmf_thing_t> udmf_things;
 
-static void dsda_SkipValue(Scanner &scanner) {
-  if (scanner.CheckToken('=')) {
-    while (scanner.TokensLeft()) {
-      if (scanner.CheckToken(';'))
+//
+// Field tables
+//
+
+typedef enum {
+  UDMF_INT,
+  UDMF_FLOAT,
+  UDMF_FLAG,
+  UDMF_STRING_N,
+  UDMF_STRING,
+  UDMF_FLOAT_STRING,
+} udmf_field_type_t;
+
+typedef struct {
+  const char* name;
+  udmf_field_type_t type;
+  size_t offset;
+  uint64_t flag;
+} udmf_field_t;
+
+#define UDMF_FIELD(s, name, type) { #name, type, offsetof(s, name), 0 }
+#define UDMF_FLAG_FIELD(s, name, flag) { name, UDMF_FLAG, offsetof(s, flags), flag }
+
+static const udmf_field_t udmf_line_fields[] = {
+  UDMF_FIELD(udmf_line_t, id, UDMF_INT),
+  UDMF_FIELD(udmf_line_t, v1, UDMF_INT),
+  UDMF_FIELD(udmf_line_t, v2, UDMF_INT),
+  UDMF_FIELD(udmf_line_t, special, UDMF_INT),
+  UDMF_FIELD(udmf_line_t, arg0, UDMF_INT),
+  UDMF_FIELD(udmf_line_t, arg1, UDMF_INT),
+  UDMF_FIELD(udmf_line_t, arg2, UDMF_INT),
+  UDMF_FIELD(udmf_line_t, arg3, UDMF_INT),
+  UDMF_FIELD(udmf_line_t, arg4, UDMF_INT),
+  UDMF_FIELD(udmf_line_t, sidefront, UDMF_INT),
+  UDMF_FIELD(udmf_line_t, sideback, UDMF_INT),
+  UDMF_FIELD(udmf_line_t, locknumber, UDMF_INT),
+  UDMF_FIELD(udmf_line_t, automapstyle, UDMF_INT),
+  UDMF_FIELD(udmf_line_t, health, UDMF_INT),
+  UDMF_FIELD(udmf_line_t, healthgroup, UDMF_INT),
+  UDMF_FIELD(udmf_line_t, alpha, UDMF_FLOAT),
+  UDMF_FLAG_FIELD(udmf_line_t, "blocking", UDMF_ML_BLOCKING),
+  UDMF_FLAG_FIELD(udmf_line_t, "blockmonsters", UDMF_ML_BLOCKMONSTERS),
+  UDMF_FLAG_FIELD(udmf_line_t, "twosided", UDMF_ML_TWOSIDED),
+  UDMF_FLAG_FIELD(udmf_line_t, "dontpegtop", UDMF_ML_DONTPEGTOP),
+  UDMF_FLAG_FIELD(udmf_line_t, "dontpegbottom", UDMF_ML_DONTPEGBOTTOM),
+  UDMF_FLAG_FIELD(udmf_line_t, "secret", UDMF_ML_SECRET),
+  UDMF_FLAG_FIELD(udmf_line_t, "blocksound", UDMF_ML_SOUNDBLOCK),
+  UDMF_FLAG_FIELD(udmf_line_t, "dontdraw", UDMF_ML_DONTDRAW),
+  UDMF_FLAG_FIELD(udmf_line_t, "mapped", UDMF_ML_MAPPED),
+  UDMF_FLAG_FIELD(udmf_line_t, "passuse", UDMF_ML_PASSUSE),
+  UDMF_FLAG_FIELD(udmf_line_t, "translucent", UDMF_ML_TRANSLUCENT),
+  UDMF_FLAG_FIELD(udmf_line_t, "jumpover", UDMF_ML_JUMPOVER),
+  UDMF_FLAG_FIELD(udmf_line_t, "blockfloaters", UDMF_ML_BLOCKFLOATERS),
+  UDMF_FLAG_FIELD(udmf_line_t, "playercross", UDMF_ML_PLAYERCROSS),
+  UDMF_FLAG_FIELD(udmf_line_t, "playeruse", UDMF_ML_PLAYERUSE),
+  UDMF_FLAG_FIELD(udmf_line_t, "monstercross", UDMF_ML_MONSTERCROSS),
+  UDMF_FLAG_FIELD(udmf_line_t, "monsteruse", UDMF_ML_MONSTERUSE),
+  UDMF_FLAG_FIELD(udmf_line_t, "impact", UDMF_ML_IMPACT),
+  UDMF_FLAG_FIELD(udmf_line_t, "playerpush", UDMF_ML_PLAYERPUSH),
+  UDMF_FLAG_FIELD(udmf_line_t, "monsterpush", UDMF_ML_MONSTERPUSH),
+  UDMF_FLAG_FIELD(udmf_line_t, "missilecross", UDMF_ML_MISSILECROSS),
+  UDMF_FLAG_FIELD(udmf_line_t, "repeatspecial", UDMF_ML_REPEATSPECIAL),
+  UDMF_FLAG_FIELD(udmf_line_t, "playeruseback", UDMF_ML_PLAYERUSEBACK),
+  UDMF_FLAG_FIELD(udmf_line_t, "anycross", UDMF_ML_ANYCROSS),
+  UDMF_FLAG_FIELD(udmf_line_t, "monsteractivate", UDMF_ML_MONSTERACTIVATE),
+  UDMF_FLAG_FIELD(udmf_line_t, "blockplayers", UDMF_ML_BLOCKPLAYERS),
+  UDMF_FLAG_FIELD(udmf_line_t, "blockeverything", UDMF_ML_BLOCKEVERYTHING),
+  UDMF_FLAG_FIELD(udmf_line_t, "firstsideonly", UDMF_ML_FIRSTSIDEONLY),
+  UDMF_FLAG_FIELD(udmf_line_t, "zoneboundary", UDMF_ML_ZONEBOUNDARY),
+  UDMF_FLAG_FIELD(udmf_line_t, "clipmidtex", UDMF_ML_CLIPMIDTEX),
+  UDMF_FLAG_FIELD(udmf_line_t, "wrapmidtex", UDMF_ML_WRAPMIDTEX),
+  UDMF_FLAG_FIELD(udmf_line_t, "midtex3d", UDMF_ML_MIDTEX3D),
+  UDMF_FLAG_FIELD(udmf_line_t, "midtex3dimpassible", UDMF_ML_MIDTEX3DIMPASSIBLE),
+  UDMF_FLAG_FIELD(udmf_line_t, "checkswitchrange", UDMF_ML_CHECKSWITCHRANGE),
+  UDMF_FLAG_FIELD(udmf_line_t, "blockprojectiles", UDMF_ML_BLOCKPROJECTILES),
+  UDMF_FLAG_FIELD(udmf_line_t, "blockuse", UDMF_ML_BLOCKUSE),
+  UDMF_FLAG_FIELD(udmf_line_t, "blocksight", UDMF_ML_BLOCKSIGHT),
+  UDMF_FLAG_FIELD(udmf_line_t, "blockhitscan", UDMF_ML_BLOCKHITSCAN),
+  UDMF_FLAG_FIELD(udmf_line_t, "transparent", UDMF_ML_TRANSPARENT),
+  UDMF_FLAG_FIELD(udmf_line_t, "revealed", UDMF_ML_REVEALED),
+  UDMF_FLAG_FIELD(udmf_line_t, "noskywalls", UDMF_ML_NOSKYWALLS),
+  UDMF_FLAG_FIELD(udmf_line_t, "drawfullheight", UDMF_ML_DRAWFULLHEIGHT),
+  UDMF_FLAG_FIELD(udmf_line_t, "damagespecial", UDMF_ML_DAMAGESPECIAL),
+  UDMF_FLAG_FIELD(udmf_line_t, "deathspecial", UDMF_ML_DEATHSPECIAL),
+  UDMF_FLAG_FIELD(udmf_line_t, "blocklandmonsters", UDMF_ML_BLOCKLANDMONSTERS),
+  UDMF_FIELD(udmf_line_t, moreids, UDMF_STRING),
+  // known ignored fields:
+  // comment
+  // renderstyle
+  // arg0str
+};
+
+static const udmf_field_t udmf_side_fields[] = {
+  UDMF_FIELD(udmf_side_t, offsetx, UDMF_INT),
+  UDMF_FIELD(udmf_side_t, offsety, UDMF_INT),
+  UDMF_FIELD(udmf_side_t, sector, UDMF_INT),
+  UDMF_FIELD(udmf_side_t, light, UDMF_INT),
+  UDMF_FIELD(udmf_side_t, light_top, UDMF_INT),
+  UDMF_FIELD(udmf_side_t, light_mid, UDMF_INT),
+  UDMF_FIELD(udmf_side_t, light_bottom, UDMF_INT),
+  UDMF_FIELD(udmf_side_t, scalex_top, UDMF_FLOAT),
+  UDMF_FIELD(udmf_side_t, scaley_top, UDMF_FLOAT),
+  UDMF_FIELD(udmf_side_t, scalex_mid, UDMF_FLOAT),
+  UDMF_FIELD(udmf_side_t, scaley_mid, UDMF_FLOAT),
+  UDMF_FIELD(udmf_side_t, scalex_bottom, UDMF_FLOAT),
+  UDMF_FIELD(udmf_side_t, scaley_bottom, UDMF_FLOAT),
+  UDMF_FIELD(udmf_side_t, offsetx_top, UDMF_FLOAT),
+  UDMF_FIELD(udmf_side_t, offsety_top, UDMF_FLOAT),
+  UDMF_FIELD(udmf_side_t, offsetx_mid, UDMF_FLOAT),
+  UDMF_FIELD(udmf_side_t, offsety_mid, UDMF_FLOAT),
+  UDMF_FIELD(udmf_side_t, offsetx_bottom, UDMF_FLOAT),
+  UDMF_FIELD(udmf_side_t, offsety_bottom, UDMF_FLOAT),
+  UDMF_FLAG_FIELD(udmf_side_t, "lightabsolute", UDMF_SF_LIGHTABSOLUTE),
+  UDMF_FLAG_FIELD(udmf_side_t, "lightfog", UDMF_SF_LIGHTFOG),
+  UDMF_FLAG_FIELD(udmf_side_t, "nofakecontrast", UDMF_SF_NOFAKECONTRAST),
+  UDMF_FLAG_FIELD(udmf_side_t, "smoothlighting", UDMF_SF_SMOOTHLIGHTING),
+  UDMF_FLAG_FIELD(udmf_side_t, "clipmidtex", UDMF_SF_CLIPMIDTEX),
+  UDMF_FLAG_FIELD(udmf_side_t, "wrapmidtex", UDMF_SF_WRAPMIDTEX),
+  UDMF_FLAG_FIELD(udmf_side_t, "nodecals", UDMF_SF_NODECALS),
+  UDMF_FLAG_FIELD(udmf_side_t, "lightabsolute_top", UDMF_SF_LIGHTABSOLUTETOP),
+  UDMF_FLAG_FIELD(udmf_side_t, "lightabsolute_mid", UDMF_SF_LIGHTABSOLUTEMID),
+  UDMF_FLAG_FIELD(udmf_side_t, "lightabsolute_bottom", UDMF_SF_LIGHTABSOLUTEBOTTOM),
+  UDMF_FIELD(udmf_side_t, texturetop, UDMF_STRING_N),
+  UDMF_FIELD(udmf_side_t, texturebottom, UDMF_STRING_N),
+  UDMF_FIELD(udmf_side_t, texturemiddle, UDMF_STRING_N),
+  // known ignored fields:
+  // comment
+  // nogradient_top
+  // flipgradient_top
+  // clampgradient_top
+  // useowncolors_top
+  // uppercolor_top
+  // lowercolor_top
+  // nogradient_mid
+  // flipgradient_mid
+  // clampgradient_mid
+  // useowncolors_mid
+  // uppercolor_mid
+  // lowercolor_mid
+  // nogradient_bottom
+  // flipgradient_bottom
+  // clampgradient_bottom
+  // useowncolors_bottom
+  // uppercolor_bottom
+  // lowercolor_bottom
+  // useowncoloradd_top
+  // useowncoloradd_mid
+  // useowncoloradd_bottom
+  // coloradd_top
+  // coloradd_mid
+  // coloradd_bottom
+  // colorization_top
+  // colorization_mid
+  // colorization_bottom
+};
+
+static const udmf_field_t udmf_vertex_fields[] = {
+  UDMF_FIELD(udmf_vertex_t, x, UDMF_FLOAT_STRING),
+  UDMF_FIELD(udmf_vertex_t, y, UDMF_FLOAT_STRING),
+  // known ignored fields:
+  // zfloor
+  // zceiling
+};
+
+static const udmf_field_t udmf_sector_fields[] = {
+  UDMF_FIELD(udmf_sector_t, heightfloor, UDMF_INT),
+  UDMF_FIELD(udmf_sector_t, heightceiling, UDMF_INT),
+  UDMF_FIELD(udmf_sector_t, lightlevel, UDMF_INT),
+  UDMF_FIELD(udmf_sector_t, special, UDMF_INT),
+  UDMF_FIELD(udmf_sector_t, id, UDMF_INT),
+  UDMF_FIELD(udmf_sector_t, lightfloor, UDMF_INT),
+  UDMF_FIELD(udmf_sector_t, lightceiling, UDMF_INT),
+  UDMF_FIELD(udmf_sector_t, damageamount, UDMF_INT),
+  UDMF_FIELD(udmf_sector_t, damageinterval, UDMF_INT),
+  UDMF_FIELD(udmf_sector_t, leakiness, UDMF_INT),
+  UDMF_FIELD(udmf_sector_t, xpanningfloor, UDMF_FLOAT),
+  UDMF_FIELD(udmf_sector_t, ypanningfloor, UDMF_FLOAT),
+  UDMF_FIELD(udmf_sector_t, xpanningceiling, UDMF_FLOAT),
+  UDMF_FIELD(udmf_sector_t, ypanningceiling, UDMF_FLOAT),
+  UDMF_FIELD(udmf_sector_t, xscalefloor, UDMF_FLOAT),
+  UDMF_FIELD(udmf_sector_t, yscalefloor, UDMF_FLOAT),
+  UDMF_FIELD(udmf_sector_t, xscaleceiling, UDMF_FLOAT),
+  UDMF_FIELD(udmf_sector_t, yscaleceiling, UDMF_FLOAT),
+  UDMF_FIELD(udmf_sector_t, rotationfloor, UDMF_FLOAT),
+  UDMF_FIELD(udmf_sector_t, rotationceiling, UDMF_FLOAT),
+  UDMF_FIELD(udmf_sector_t, gravity, UDMF_FLOAT_STRING),
+  UDMF_FLAG_FIELD(udmf_sector_t, "lightfloorabsolute", UDMF_SECF_LIGHTFLOORABSOLUTE),
+  UDMF_FLAG_FIELD(udmf_sector_t, "lightceilingabsolute", UDMF_SECF_LIGHTCEILINGABSOLUTE),
+  UDMF_FLAG_FIELD(udmf_sector_t, "silent", UDMF_SECF_SILENT),
+  UDMF_FLAG_FIELD(udmf_sector_t, "nofallingdamage", UDMF_SECF_NOFALLINGDAMAGE),
+  UDMF_FLAG_FIELD(udmf_sector_t, "dropactors", UDMF_SECF_DROPACTORS),
+  UDMF_FLAG_FIELD(udmf_sector_t, "norespawn", UDMF_SECF_NORESPAWN),
+  UDMF_FLAG_FIELD(udmf_sector_t, "hidden", UDMF_SECF_HIDDEN),
+  UDMF_FLAG_FIELD(udmf_sector_t, "waterzone", UDMF_SECF_WATERZONE),
+  UDMF_FLAG_FIELD(udmf_sector_t, "damageterraineffect", UDMF_SECF_DAMAGETERRAINEFFECT),
+  UDMF_FLAG_FIELD(udmf_sector_t, "damagehazard", UDMF_SECF_DAMAGEHAZARD),
+  UDMF_FLAG_FIELD(udmf_sector_t, "noattack", UDMF_SECF_NOATTACK),
+  UDMF_FIELD(udmf_sector_t, texturefloor, UDMF_STRING_N),
+  UDMF_FIELD(udmf_sector_t, textureceiling, UDMF_STRING_N),
+  UDMF_FIELD(udmf_sector_t, moreids, UDMF_STRING),
+  // known ignored fields:
+  // comment
+  // ceilingplane_a
+  // ceilingplane_b
+  // ceilingplane_c
+  // ceilingplane_d
+  // floorplane_a
+  // floorplane_b
+  // floorplane_c
+  // floorplane_d
+  // alphafloor
+  // alphaceiling
+  // renderstylefloor
+  // renderstyleceiling
+  // lightcolor
+  // fadecolor
+  // desaturation
+  // soundsequence
+  // damagetype
+  // floorterrain
+  // ceilingterrain
+  // portal_ceil_blocksound
+  // portal_ceil_disabled
+  // portal_ceil_nopass
+  // portal_ceil_norender
+  // portal_ceil_overlaytype
+  // portal_floor_blocksound
+  // portal_floor_disabled
+  // portal_floor_nopass
+  // portal_floor_norender
+  // portal_floor_overlaytype
+  // floor_reflect
+  // ceiling_reflect
+  // fogdensity
+  // floorglowcolor
+  // floorglowheight
+  // ceilingglowcolor
+  // ceilingglowheight
+  // color_floor
+  // color_ceiling
+  // color_walltop
+  // color_wallbottom
+  // color_sprites
+  // coloradd_floor
+  // coloradd_ceiling
+  // coloradd_sprites
+  // coloradd_walls
+  // colorization_floor
+  // colorization_ceiling
+  // noskywalls
+  // healthfloor
+  // healthfloorgroup
+  // healthceiling
+  // healthceilinggroup
+};
+
+static const udmf_field_t udmf_thing_fields[] = {
+  UDMF_FIELD(udmf_thing_t, id, UDMF_INT),
+  UDMF_FIELD(udmf_thing_t, angle, UDMF_INT),
+  UDMF_FIELD(udmf_thing_t, type, UDMF_INT),
+  UDMF_FIELD(udmf_thing_t, special, UDMF_INT),
+  UDMF_FIELD(udmf_thing_t, arg0, UDMF_INT),
+  UDMF_FIELD(udmf_thing_t, arg1, UDMF_INT),
+  UDMF_FIELD(udmf_thing_t, arg2, UDMF_INT),
+  UDMF_FIELD(udmf_thing_t, arg3, UDMF_INT),
+  UDMF_FIELD(udmf_thing_t, arg4, UDMF_INT),
+  UDMF_FIELD(udmf_thing_t, floatbobphase, UDMF_INT),
+  UDMF_FIELD(udmf_thing_t, x, UDMF_FLOAT_STRING),
+  UDMF_FIELD(udmf_thing_t, y, UDMF_FLOAT_STRING),
+  UDMF_FIELD(udmf_thing_t, height, UDMF_FLOAT_STRING),
+  UDMF_FIELD(udmf_thing_t, gravity, UDMF_FLOAT_STRING),
+  UDMF_FIELD(udmf_thing_t, health, UDMF_FLOAT_STRING),
+  UDMF_FIELD(udmf_thing_t, scalex, UDMF_FLOAT),
+  UDMF_FIELD(udmf_thing_t, scaley, UDMF_FLOAT),
+  UDMF_FIELD(udmf_thing_t, scale, UDMF_FLOAT),
+  UDMF_FIELD(udmf_thing_t, alpha, UDMF_FLOAT),
+  UDMF_FLAG_FIELD(udmf_thing_t, "skill1", UDMF_TF_SKILL1),
+  UDMF_FLAG_FIELD(udmf_thing_t, "skill2", UDMF_TF_SKILL2),
+  UDMF_FLAG_FIELD(udmf_thing_t, "skill3", UDMF_TF_SKILL3),
+  UDMF_FLAG_FIELD(udmf_thing_t, "skill4", UDMF_TF_SKILL4),
+  UDMF_FLAG_FIELD(udmf_thing_t, "skill5", UDMF_TF_SKILL5),
+  UDMF_FLAG_FIELD(udmf_thing_t, "ambush", UDMF_TF_AMBUSH),
+  UDMF_FLAG_FIELD(udmf_thing_t, "single", UDMF_TF_SINGLE),
+  UDMF_FLAG_FIELD(udmf_thing_t, "dm", UDMF_TF_DM),
+  UDMF_FLAG_FIELD(udmf_thing_t, "coop", UDMF_TF_COOP),
+  UDMF_FLAG_FIELD(udmf_thing_t, "friend", UDMF_TF_FRIEND),
+  UDMF_FLAG_FIELD(udmf_thing_t, "dormant", UDMF_TF_DORMANT),
+  UDMF_FLAG_FIELD(udmf_thing_t, "class1", UDMF_TF_CLASS1),
+  UDMF_FLAG_FIELD(udmf_thing_t, "class2", UDMF_TF_CLASS2),
+  UDMF_FLAG_FIELD(udmf_thing_t, "class3", UDMF_TF_CLASS3),
+  UDMF_FLAG_FIELD(udmf_thing_t, "standing", UDMF_TF_STANDING),
+  UDMF_FLAG_FIELD(udmf_thing_t, "strifeally", UDMF_TF_STRIFEALLY),
+  UDMF_FLAG_FIELD(udmf_thing_t, "translucent", UDMF_TF_TRANSLUCENT),
+  UDMF_FLAG_FIELD(udmf_thing_t, "invisible", UDMF_TF_INVISIBLE),
+  UDMF_FLAG_FIELD(udmf_thing_t, "countsecret", UDMF_TF_COUNTSECRET),
+  // known ignored fields:
+  // comment
+  // skill6-16
+  // class4-16
+  // conversation
+  // arg0str
+  // renderstyle
+  // fillcolor
+  // score
+  // pitch
+  // roll
+};
+
+//
+// Block types
+//
+
+typedef enum {
+  udmf_block_line,
+  udmf_block_side,
+  udmf_block_vertex,
+  udmf_block_sector,
+  udmf_block_thing,
+  udmf_block_count,
+} udmf_block_kind_t;
+
+#define UDMF_KEY_SLOTS 512
+
+typedef struct {
+  const char* name;
+  const udmf_field_t* fields;
+  size_t num_fields;
+  size_t flags_size;
+  unsigned int seed;
+  unsigned char slots[UDMF_KEY_SLOTS]; // field index + 1
+} udmf_block_type_t;
+
+#define UDMF_BLOCK_TYPE(name, fields, flags_size) \
+  { name, fields, sizeof(fields) / sizeof(fields[0]), flags_size, 0, { 0 } }
+
+static udmf_block_type_t udmf_block_types[udmf_block_count] = {
+  UDMF_BLOCK_TYPE("linedef", udmf_line_fields, sizeof(udmf_line_flags_t)),
+  UDMF_BLOCK_TYPE("sidedef", udmf_side_fields, sizeof(udmf_side_flags_t)),
+  UDMF_BLOCK_TYPE("vertex", udmf_vertex_fields, 0),
+  UDMF_BLOCK_TYPE("sector", udmf_sector_fields, sizeof(udmf_sector_flags_t)),
+  UDMF_BLOCK_TYPE("thing", udmf_thing_fields, sizeof(udmf_thing_flags_t)),
+};
+
+static unsigned int dsda_UDMFKeyHash(unsigned int seed, const char* key, size_t length) {
+  unsigned int hash = 2166136261u ^ seed;
+  size_t i;
+
+  for (i = 0; i < length; ++i) {
+    hash ^= (unsigned char) tolower(key[i]);
+    hash *= 16777619u;
+  }
+
+  return (hash ^ (hash >> 15)) & (UDMF_KEY_SLOTS - 1);
+}
+
+// Search for a seed that maps every key of the block type to its own slot
+static void dsda_BuildUDMFKeyTable(udmf_block_type_t* type) {
+  unsigned int seed;
+  size_t i;
+
+  for (seed = 1; ; ++seed) {
+    memset(type->slots, 0, sizeof(type->slots));
+
+    for (i = 0; i < type->num_fields; ++i) {
+      const char* name = type->fields[i].name;
+      unsigned int slot = dsda_UDMFKeyHash(seed, name, strlen(name));
+
+      if (type->slots[slot])
         break;
 
-      scanner.GetNextToken();
+      type->slots[slot] = (unsigned char) (i + 1);
     }
 
-    return;
+    if (i == type->num_fields)
+      break;
+  }
+
+  type->seed = seed;
+}
+
+static const udmf_field_t* dsda_LookupUDMFField(const udmf_block_type_t* type,
+                                                const char* key, size_t length) {
+  unsigned int slot = dsda_UDMFKeyHash(type->seed, key, length);
+  const udmf_field_t* field;
+
+  if (!type->slots[slot])
+    return NULL;
+
+  field = &type->fields[type->slots[slot] - 1];
+
+  if (strlen(field->name) != length || strnicmp(field->name, key, length))
+    return NULL;
+
+  return field;
+}
+
+//
+// Tokenizer
+//
+
+typedef struct {
+  int type;
+  size_t pos;
+  int line;
+  int column;
+  const char* text;
+  size_t length;
+  int base;
+  bool boolean;
+} udmf_token_t;
+
+// Strings are materialized after the parallel decode, since zone memory
+// must only be touched from the main thread
+typedef struct {
+  void* dest;
+  const char* text;
+  size_t length;
+  bool negative;
+  bool escaped;
+} udmf_pending_string_t;
+
+class UDMFLexer {
+  public:
+    UDMFLexer(const char* data, size_t begin, size_t end)
+      : data(data), failed(false), pos(begin), length(end), line(1), line_start(begin), ahead(false)
+    {
+      token.type = TK_NoToken;
+      token.pos = begin;
+      token.line = line;
+      token.column = 0;
+      SkipWhitespace();
+    }
+
+    bool TokensLeft() const { return pos < length; }
+    size_t Position() const { return pos; }
+    void Seek(size_t position);
+
+    bool CheckToken(int type);
+    bool GetNextToken();
+    bool MustGetToken(int type);
+    bool MustGetInteger(int &number);
+    bool MustGetFloat(double &decimal, bool &negative);
+    bool SkipValue();
+
+    bool TokenIs(const char* text) const;
+    void TokenString(std::string &result) const;
+    void ErrorF(const char* msg, ...);
+
+    const char* data;
+    udmf_token_t token;
+
+    bool failed;
+    char error[1024];
+
+  private:
+    void SkipWhitespace();
+    void NewLine(char cur, char next);
+    bool Lex(udmf_token_t &t);
+    bool ScanNumber(bool integer, bool &negative);
+    void Error(int expected);
+
+    size_t pos;
+    size_t length;
+    int line;
+    size_t line_start;
+
+    udmf_token_t next;
+    bool ahead;
+};
+
+// Lines are only counted outside of tokens, as in the Scanner
+void UDMFLexer::NewLine(char cur, char next) {
+  pos++;
+
+  // Do a quick check for Windows style new line
+  if (cur == '\r' && next == '\n')
+    pos++;
+
+  line++;
+  line_start = pos;
+}
+
+void UDMFLexer::SkipWhitespace() {
+  int comment = 0; // 1 = till next new line, 2 = till end block
+
+  while (pos < length) {
+    char cur = data[pos];
+    char next = pos + 1 < length ? data[pos + 1] : 0;
+
+    if (comment == 2) {
+      if (cur == '\n' || cur == '\r')
+        NewLine(cur, next);
+      else if (cur != '*' || next != '/')
+        pos++;
+      else {
+        comment = 0;
+        pos += 2;
+      }
+      continue;
+    }
+
+    if (cur == ' ' || cur == '\t' || cur == 0)
+      pos++;
+    else if (cur == '\n' || cur == '\r') {
+      NewLine(cur, next);
+      comment = 0;
+    }
+    else if (cur == '/' && comment == 0) {
+      if (next == '/')
+        comment = 1;
+      else if (next == '*')
+        comment = 2;
+      else
+        return;
+
+      pos += 2;
+    }
+    else if (comment == 0)
+      return;
+    else
+      pos++;
+  }
+}
+
+void UDMFLexer::Seek(size_t position) {
+  pos = position;
+  ahead = false;
+  SkipWhitespace();
+}
+
+static bool dsda_IsUDMFIdentifierChar(char c) {
+  return c == '_' || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9');
+}
+
+// Mirrors Scanner::GetNextToken without copying the token
+bool UDMFLexer::Lex(udmf_token_t &t) {
+  size_t start, end;
+  int base = 10;
+  bool has_decimal = false;
+  bool has_exponent = false;
+  bool string_finished = false;
+  char cur;
+
+  t.type = TK_NoToken;
+  t.pos = pos;
+  t.line = line;
+  t.column = (int) (pos - line_start);
+
+  if (pos >= length)
+    return false;
+
+  start = end = pos;
+  cur = data[pos++];
+
+  if (cur == '_' || (cur >= 'A' && cur <= 'Z') || (cur >= 'a' && cur <= 'z'))
+    t.type = TK_Identifier;
+  else if (cur >= '0' && cur <= '9') {
+    if (cur == '0')
+      base = 8;
+    t.type = TK_IntConst;
+  }
+  else if (cur == '.') {
+    has_decimal = true;
+    t.type = TK_FloatConst;
+  }
+  else if (cur == '"') {
+    end = ++start;
+    t.type = TK_StringConst;
+  }
+  else {
+    char single = cur;
+
+    end = pos;
+    t.type = single;
+
+    if (pos < length) {
+      char next = data[pos];
+
+      if (cur == '&' && next == '&')
+        t.type = TK_AndAnd;
+      else if (cur == '|' && next == '|')
+        t.type = TK_OrOr;
+      else if (cur == '<' && next == '<')
+        t.type = TK_ShiftLeft;
+      else if (cur == '>' && next == '>')
+        t.type = TK_ShiftRight;
+      else if (next == '=') {
+        switch (cur) {
+          case '=':
+            t.type = TK_EqEq;
+            break;
+          case '!':
+            t.type = TK_NotEq;
+            break;
+          case '>':
+            t.type = TK_GtrEq;
+            break;
+          case '<':
+            t.type = TK_LessEq;
+            break;
+          default:
+            break;
+        }
+      }
+
+      if (t.type != single) {
+        pos++;
+        end = pos;
+      }
+    }
+  }
+
+  if (start == end) {
+    while (pos < length) {
+      cur = data[pos];
+
+      switch (t.type) {
+        default:
+          break;
+        case TK_Identifier:
+          if (!dsda_IsUDMFIdentifierChar(cur))
+            end = pos;
+          break;
+        case TK_IntConst:
+          if (cur == '.' || (pos - 1 != start && cur == 'e'))
+            t.type = TK_FloatConst;
+          else if ((cur == 'x' || cur == 'X') && pos - 1 == start) {
+            base = 16;
+            break;
+          }
+          else {
+            switch (base) {
+              default:
+                if (cur < '0' || cur > '9')
+                  end = pos;
+                break;
+              case 8:
+                if (cur < '0' || cur > '7')
+                  end = pos;
+                break;
+              case 16:
+                if ((cur < '0' || cur > '9') && (cur < 'A' || cur > 'F') && (cur < 'a' || cur > 'f'))
+                  end = pos;
+                break;
+            }
+            break;
+          }
+          // fallthrough
+        case TK_FloatConst:
+          if (cur < '0' || cur > '9') {
+            if (!has_decimal && cur == '.') {
+              has_decimal = true;
+              break;
+            }
+            else if (!has_exponent && cur == 'e') {
+              has_decimal = true;
+              has_exponent = true;
+              if (pos + 1 < length) {
+                char next = data[pos + 1];
+
+                if ((next < '0' || next > '9') && next != '+' && next != '-')
+                  end = pos;
+                else
+                  pos++;
+              }
+              break;
+            }
+            end = pos;
+          }
+          break;
+        case TK_StringConst:
+          if (cur == '"') {
+            string_finished = true;
+            end = pos;
+            pos++;
+          }
+          else if (cur == '\\')
+            pos++;
+          break;
+      }
+
+      if (start == end && !string_finished)
+        pos++;
+      else
+        break;
+    }
+  }
+
+  if (end > start || string_finished) {
+    t.text = data + start;
+    t.length = end - start;
+    t.base = base;
+    t.boolean = false;
+
+    if (t.type == TK_Identifier) {
+      if (t.length == 4 && !strnicmp(t.text, "true", 4)) {
+        t.type = TK_BoolConst;
+        t.boolean = true;
+      }
+      else if (t.length == 5 && !strnicmp(t.text, "false", 5)) {
+        t.type = TK_BoolConst;
+        t.boolean = false;
+      }
+    }
+
+    SkipWhitespace();
+    return true;
+  }
+
+  t.type = TK_NoToken;
+  SkipWhitespace();
+  return false;
+}
+
+bool UDMFLexer::CheckToken(int type) {
+  if (!ahead) {
+    if (!Lex(next))
+      return false;
+    ahead = true;
+  }
+
+  // An int can also be a float.
+  if (next.type == type || (next.type == TK_IntConst && type == TK_FloatConst)) {
+    token = next;
+    ahead = false;
+    return true;
+  }
+
+  return false;
+}
+
+bool UDMFLexer::GetNextToken() {
+  if (ahead) {
+    token = next;
+    ahead = false;
+    return true;
+  }
+
+  return Lex(token);
+}
+
+bool UDMFLexer::MustGetToken(int type) {
+  if (!CheckToken(type)) {
+    token = next;
+    ahead = false;
+
+    Error(type);
+    return false;
+  }
+
+  return true;
+}
+
+bool UDMFLexer::ScanNumber(bool integer, bool &negative) {
+  negative = false;
+
+  if (!GetNextToken())
+    return false;
+
+  if (token.type == '-') {
+    if (!GetNextToken())
+      return false;
+    negative = true;
+  }
+  else if (token.type == '+') {
+    if (!GetNextToken())
+      return false;
+  }
+
+  if (integer)
+    return token.type == TK_IntConst;
+
+  return token.type == TK_IntConst || token.type == TK_FloatConst;
+}
+
+static void dsda_UDMFTokenNumber(const udmf_token_t &t, int &number, double &decimal) {
+  char buffer[64];
+  std::string long_text;
+  const char* text;
+
+  if (t.length < sizeof(buffer)) {
+    memcpy(buffer, t.text, t.length);
+    buffer[t.length] = '\0';
+    text = buffer;
+  }
+  else {
+    long_text.assign(t.text, t.length);
+    text = long_text.c_str();
+  }
+
+  if (t.type == TK_FloatConst) {
+    decimal = atof(text);
+    number = static_cast<int> (decimal);
+  }
+  else {
+    number = strtol(text, NULL, t.base);
+    decimal = number;
+  }
+}
+
+bool UDMFLexer::MustGetInteger(int &number) {
+  double decimal;
+  bool negative;
+
+  if (!ScanNumber(true, negative)) {
+    Error(TK_IntConst);
+    return false;
+  }
+
+  dsda_UDMFTokenNumber(token, number, decimal);
+  if (negative)
+    number = -number;
+
+  return true;
+}
+
+bool UDMFLexer::MustGetFloat(double &decimal, bool &negative) {
+  int number;
+
+  if (!ScanNumber(false, negative)) {
+    Error(TK_FloatConst);
+    return false;
+  }
+
+  dsda_UDMFTokenNumber(token, number, decimal);
+  if (negative)
+    decimal = -decimal;
+
+  return true;
+}
+
+bool UDMFLexer::SkipValue() {
+  if (CheckToken('=')) {
+    while (TokensLeft()) {
+      if (CheckToken(';'))
+        break;
+
+      GetNextToken();
+    }
+
+    return true;
   }
 
-  scanner.MustGetToken('{');
+  if (!MustGetToken('{'))
+    return false;
+
   {
     int brace_count = 1;
 
-    while (scanner.TokensLeft()) {
-      if (scanner.CheckToken('}')) {
+    while (TokensLeft()) {
+      if (CheckToken('}')) {
         --brace_count;
       }
-      else if (scanner.CheckToken('{')) {
+      else if (CheckToken('{')) {
         ++brace_count;
       }
 
       if (!brace_count)
         break;
 
-      scanner.GetNextToken();
+      GetNextToken();
     }
+  }
+
+  return true;
+}
+
+bool UDMFLexer::TokenIs(const char* text) const {
+  size_t text_length = strlen(text);
+
+  return token.length == text_length && !strnicmp(token.text, text, text_length);
+}
+
+void UDMFLexer::TokenString(std::string &result) const {
+  result.assign(token.text, token.length);
+  Scanner::Unescape(&result[0]);
+  result.resize(strlen(result.c_str()));
+}
+
+void UDMFLexer::ErrorF(const char* msg, ...) {
+  char buffer[1024];
+  va_list ap;
+
+  if (failed)
+    return;
+
+  va_start(ap, msg);
+  vsnprintf(buffer, sizeof(buffer), msg, ap);
+  va_end(ap);
+
+  snprintf(error, sizeof(error), "%d:%d:%s.", token.line, token.column, buffer);
+  failed = true;
+}
+
+static void dsda_UDMFTokenName(int type, char* buffer, size_t size) {
+  if (type >= TK_Identifier && type < TK_NumSpecialTokens && Scanner::TokenNames[type])
+    snprintf(buffer, size, "%s", Scanner::TokenNames[type]);
+  else
+    snprintf(buffer, size, "%c", type);
+}
+
+void UDMFLexer::Error(int expected) {
+  char expected_name[64];
+  char token_name[64];
 
+  if (failed)
     return;
+
+  dsda_UDMFTokenName(expected, expected_name, sizeof(expected_name));
+  if (token.type == TK_NoToken)
+    snprintf(error, sizeof(error), "%d:%d:Expected '%s'", token.line, token.column, expected_name);
+  else {
+    dsda_UDMFTokenName(token.type, token_name, sizeof(token_name));
+    snprintf(error, sizeof(error), "%d:%d:Expected '%s' but got '%s' instead.",
+             token.line, token.column, expected_name, token_name);
   }
+
+  failed = true;
 }
 
-// The scanner drops the sign when scanning, and we need it back
-static char* dsda_FloatString(Scanner &scanner) {
-  if (scanner.decimal >= 0)
-    return Z_StrdupLevel(scanner.string);
+//
+// Block decoding
+//
 
-  char* buffer = (char*) Z_MallocLevel(strlen(scanner.string) + 2);
-  buffer[0] = '-';
-  buffer[1] = '\0';
-  strcat(buffer, scanner.string);
+typedef struct {
+  udmf_block_kind_t kind;
+  size_t index;
+  size_t begin;
+  size_t end;
+} udmf_block_t;
 
-  return buffer;
+static void* dsda_UDMFBlockData(udmf_block_kind_t kind, size_t index) {
+  switch (kind) {
+    case udmf_block_line:
+      return &udmf_lines[index];
+    case udmf_block_side:
+      return &udmf_sides[index];
+    case udmf_block_vertex:
+      return &udmf_vertices[index];
+    case udmf_block_sector:
+      return &udmf_sectors[index];
+    default:
+      return &udmf_things[index];
+  }
 }
 
-#define SCAN_INT(x)  { scanner.MustGetToken('='); \
-                       scanner.MustGetInteger(); \
-                       x = scanner.number; \
-                       scanner.MustGetToken(';'); }
+static void dsda_SetUDMFFlag(void* flags, size_t size, uint64_t flag) {
+  switch (size) {
+    case sizeof(uint16_t):
+      *(uint16_t*) flags |= (uint16_t) flag;
+      break;
+    case sizeof(uint32_t):
+      *(uint32_t*) flags |= (uint32_t) flag;
+      break;
+    default:
+      *(uint64_t*) flags |= flag;
+      break;
+  }
+}
 
-#define SCAN_FLOAT(x) { scanner.MustGetToken('='); \
-                        scanner.MustGetFloat(); \
-                        x = scanner.decimal; \
-                        scanner.MustGetToken(';'); }
+static void dsda_CopyUDMFStringN(char* dest, const udmf_token_t &t, size_t n) {
+  size_t i;
 
-#define SCAN_FLAG(x, f) { scanner.MustGetToken('='); \
-                          scanner.MustGetToken(TK_BoolConst); \
-                          if (scanner.boolean) \
-                            x |= f; \
-                          scanner.MustGetToken(';'); }
+  if (memchr(t.text, '\\', t.length)) {
+    std::string text(t.text, t.length);
 
-#define SCAN_STRING_N(x, n) { scanner.MustGetToken('='); \
-                              scanner.MustGetToken(TK_StringConst); \
-                              strncpy(x, scanner.string, n); \
-                              scanner.MustGetToken(';'); }
+    Scanner::Unescape(&text[0]);
+    strncpy(dest, text.c_str(), n);
 
-#define SCAN_STRING(x) { scanner.MustGetToken('='); \
-                         scanner.MustGetToken(TK_StringConst); \
-                         x = Z_StrdupLevel(scanner.string); \
-                         scanner.MustGetToken(';'); }
+    return;
+  }
 
-#define SCAN_FLOAT_STRING(x) { scanner.MustGetToken('='); \
-                               scanner.MustGetFloat(); \
-                               x = dsda_FloatString(scanner); \
-                               scanner.MustGetToken(';'); }
+  for (i = 0; i < n && i < t.length && t.text[i]; ++i)
+    dest[i] = t.text[i];
 
-static void dsda_ParseUDMFLineDef(Scanner &scanner) {
-  udmf_line_t line = { 0 };
+  for (; i < n; ++i)
+    dest[i] = '\0';
+}
 
-  line.id = -1;
-  line.sideback = -1;
-  line.alpha = 1.0;
+static bool dsda_DecodeUDMFField(UDMFLexer &lexer, const udmf_field_t* field, size_t flags_size,
+                                 char* data, std::vector<udmf_pending_string_t> &strings) {
+  void* dest = data + field->offset;
 
-  scanner.MustGetToken('{');
-  while (!scanner.CheckToken('}')) {
-    scanner.MustGetToken(TK_Identifier);
+  if (!lexer.MustGetToken('='))
+    return false;
 
-    if (!stricmp(scanner.string, "id")) {
-      SCAN_INT(line.id);
-    }
-    else if (!stricmp(scanner.string, "v1")) {
-      SCAN_INT(line.v1);
-    }
-    else if (!stricmp(scanner.string, "v2")) {
-      SCAN_INT(line.v2);
-    }
-    else if (!stricmp(scanner.string, "special")) {
-      SCAN_INT(line.special);
-    }
-    else if (!stricmp(scanner.string, "arg0")) {
-      SCAN_INT(line.arg0);
-    }
-    else if (!stricmp(scanner.string, "arg1")) {
-      SCAN_INT(line.arg1);
-    }
-    else if (!stricmp(scanner.string, "arg2")) {
-      SCAN_INT(line.arg2);
-    }
-    else if (!stricmp(scanner.string, "arg3")) {
-      SCAN_INT(line.arg3);
-    }
-    else if (!stricmp(scanner.string, "arg4")) {
-      SCAN_INT(line.arg4);
-    }
-    else if (!stricmp(scanner.string, "sidefront")) {
-      SCAN_INT(line.sidefront);
-    }
-    else if (!stricmp(scanner.string, "sideback")) {
-      SCAN_INT(line.sideback);
-    }
-    else if (!stricmp(scanner.string, "locknumber")) {
-      SCAN_INT(line.locknumber);
-    }
-    else if (!stricmp(scanner.string, "automapstyle")) {
-      SCAN_INT(line.automapstyle);
-    }
-    else if (!stricmp(scanner.string, "health")) {
-      SCAN_INT(line.health);
-    }
-    else if (!stricmp(scanner.string, "healthgroup")) {
-      SCAN_INT(line.healthgroup);
-    }
-    else if (!stricmp(scanner.string, "alpha")) {
-      SCAN_FLOAT(line.alpha);
-    }
-    else if (!stricmp(scanner.string, "blocking")) {
-      SCAN_FLAG(line.flags, UDMF_ML_BLOCKING);
-    }
-    else if (!stricmp(scanner.string, "blockmonsters")) {
-      SCAN_FLAG(line.flags, UDMF_ML_BLOCKMONSTERS);
-    }
-    else if (!stricmp(scanner.string, "twosided")) {
-      SCAN_FLAG(line.flags, UDMF_ML_TWOSIDED);
-    }
-    else if (!stricmp(scanner.string, "dontpegtop")) {
-      SCAN_FLAG(line.flags, UDMF_ML_DONTPEGTOP);
-    }
-    else if (!stricmp(scanner.string, "dontpegbottom")) {
-      SCAN_FLAG(line.flags, UDMF_ML_DONTPEGBOTTOM);
-    }
-    else if (!stricmp(scanner.string, "secret")) {
-      SCAN_FLAG(line.flags, UDMF_ML_SECRET);
-    }
-    else if (!stricmp(scanner.string, "blocksound")) {
-      SCAN_FLAG(line.flags, UDMF_ML_SOUNDBLOCK);
-    }
-    else if (!stricmp(scanner.string, "dontdraw")) {
-      SCAN_FLAG(line.flags, UDMF_ML_DONTDRAW);
-    }
-    else if (!stricmp(scanner.string, "mapped")) {
-      SCAN_FLAG(line.flags, UDMF_ML_MAPPED);
-    }
-    else if (!stricmp(scanner.string, "passuse")) {
-      SCAN_FLAG(line.flags, UDMF_ML_PASSUSE);
-    }
-    else if (!stricmp(scanner.string, "translucent")) {
-      SCAN_FLAG(line.flags, UDMF_ML_TRANSLUCENT);
-    }
-    else if (!stricmp(scanner.string, "jumpover")) {
-      SCAN_FLAG(line.flags, UDMF_ML_JUMPOVER);
-    }
-    else if (!stricmp(scanner.string, "blockfloaters")) {
-      SCAN_FLAG(line.flags, UDMF_ML_BLOCKFLOATERS);
-    }
-    else if (!stricmp(scanner.string, "playercross")) {
-      SCAN_FLAG(line.flags, UDMF_ML_PLAYERCROSS);
-    }
-    else if (!stricmp(scanner.string, "playeruse")) {
-      SCAN_FLAG(line.flags, UDMF_ML_PLAYERUSE);
-    }
-    else if (!stricmp(scanner.string, "monstercross")) {
-      SCAN_FLAG(line.flags, UDMF_ML_MONSTERCROSS);
-    }
-    else if (!stricmp(scanner.string, "monsteruse")) {
-      SCAN_FLAG(line.flags, UDMF_ML_MONSTERUSE);
-    }
-    else if (!stricmp(scanner.string, "impact")) {
-      SCAN_FLAG(line.flags, UDMF_ML_IMPACT);
-    }
-    else if (!stricmp(scanner.string, "playerpush")) {
-      SCAN_FLAG(line.flags, UDMF_ML_PLAYERPUSH);
-    }
-    else if (!stricmp(scanner.string, "monsterpush")) {
-      SCAN_FLAG(line.flags, UDMF_ML_MONSTERPUSH);
-    }
-    else if (!stricmp(scanner.string, "missilecross")) {
-      SCAN_FLAG(line.flags, UDMF_ML_MISSILECROSS);
-    }
-    else if (!stricmp(scanner.string, "repeatspecial")) {
-      SCAN_FLAG(line.flags, UDMF_ML_REPEATSPECIAL);
-    }
-    else if (!stricmp(scanner.string, "playeruseback")) {
-      SCAN_FLAG(line.flags, UDMF_ML_PLAYERUSEBACK);
-    }
-    else if (!stricmp(scanner.string, "anycross")) {
-      SCAN_FLAG(line.flags, UDMF_ML_ANYCROSS);
-    }
-    else if (!stricmp(scanner.string, "monsteractivate")) {
-      SCAN_FLAG(line.flags, UDMF_ML_MONSTERACTIVATE);
-    }
-    else if (!stricmp(scanner.string, "blockplayers")) {
-      SCAN_FLAG(line.flags, UDMF_ML_BLOCKPLAYERS);
-    }
-    else if (!stricmp(scanner.string, "blockeverything")) {
-      SCAN_FLAG(line.flags, UDMF_ML_BLOCKEVERYTHING);
-    }
-    else if (!stricmp(scanner.string, "firstsideonly")) {
-      SCAN_FLAG(line.flags, UDMF_ML_FIRSTSIDEONLY);
-    }
-    else if (!stricmp(scanner.string, "zoneboundary")) {
-      SCAN_FLAG(line.flags, UDMF_ML_ZONEBOUNDARY);
-    }
-    else if (!stricmp(scanner.string, "clipmidtex")) {
-      SCAN_FLAG(line.flags, UDMF_ML_CLIPMIDTEX);
-    }
-    else if (!stricmp(scanner.string, "wrapmidtex")) {
-      SCAN_FLAG(line.flags, UDMF_ML_WRAPMIDTEX);
-    }
-    else if (!stricmp(scanner.string, "midtex3d")) {
-      SCAN_FLAG(line.flags, UDMF_ML_MIDTEX3D);
-    }
-    else if (!stricmp(scanner.string, "midtex3dimpassible")) {
-      SCAN_FLAG(line.flags, UDMF_ML_MIDTEX3DIMPASSIBLE);
-    }
-    else if (!stricmp(scanner.string, "checkswitchrange")) {
-      SCAN_FLAG(line.flags, UDMF_ML_CHECKSWITCHRANGE);
-    }
-    else if (!stricmp(scanner.string, "blockprojectiles")) {
-      SCAN_FLAG(line.flags, UDMF_ML_BLOCKPROJECTILES);
-    }
-    else if (!stricmp(scanner.string, "blockuse")) {
-      SCAN_FLAG(line.flags, UDMF_ML_BLOCKUSE);
-    }
-    else if (!stricmp(scanner.string, "blocksight")) {
-      SCAN_FLAG(line.flags, UDMF_ML_BLOCKSIGHT);
-    }
-    else if (!stricmp(scanner.string, "blockhitscan")) {
-      SCAN_FLAG(line.flags, UDMF_ML_BLOCKHITSCAN);
-    }
-    else if (!stricmp(scanner.string, "transparent")) {
-      SCAN_FLAG(line.flags, UDMF_ML_TRANSPARENT);
-    }
-    else if (!stricmp(scanner.string, "revealed")) {
-      SCAN_FLAG(line.flags, UDMF_ML_REVEALED);
-    }
-    else if (!stricmp(scanner.string, "noskywalls")) {
-      SCAN_FLAG(line.flags, UDMF_ML_NOSKYWALLS);
-    }
-    else if (!stricmp(scanner.string, "drawfullheight")) {
-      SCAN_FLAG(line.flags, UDMF_ML_DRAWFULLHEIGHT);
-    }
-    else if (!stricmp(scanner.string, "damagespecial")) {
-      SCAN_FLAG(line.flags, UDMF_ML_DAMAGESPECIAL);
-    }
-    else if (!stricmp(scanner.string, "deathspecial")) {
-      SCAN_FLAG(line.flags, UDMF_ML_DEATHSPECIAL);
-    }
-    else if (!stricmp(scanner.string, "blocklandmonsters")) {
-      SCAN_FLAG(line.flags, UDMF_ML_BLOCKLANDMONSTERS);
-    }
-    else if (!stricmp(scanner.string, "moreids")) {
-      SCAN_STRING(line.moreids);
-    }
-    else {
-      // known ignored fields:
-      // comment
-      // renderstyle
-      // arg0str
-      dsda_SkipValue(scanner);
-    }
+  switch (field->type) {
+    case UDMF_INT:
+      if (!lexer.MustGetInteger(*(int*) dest))
+        return false;
+      break;
+    case UDMF_FLOAT:
+      {
+        double decimal;
+        bool negative;
+
+        if (!lexer.MustGetFloat(decimal, negative))
+          return false;
+
+        *(float*) dest = decimal;
+      }
+      break;
+    case UDMF_FLAG:
+      if (!lexer.MustGetToken(TK_BoolConst))
+        return false;
+
+      if (lexer.token.boolean)
+        dsda_SetUDMFFlag(dest, flags_size, field->flag);
+      break;
+    case UDMF_STRING_N:
+      if (!lexer.MustGetToken(TK_StringConst))
+        return false;
+
+      dsda_CopyUDMFStringN((char*) dest, lexer.token, 8);
+      break;
+    case UDMF_STRING:
+      {
+        udmf_pending_string_t pending;
+
+        if (!lexer.MustGetToken(TK_StringConst))
+          return false;
+
+        pending.dest = dest;
+        pending.text = lexer.token.text;
+        pending.length = lexer.token.length;
+        pending.negative = false;
+        pending.escaped = true;
+        strings.push_back(pending);
+      }
+      break;
+    case UDMF_FLOAT_STRING:
+      {
+        udmf_pending_string_t pending;
+        double decimal;
+        bool negative;
+
+        if (!lexer.MustGetFloat(decimal, negative))
+          return false;
+
+        // The scanner drops the sign when scanning, and we need it back
+        pending.dest = dest;
+        pending.text = lexer.token.text;
+        pending.length = lexer.token.length;
+        pending.negative = decimal < 0;
+        pending.escaped = false;
+        strings.push_back(pending);
+      }
+      break;
   }
 
-  udmf_lines.push_back(line);
+  return lexer.MustGetToken(';');
 }
 
-static void dsda_ParseUDMFSideDef(Scanner &scanner) {
-  udmf_side_t side = { 0 };
+static bool dsda_DecodeUDMFBlock(UDMFLexer &lexer, udmf_block_kind_t kind, void* dest,
+                                 std::vector<udmf_pending_string_t> &strings) {
+  const udmf_block_type_t* type = &udmf_block_types[kind];
 
-  side.texturetop[0] = '-';
-  side.texturebottom[0] = '-';
-  side.texturemiddle[0] = '-';
-  side.scalex_top = 1.f;
-  side.scaley_top = 1.f;
-  side.scalex_mid = 1.f;
-  side.scaley_mid = 1.f;
-  side.scalex_bottom = 1.f;
-  side.scaley_bottom = 1.f;
+  if (!lexer.MustGetToken('{'))
+    return false;
 
-  scanner.MustGetToken('{');
-  while (!scanner.CheckToken('}')) {
-    scanner.MustGetToken(TK_Identifier);
+  while (!lexer.CheckToken('}')) {
+    const udmf_field_t* field;
 
-    if (!stricmp(scanner.string, "offsetx")) {
-      SCAN_INT(side.offsetx);
-    }
-    else if (!stricmp(scanner.string, "offsety")) {
-      SCAN_INT(side.offsety);
-    }
-    else if (!stricmp(scanner.string, "sector")) {
-      SCAN_INT(side.sector);
-    }
-    else if (!stricmp(scanner.string, "light")) {
-      SCAN_INT(side.light);
-    }
-    else if (!stricmp(scanner.string, "light_top")) {
-      SCAN_INT(side.light_top);
-    }
-    else if (!stricmp(scanner.string, "light_mid")) {
-      SCAN_INT(side.light_mid);
-    }
-    else if (!stricmp(scanner.string, "light_bottom")) {
-      SCAN_INT(side.light_bottom);
-    }
-    else if (!stricmp(scanner.string, "scalex_top")) {
-      SCAN_FLOAT(side.scalex_top);
-    }
-    else if (!stricmp(scanner.string, "scaley_top")) {
-      SCAN_FLOAT(side.scaley_top);
-    }
-    else if (!stricmp(scanner.string, "scalex_mid")) {
-      SCAN_FLOAT(side.scalex_mid);
-    }
-    else if (!stricmp(scanner.string, "scaley_mid")) {
-      SCAN_FLOAT(side.scaley_mid);
-    }
-    else if (!stricmp(scanner.string, "scalex_bottom")) {
-      SCAN_FLOAT(side.scalex_bottom);
-    }
-    else if (!stricmp(scanner.string, "scaley_bottom")) {
-      SCAN_FLOAT(side.scaley_bottom);
-    }
-    else if (!stricmp(scanner.string, "offsetx_top")) {
-      SCAN_FLOAT(side.offsetx_top);
-    }
-    else if (!stricmp(scanner.string, "offsety_top")) {
-      SCAN_FLOAT(side.offsety_top);
-    }
-    else if (!stricmp(scanner.string, "offsetx_mid")) {
-      SCAN_FLOAT(side.offsetx_mid);
-    }
-    else if (!stricmp(scanner.string, "offsety_mid")) {
-      SCAN_FLOAT(side.offsety_mid);
-    }
-    else if (!stricmp(scanner.string, "offsetx_bottom")) {
-      SCAN_FLOAT(side.offsetx_bottom);
-    }
-    else if (!stricmp(scanner.string, "offsety_bottom")) {
-      SCAN_FLOAT(side.offsety_bottom);
-    }
-    else if (!stricmp(scanner.string, "lightabsolute")) {
-      SCAN_FLAG(side.flags, UDMF_SF_LIGHTABSOLUTE);
-    }
-    else if (!stricmp(scanner.string, "lightfog")) {
-      SCAN_FLAG(side.flags, UDMF_SF_LIGHTFOG);
-    }
-    else if (!stricmp(scanner.string, "nofakecontrast")) {
-      SCAN_FLAG(side.flags, UDMF_SF_NOFAKECONTRAST);
-    }
-    else if (!stricmp(scanner.string, "smoothlighting")) {
-      SCAN_FLAG(side.flags, UDMF_SF_SMOOTHLIGHTING);
-    }
-    else if (!stricmp(scanner.string, "clipmidtex")) {
-      SCAN_FLAG(side.flags, UDMF_SF_CLIPMIDTEX);
-    }
-    else if (!stricmp(scanner.string, "wrapmidtex")) {
-      SCAN_FLAG(side.flags, UDMF_SF_WRAPMIDTEX);
-    }
-    else if (!stricmp(scanner.string, "nodecals")) {
-      SCAN_FLAG(side.flags, UDMF_SF_NODECALS);
-    }
-    else if (!stricmp(scanner.string, "lightabsolute_top")) {
-      SCAN_FLAG(side.flags, UDMF_SF_LIGHTABSOLUTETOP);
-    }
-    else if (!stricmp(scanner.string, "lightabsolute_mid")) {
-      SCAN_FLAG(side.flags, UDMF_SF_LIGHTABSOLUTEMID);
-    }
-    else if (!stricmp(scanner.string, "lightabsolute_bottom")) {
-      SCAN_FLAG(side.flags, UDMF_SF_LIGHTABSOLUTEBOTTOM);
-    }
-    else if (!stricmp(scanner.string, "texturetop")) {
-      SCAN_STRING_N(side.texturetop, 8);
-    }
-    else if (!stricmp(scanner.string, "texturebottom")) {
-      SCAN_STRING_N(side.texturebottom, 8);
-    }
-    else if (!stricmp(scanner.string, "texturemiddle")) {
-      SCAN_STRING_N(side.texturemiddle, 8);
-    }
-    else {
-      // known ignored fields:
-      // comment
-      // nogradient_top
-      // flipgradient_top
-      // clampgradient_top
-      // useowncolors_top
-      // uppercolor_top
-      // lowercolor_top
-      // nogradient_mid
-      // flipgradient_mid
-      // clampgradient_mid
-      // useowncolors_mid
-      // uppercolor_mid
-      // lowercolor_mid
-      // nogradient_bottom
-      // flipgradient_bottom
-      // clampgradient_bottom
-      // useowncolors_bottom
-      // uppercolor_bottom
-      // lowercolor_bottom
-      // useowncoloradd_top
-      // useowncoloradd_mid
-      // useowncoloradd_bottom
-      // coloradd_top
-      // coloradd_mid
-      // coloradd_bottom
-      // colorization_top
-      // colorization_mid
-      // colorization_bottom
-      dsda_SkipValue(scanner);
+    if (!lexer.MustGetToken(TK_Identifier))
+      return false;
+
+    field = dsda_LookupUDMFField(type, lexer.token.text, lexer.token.length);
+
+    if (field) {
+      if (!dsda_DecodeUDMFField(lexer, field, type->flags_size, (char*) dest, strings))
+        return false;
     }
+    else if (!lexer.SkipValue())
+      return false;
   }
 
-  udmf_sides.push_back(side);
+  return true;
 }
 
-static void dsda_ParseUDMFVertex(Scanner &scanner) {
-  udmf_vertex_t vertex = { 0 };
+typedef struct {
+  const char* data;
+  size_t length;
+  const udmf_block_t* blocks;
+  size_t num_blocks;
+  std::vector<udmf_pending_string_t> strings;
+  bool failed;
+} udmf_worker_t;
 
-  scanner.MustGetToken('{');
-  while (!scanner.CheckToken('}')) {
-    scanner.MustGetToken(TK_Identifier);
+static int dsda_DecodeUDMFBlocks(void* arg) {
+  udmf_worker_t* worker = (udmf_worker_t*) arg;
+  UDMFLexer lexer(worker->data, 0, worker->length);
+  size_t i;
 
-    if (!stricmp(scanner.string, "x")) {
-      SCAN_FLOAT_STRING(vertex.x);
-    }
-    else if (!stricmp(scanner.string, "y")) {
-      SCAN_FLOAT_STRING(vertex.y);
-    }
-    else {
-      // known ignored fields:
-      // zfloor
-      // zceiling
-      dsda_SkipValue(scanner);
+  worker->failed = false;
+
+  for (i = 0; i < worker->num_blocks; ++i) {
+    const udmf_block_t* block = &worker->blocks[i];
+
+    lexer.Seek(block->begin);
+
+    // The block must end exactly where the boundary scan said it would
+    if (
+      !dsda_DecodeUDMFBlock(lexer, block->kind, dsda_UDMFBlockData(block->kind, block->index),
+                            worker->strings) ||
+      lexer.token.pos + 1 != block->end
+    ) {
+      worker->failed = true;
+      break;
     }
   }
 
-  udmf_vertices.push_back(vertex);
+  return 0;
 }
 
-static void dsda_ParseUDMFSector(Scanner &scanner) {
-  udmf_sector_t sector = { 0 };
+//
+// Boundary scan
+//
 
-  sector.lightlevel = 160;
-  sector.xscalefloor = 1.f;
-  sector.yscalefloor = 1.f;
-  sector.xscaleceiling = 1.f;
-  sector.yscaleceiling = 1.f;
-  sector.gravity = "1.0";
-  sector.damageinterval = 32;
+// Find the end of a block whose opening brace has been consumed,
+// honouring strings and comments exactly like the tokenizer
+static size_t dsda_SkipUDMFBlock(const char* data, size_t pos, size_t length) {
+  int depth = 1;
 
-  scanner.MustGetToken('{');
-  while (!scanner.CheckToken('}')) {
-    scanner.MustGetToken(TK_Identifier);
+  while (pos < length) {
+    char cur = data[pos];
+    char next = pos + 1 < length ? data[pos + 1] : 0;
 
-    if (!stricmp(scanner.string, "heightfloor")) {
-      SCAN_INT(sector.heightfloor);
-    }
-    else if (!stricmp(scanner.string, "heightceiling")) {
-      SCAN_INT(sector.heightceiling);
-    }
-    else if (!stricmp(scanner.string, "lightlevel")) {
-      SCAN_INT(sector.lightlevel);
-    }
-    else if (!stricmp(scanner.string, "special")) {
-      SCAN_INT(sector.special);
-    }
-    else if (!stricmp(scanner.string, "id")) {
-      SCAN_INT(sector.id);
-    }
-    else if (!stricmp(scanner.string, "lightfloor")) {
-      SCAN_INT(sector.lightfloor);
-    }
-    else if (!stricmp(scanner.string, "lightceiling")) {
-      SCAN_INT(sector.lightceiling);
-    }
-    else if (!stricmp(scanner.string, "damageamount")) {
-      SCAN_INT(sector.damageamount);
-    }
-    else if (!stricmp(scanner.string, "damageinterval")) {
-      SCAN_INT(sector.damageinterval);
-    }
-    else if (!stricmp(scanner.string, "leakiness")) {
-      SCAN_INT(sector.leakiness);
-    }
-    else if (!stricmp(scanner.string, "xpanningfloor")) {
-      SCAN_FLOAT(sector.xpanningfloor);
-    }
-    else if (!stricmp(scanner.string, "ypanningfloor")) {
-      SCAN_FLOAT(sector.ypanningfloor);
-    }
-    else if (!stricmp(scanner.string, "xpanningceiling")) {
-      SCAN_FLOAT(sector.xpanningceiling);
-    }
-    else if (!stricmp(scanner.string, "ypanningceiling")) {
-      SCAN_FLOAT(sector.ypanningceiling);
-    }
-    else if (!stricmp(scanner.string, "xscalefloor")) {
-      SCAN_FLOAT(sector.xscalefloor);
-    }
-    else if (!stricmp(scanner.string, "yscalefloor")) {
-      SCAN_FLOAT(sector.yscalefloor);
-    }
-    else if (!stricmp(scanner.string, "xscaleceiling")) {
-      SCAN_FLOAT(sector.xscaleceiling);
-    }
-    else if (!stricmp(scanner.string, "yscaleceiling")) {
-      SCAN_FLOAT(sector.yscaleceiling);
-    }
-    else if (!stricmp(scanner.string, "rotationfloor")) {
-      SCAN_FLOAT(sector.rotationfloor);
-    }
-    else if (!stricmp(scanner.string, "rotationceiling")) {
-      SCAN_FLOAT(sector.rotationceiling);
-    }
-    else if (!stricmp(scanner.string, "gravity")) {
-      SCAN_FLOAT_STRING(sector.gravity);
-    }
-    else if (!stricmp(scanner.string, "lightfloorabsolute")) {
-      SCAN_FLAG(sector.flags, UDMF_SECF_LIGHTFLOORABSOLUTE);
-    }
-    else if (!stricmp(scanner.string, "lightceilingabsolute")) {
-      SCAN_FLAG(sector.flags, UDMF_SECF_LIGHTCEILINGABSOLUTE);
-    }
-    else if (!stricmp(scanner.string, "silent")) {
-      SCAN_FLAG(sector.flags, UDMF_SECF_SILENT);
-    }
-    else if (!stricmp(scanner.string, "nofallingdamage")) {
-      SCAN_FLAG(sector.flags, UDMF_SECF_NOFALLINGDAMAGE);
-    }
-    else if (!stricmp(scanner.string, "dropactors")) {
-      SCAN_FLAG(sector.flags, UDMF_SECF_DROPACTORS);
-    }
-    else if (!stricmp(scanner.string, "norespawn")) {
-      SCAN_FLAG(sector.flags, UDMF_SECF_NORESPAWN);
-    }
-    else if (!stricmp(scanner.string, "hidden")) {
-      SCAN_FLAG(sector.flags, UDMF_SECF_HIDDEN);
-    }
-    else if (!stricmp(scanner.string, "waterzone")) {
-      SCAN_FLAG(sector.flags, UDMF_SECF_WATERZONE);
-    }
-    else if (!stricmp(scanner.string, "damageterraineffect")) {
-      SCAN_FLAG(sector.flags, UDMF_SECF_DAMAGETERRAINEFFECT);
-    }
-    else if (!stricmp(scanner.string, "damagehazard")) {
-      SCAN_FLAG(sector.flags, UDMF_SECF_DAMAGEHAZARD);
-    }
-    else if (!stricmp(scanner.string, "noattack")) {
-      SCAN_FLAG(sector.flags, UDMF_SECF_NOATTACK);
-    }
-    else if (!stricmp(scanner.string, "texturefloor")) {
-      SCAN_STRING_N(sector.texturefloor, 8);
-    }
-    else if (!stricmp(scanner.string, "textureceiling")) {
-      SCAN_STRING_N(sector.textureceiling, 8);
-    }
-    else if (!stricmp(scanner.string, "moreids")) {
-      SCAN_STRING(sector.moreids);
-    }
-    else {
-      // known ignored fields:
-      // comment
-      // ceilingplane_a
-      // ceilingplane_b
-      // ceilingplane_c
-      // ceilingplane_d
-      // floorplane_a
-      // floorplane_b
-      // floorplane_c
-      // floorplane_d
-      // alphafloor
-      // alphaceiling
-      // renderstylefloor
-      // renderstyleceiling
-      // lightcolor
-      // fadecolor
-      // desaturation
-      // soundsequence
-      // damagetype
-      // floorterrain
-      // ceilingterrain
-      // portal_ceil_blocksound
-      // portal_ceil_disabled
-      // portal_ceil_nopass
-      // portal_ceil_norender
-      // portal_ceil_overlaytype
-      // portal_floor_blocksound
-      // portal_floor_disabled
-      // portal_floor_nopass
-      // portal_floor_norender
-      // portal_floor_overlaytype
-      // floor_reflect
-      // ceiling_reflect
-      // fogdensity
-      // floorglowcolor
-      // floorglowheight
-      // ceilingglowcolor
-      // ceilingglowheight
-      // color_floor
-      // color_ceiling
-      // color_walltop
-      // color_wallbottom
-      // color_sprites
-      // coloradd_floor
-      // coloradd_ceiling
-      // coloradd_sprites
-      // coloradd_walls
-      // colorization_floor
-      // colorization_ceiling
-      // noskywalls
-      // healthfloor
-      // healthfloorgroup
-      // healthceiling
-      // healthceilinggroup
-      dsda_SkipValue(scanner);
-    }
+    if (cur == '"') {
+      for (++pos; pos < length && data[pos] != '"'; ++pos)
+        if (data[pos] == '\\')
+          ++pos;
+    }
+    else if (cur == '/' && next == '/') {
+      while (pos < length && data[pos] != '\n' && data[pos] != '\r')
+        ++pos;
+    }
+    else if (cur == '/' && next == '*') {
+      for (pos += 2; pos < length; ++pos)
+        if (data[pos] == '*' && pos + 1 < length && data[pos + 1] == '/') {
+          ++pos;
+          break;
+        }
+    }
+    else if (cur == '{')
+      ++depth;
+    else if (cur == '}' && !--depth)
+      return pos + 1;
+
+    ++pos;
   }
 
-  udmf_sectors.push_back(sector);
+  return length;
 }
 
-static void dsda_ParseUDMFThing(Scanner &scanner) {
-  udmf_thing_t thing = { 0 };
+static void dsda_InitUDMFLine(udmf_line_t* line) {
+  memset(line, 0, sizeof(*line));
 
-  thing.gravity = "1.0";
-  thing.health = "1.0";
-  thing.floatbobphase = -1;
-  thing.alpha = 1.0;
+  line->id = -1;
+  line->sideback = -1;
+  line->alpha = 1.0;
+}
 
-  scanner.MustGetToken('{');
-  while (!scanner.CheckToken('}')) {
-    scanner.MustGetToken(TK_Identifier);
+static void dsda_InitUDMFSide(udmf_side_t* side) {
+  memset(side, 0, sizeof(*side));
 
-    if (!stricmp(scanner.string, "id")) {
-      SCAN_INT(thing.id);
-    }
-    else if (!stricmp(scanner.string, "angle")) {
-      SCAN_INT(thing.angle);
-    }
-    else if (!stricmp(scanner.string, "type")) {
-      SCAN_INT(thing.type);
-    }
-    else if (!stricmp(scanner.string, "special")) {
-      SCAN_INT(thing.special);
-    }
-    else if (!stricmp(scanner.string, "arg0")) {
-      SCAN_INT(thing.arg0);
-    }
-    else if (!stricmp(scanner.string, "arg1")) {
-      SCAN_INT(thing.arg1);
-    }
-    else if (!stricmp(scanner.string, "arg2")) {
-      SCAN_INT(thing.arg2);
-    }
-    else if (!stricmp(scanner.string, "arg3")) {
-      SCAN_INT(thing.arg3);
-    }
-    else if (!stricmp(scanner.string, "arg4")) {
-      SCAN_INT(thing.arg4);
-    }
-    else if (!stricmp(scanner.string, "floatbobphase")) {
-      SCAN_INT(thing.floatbobphase);
-    }
-    else if (!stricmp(scanner.string, "x")) {
-      SCAN_FLOAT_STRING(thing.x);
-    }
-    else if (!stricmp(scanner.string, "y")) {
-      SCAN_FLOAT_STRING(thing.y);
-    }
-    else if (!stricmp(scanner.string, "height")) {
-      SCAN_FLOAT_STRING(thing.height);
-    }
-    else if (!stricmp(scanner.string, "gravity")) {
-      SCAN_FLOAT_STRING(thing.gravity);
-    }
-    else if (!stricmp(scanner.string, "health")) {
-      SCAN_FLOAT_STRING(thing.health);
-    }
-    else if (!stricmp(scanner.string, "scalex")) {
-      SCAN_FLOAT(thing.scalex);
-    }
-    else if (!stricmp(scanner.string, "scaley")) {
-      SCAN_FLOAT(thing.scaley);
-    }
-    else if (!stricmp(scanner.string, "scale")) {
-      SCAN_FLOAT(thing.scale);
-    }
-    else if (!stricmp(scanner.string, "alpha")) {
-      SCAN_FLOAT(thing.alpha);
-    }
-    else if (!stricmp(scanner.string, "skill1")) {
-      SCAN_FLAG(thing.flags, UDMF_TF_SKILL1);
-    }
-    else if (!stricmp(scanner.string, "skill2")) {
-      SCAN_FLAG(thing.flags, UDMF_TF_SKILL2);
-    }
-    else if (!stricmp(scanner.string, "skill3")) {
-      SCAN_FLAG(thing.flags, UDMF_TF_SKILL3);
-    }
-    else if (!stricmp(scanner.string, "skill4")) {
-      SCAN_FLAG(thing.flags, UDMF_TF_SKILL4);
-    }
-    else if (!stricmp(scanner.string, "skill5")) {
-      SCAN_FLAG(thing.flags, UDMF_TF_SKILL5);
-    }
-    else if (!stricmp(scanner.string, "ambush")) {
-      SCAN_FLAG(thing.flags, UDMF_TF_AMBUSH);
-    }
-    else if (!stricmp(scanner.string, "single")) {
-      SCAN_FLAG(thing.flags, UDMF_TF_SINGLE);
-    }
-    else if (!stricmp(scanner.string, "dm")) {
-      SCAN_FLAG(thing.flags, UDMF_TF_DM);
-    }
-    else if (!stricmp(scanner.string, "coop")) {
-      SCAN_FLAG(thing.flags, UDMF_TF_COOP);
-    }
-    else if (!stricmp(scanner.string, "friend")) {
-      SCAN_FLAG(thing.flags, UDMF_TF_FRIEND);
-    }
-    else if (!stricmp(scanner.string, "dormant")) {
-      SCAN_FLAG(thing.flags, UDMF_TF_DORMANT);
-    }
-    else if (!stricmp(scanner.string, "class1")) {
-      SCAN_FLAG(thing.flags, UDMF_TF_CLASS1);
-    }
-    else if (!stricmp(scanner.string, "class2")) {
-      SCAN_FLAG(thing.flags, UDMF_TF_CLASS2);
-    }
-    else if (!stricmp(scanner.string, "class3")) {
-      SCAN_FLAG(thing.flags, UDMF_TF_CLASS3);
-    }
-    else if (!stricmp(scanner.string, "standing")) {
-      SCAN_FLAG(thing.flags, UDMF_TF_STANDING);
-    }
-    else if (!stricmp(scanner.string, "strifeally")) {
-      SCAN_FLAG(thing.flags, UDMF_TF_STRIFEALLY);
-    }
-    else if (!stricmp(scanner.string, "translucent")) {
-      SCAN_FLAG(thing.flags, UDMF_TF_TRANSLUCENT);
-    }
-    else if (!stricmp(scanner.string, "invisible")) {
-      SCAN_FLAG(thing.flags, UDMF_TF_INVISIBLE);
+  side->texturetop[0] = '-';
+  side->texturebottom[0] = '-';
+  side->texturemiddle[0] = '-';
+  side->scalex_top = 1.f;
+  side->scaley_top = 1.f;
+  side->scalex_mid = 1.f;
+  side->scaley_mid = 1.f;
+  side->scalex_bottom = 1.f;
+  side->scaley_bottom = 1.f;
+}
+
+static void dsda_InitUDMFVertex(udmf_vertex_t* vertex) {
+  memset(vertex, 0, sizeof(*vertex));
+}
+
+static void dsda_InitUDMFSector(udmf_sector_t* sector) {
+  memset(sector, 0, sizeof(*sector));
+
+  sector->lightlevel = 160;
+  sector->xscalefloor = 1.f;
+  sector->yscalefloor = 1.f;
+  sector->xscaleceiling = 1.f;
+  sector->yscaleceiling = 1.f;
+  sector->gravity = "1.0";
+  sector->damageinterval = 32;
+}
+
+static void dsda_InitUDMFThing(udmf_thing_t* thing) {
+  memset(thing, 0, sizeof(*thing));
+
+  thing->gravity = "1.0";
+  thing->health = "1.0";
+  thing->floatbobphase = -1;
+  thing->alpha = 1.0;
+}
+
+static void* dsda_AppendUDMFBlock(udmf_block_kind_t kind) {
+  switch (kind) {
+    case udmf_block_line:
+      udmf_lines.resize(udmf_lines.size() + 1);
+      dsda_InitUDMFLine(&udmf_lines.back());
+      return &udmf_lines.back();
+    case udmf_block_side:
+      udmf_sides.resize(udmf_sides.size() + 1);
+      dsda_InitUDMFSide(&udmf_sides.back());
+      return &udmf_sides.back();
+    case udmf_block_vertex:
+      udmf_vertices.resize(udmf_vertices.size() + 1);
+      dsda_InitUDMFVertex(&udmf_vertices.back());
+      return &udmf_vertices.back();
+    case udmf_block_sector:
+      udmf_sectors.resize(udmf_sectors.size() + 1);
+      dsda_InitUDMFSector(&udmf_sectors.back());
+      return &udmf_sectors.back();
+    default:
+      udmf_things.resize(udmf_things.size() + 1);
+      dsda_InitUDMFThing(&udmf_things.back());
+      return &udmf_things.back();
+  }
+}
+
+static void dsda_StoreUDMFString(const udmf_pending_string_t* pending);
+
+// Walk the top level of the map. Normally this only records where each
+// block starts and ends; in sequential mode each block is decoded on the
+// spot, exactly as the Scanner based parser did.
+static void dsda_ScanUDMFBlocks(UDMFLexer &lexer, std::vector<udmf_block_t> &blocks,
+                                size_t* counts, size_t length, bool sequential) {
+  while (lexer.TokensLeft()) {
+    udmf_block_t block;
+    int kind;
+
+    if (!lexer.MustGetToken(TK_Identifier))
+      return;
+
+    if (lexer.TokenIs("namespace")) {
+      std::string name;
+
+      if (!lexer.MustGetToken('=') || !lexer.MustGetToken(TK_StringConst))
+        return;
+
+      lexer.TokenString(name);
+      if (stricmp(name.c_str(), "zdoom")) {
+        lexer.ErrorF("Unknown UDMF namespace \"%s\"", name.c_str());
+        return;
+      }
+
+      if (!lexer.MustGetToken(';'))
+        return;
+
+      continue;
     }
-    else if (!stricmp(scanner.string, "countsecret")) {
-      SCAN_FLAG(thing.flags, UDMF_TF_COUNTSECRET);
+
+    for (kind = 0; kind < udmf_block_count; ++kind)
+      if (lexer.TokenIs(udmf_block_types[kind].name))
+        break;
+
+    if (kind == udmf_block_count) {
+      if (!lexer.SkipValue())
+        return;
+
+      continue;
     }
-    else {
-      // known ignored fields:
-      // comment
-      // skill6-16
-      // class4-16
-      // conversation
-      // arg0str
-      // renderstyle
-      // fillcolor
-      // score
-      // pitch
-      // roll
-      dsda_SkipValue(scanner);
+
+    if (sequential) {
+      std::vector<udmf_pending_string_t> strings;
+      size_t i;
+
+      if (!dsda_DecodeUDMFBlock(lexer, (udmf_block_kind_t) kind,
+                                dsda_AppendUDMFBlock((udmf_block_kind_t) kind), strings))
+        return;
+
+      for (i = 0; i < strings.size(); ++i)
+        dsda_StoreUDMFString(&strings[i]);
+
+      continue;
     }
-  }
 
-  udmf_things.push_back(thing);
+    if (!lexer.MustGetToken('{'))
+      return;
+
+    block.kind = (udmf_block_kind_t) kind;
+    block.index = counts[kind]++;
+    block.begin = lexer.token.pos;
+    block.end = dsda_SkipUDMFBlock(lexer.data, block.begin + 1, length);
+    blocks.push_back(block);
+
+    lexer.Seek(block.end);
+  }
 }
 
-static void dsda_ParseUDMFIdentifier(Scanner &scanner) {
-  scanner.MustGetToken(TK_Identifier);
+// Below this many blocks the threads cost more than they save
+#define UDMF_BLOCKS_PER_WORKER 2048
+#define UDMF_MAX_WORKERS 8
 
-  if (!stricmp(scanner.string, "namespace")) {
-    scanner.MustGetToken('=');
-    scanner.MustGetToken(TK_StringConst);
+static void dsda_DecodeUDMF(const char* data, size_t length, const std::vector<udmf_block_t> &blocks,
+                            std::vector<udmf_worker_t> &workers) {
+  std::vector<SDL_Thread*> threads;
+  size_t num_workers, first, i;
 
-    if (stricmp(scanner.string, "zdoom"))
-      scanner.ErrorF("Unknown UDMF namespace \"%s\"", scanner.string);
+  num_workers = blocks.size() / UDMF_BLOCKS_PER_WORKER;
+  if (num_workers > (size_t) SDL_GetCPUCount())
+    num_workers = SDL_GetCPUCount();
+  if (num_workers > UDMF_MAX_WORKERS)
+    num_workers = UDMF_MAX_WORKERS;
+  if (num_workers < 1)
+    num_workers = 1;
 
-    scanner.MustGetToken(';');
-  }
-  else if (!stricmp(scanner.string, "linedef")) {
-    dsda_ParseUDMFLineDef(scanner);
-  }
-  else if (!stricmp(scanner.string, "sidedef")) {
-    dsda_ParseUDMFSideDef(scanner);
-  }
-  else if (!stricmp(scanner.string, "vertex")) {
-    dsda_ParseUDMFVertex(scanner);
-  }
-  else if (!stricmp(scanner.string, "sector")) {
-    dsda_ParseUDMFSector(scanner);
-  }
-  else if (!stricmp(scanner.string, "thing")) {
-    dsda_ParseUDMFThing(scanner);
+  workers.resize(num_workers);
+  threads.resize(num_workers);
+
+  first = 0;
+  for (i = 0; i < num_workers; ++i) {
+    size_t last = blocks.size() * (i + 1) / num_workers;
+
+    workers[i].data = data;
+    workers[i].length = length;
+    workers[i].blocks = blocks.empty() ? NULL : &blocks[first];
+    workers[i].num_blocks = last - first;
+
+    first = last;
   }
-  else {
-    dsda_SkipValue(scanner);
+
+  // The main thread takes the first share itself
+  for (i = 1; i < num_workers; ++i) {
+    threads[i] = SDL_CreateThread(dsda_DecodeUDMFBlocks, "udmf_decode", &workers[i]);
+    if (!threads[i])
+      dsda_DecodeUDMFBlocks(&workers[i]);
   }
+
+  dsda_DecodeUDMFBlocks(&workers[0]);
+
+  for (i = 1; i < num_workers; ++i)
+    if (threads[i])
+      SDL_WaitThread(threads[i], NULL);
 }
 
-udmf_t udmf;
+static void dsda_StoreUDMFString(const udmf_pending_string_t* pending) {
+  char* buffer = (char*) Z_MallocLevel(pending->length + 2);
+  char* p = buffer;
 
-void dsda_ParseUDMF(const unsigned char* buffer, size_t length, udmf_errorfunc err) {
-  Scanner scanner((const char*) buffer, length);
+  if (pending->negative)
+    *p++ = '-';
+
+  memcpy(p, pending->text, pending->length);
+  p[pending->length] = '\0';
+
+  if (pending->escaped)
+    Scanner::Unescape(p);
 
-  scanner.SetErrorCallback(err);
+  *(char**) pending->dest = buffer;
+}
+
+udmf_t udmf;
 
+static void dsda_ClearUDMF(void) {
   udmf_lines.clear();
   udmf_sides.clear();
   udmf_vertices.clear();
   udmf_sectors.clear();
   udmf_things.clear();
+}
+
+void dsda_ParseUDMF(const unsigned char* buffer, size_t length, udmf_errorfunc err) {
+  static bool key_tables_built;
+  const char* data = (const char*) buffer;
+  std::vector<udmf_block_t> blocks;
+  std::vector<udmf_worker_t> workers;
+  size_t counts[udmf_block_count] = { 0 };
+  bool failed;
+  size_t i, j;
+
+  if (!key_tables_built) {
+    for (i = 0; i < udmf_block_count; ++i)
+      dsda_BuildUDMFKeyTable(&udmf_block_types[i]);
+
+    key_tables_built = true;
+  }
+
+  dsda_ClearUDMF();
 
-  while (scanner.TokensLeft())
-    dsda_ParseUDMFIdentifier(scanner);
+  UDMFLexer lexer(data, 0, length);
+
+  dsda_ScanUDMFBlocks(lexer, blocks, counts, length, false);
+  failed = lexer.failed;
+
+  if (!failed) {
+    udmf_lines.resize(counts[udmf_block_line]);
+    udmf_sides.resize(counts[udmf_block_side]);
+    udmf_vertices.resize(counts[udmf_block_vertex]);
+    udmf_sectors.resize(counts[udmf_block_sector]);
+    udmf_things.resize(counts[udmf_block_thing]);
+
+    for (i = 0; i < udmf_lines.size(); ++i)
+      dsda_InitUDMFLine(&udmf_lines[i]);
+    for (i = 0; i < udmf_sides.size(); ++i)
+      dsda_InitUDMFSide(&udmf_sides[i]);
+    for (i = 0; i < udmf_vertices.size(); ++i)
+      dsda_InitUDMFVertex(&udmf_vertices[i]);
+    for (i = 0; i < udmf_sectors.size(); ++i)
+      dsda_InitUDMFSector(&udmf_sectors[i]);
+    for (i = 0; i < udmf_things.size(); ++i)
+      dsda_InitUDMFThing(&udmf_things[i]);
+
+    dsda_DecodeUDMF(data, length, blocks, workers);
+
+    for (i = 0; i < workers.size(); ++i)
+      failed |= workers[i].failed;
+  }
+
+  if (failed) {
+    // The map is malformed somewhere. Parse it again in one pass, so that
+    // the error (or the lenient result) is exactly what the Scanner gave.
+    dsda_ClearUDMF();
+
+    lexer = UDMFLexer(data, 0, length);
+    dsda_ScanUDMFBlocks(lexer, blocks, counts, length, true);
+
+    if (lexer.failed)
+      err("%s", lexer.error);
+  }
+  else {
+    for (i = 0; i < workers.size(); ++i)
+      for (j = 0; j < workers[i].strings.size(); ++j)
+        dsda_StoreUDMFString(&workers[i].strings[j]);
+  }
 
   if (
     udmf_lines.empty() ||
@@ -875,8 +1487,10 @@ void dsda_ParseUDMF(const unsigned char* buffer, size_t length, udmf_errorfunc e
     udmf_vertices.empty() ||
     udmf_sectors.empty() ||
     udmf_things.empty()
-  )
-    scanner.ErrorF("Insufficient UDMF data");
+  ) {
+    lexer.ErrorF("Insufficient UDMF data");
+    err("%s", lexer.error);
+  }
 
   udmf.lines = &udmf_lines[0];
   udmf.num_lines = udmf_lines.size();
@@ -0,0 +1,359 @@
+/* Emacs style mode select   -*- C -*-
+ *-----------------------------------------------------------------------------
+ *
+ *
+ *  PrBoom: a Doom port merged with LxDoom and LSDLDoom
+ *  based on BOOM, a modified and improved DOOM engine
+ *  Copyright (C) 1999 by
+ *  id Software, Chi Hoang, Lee Killough, Jim Flynn, Rand Phares, Ty Halderman
+ *  Copyright (C) 1999-2000 by
+ *  Jess Haas, Nicolas Kalkhof, Colin Phipps, Florian Schulze
+ *  Copyright 2005, 2006 by
+ *  Florian Schulze, Colin Phipps, Neil Stevens, Andrey Budko
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ *  02111-1307, USA.
+ *
+ * DESCRIPTION:
+ *   Texture atlas for UI patches
+ *
+ *   Small patches drawn by the status bar, HUD fonts and menus are packed
+ *   into a few large textures the first time they are drawn. Their quads
+ *   are then collected into one vertex array and drawn together, so a
+ *   line of text costs one bind and one draw call instead of one of each
+ *   per glyph. Anything else that draws must flush the batch first, so
+ *   that the order of drawing doesn't change.
+ *
+ *---------------------------------------------------------------------
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "gl_opengl.h"
+
+#include "z_zone.h"
+#include <string.h>
+
+#include "v_video.h"
+#include "r_main.h"
+#include "r_patch.h"
+#include "gl_intern.h"
+#include "gl_struct.h"
+#include "lprintf.h"
+#include "e6y.h"
+
+#define ATLAS_PAGE_SIZE 1024
+#define ATLAS_MAX_PAGES 8
+#define ATLAS_MAX_PATCH_SIZE 128
+#define ATLAS_HASH_SIZE 1024
+
+// Transparent border around each patch
+#define ATLAS_PADDING 1
+
+typedef struct
+{
+  GLuint texid;
+  int shelf_x, shelf_y;
+  int shelf_height;
+} atlas_page_t;
+
+typedef struct
+{
+  int lump;
+  int cm;
+  int page; // -1 if there was no room for it
+  float u1, v1, u2, v2;
+  int next; // index + 1 of the next entry in the hash chain
+} atlas_entry_t;
+
+typedef struct
+{
+  GLfloat x, y;
+  GLfloat u, v;
+} ui_batch_vertex_t;
+
+static atlas_page_t atlas_pages[ATLAS_MAX_PAGES];
+static int atlas_num_pages;
+static int atlas_page_size;
+
+static atlas_entry_t *atlas_entries;
+static int atlas_num_entries;
+static int atlas_max_entries;
+static int atlas_hash[ATLAS_HASH_SIZE]; // index + 1 of the first entry
+
+static struct
+{
+  int page;
+  ui_batch_vertex_t *vertices;
+  int count;
+  int size;
+} ui_batch;
+
+static int gld_AtlasNewPage(void)
+{
+  atlas_page_t *page;
+  unsigned char *blank;
+
+  if (atlas_num_pages >= ATLAS_MAX_PAGES)
+    return -1;
+
+  if (!atlas_page_size)
+    atlas_page_size = MIN(ATLAS_PAGE_SIZE, gl_max_texture_size);
+
+  page = &atlas_pages[atlas_num_pages];
+  page->shelf_x = 0;
+  page->shelf_y = 0;
+  page->shelf_height = 0;
+
+  blank = Z_Calloc(1, atlas_page_size * atlas_page_size * 4);
+
+  glGenTextures(1, &page->texid);
+  glBindTexture(GL_TEXTURE_2D, page->texid);
+  glTexImage2D(GL_TEXTURE_2D, 0, gl_tex_format,
+    atlas_page_size, atlas_page_size,
+    0, GL_RGBA, GL_UNSIGNED_BYTE, blank);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  gld_ResetLastTexture();
+
+  Z_Free(blank);
+
+  lprintf(LO_DEBUG, "gld_AtlasNewPage: page %d (%dx%d)\n",
+    atlas_num_pages, atlas_page_size, atlas_page_size);
+
+  return atlas_num_pages++;
+}
+
+// Patches are placed left to right in rows as high as the tallest patch
+// in them, which wastes little space with glyphs of similar height.
+static dboolean gld_AtlasAllocate(atlas_page_t *page, int width, int height, int *x, int *y)
+{
+  if (page->shelf_x + width > atlas_page_size)
+  {
+    page->shelf_y += page->shelf_height;
+    page->shelf_x = 0;
+    page->shelf_height = 0;
+  }
+
+  if (page->shelf_y + height > atlas_page_size)
+    return false;
+
+  *x = page->shelf_x;
+  *y = page->shelf_y;
+  page->shelf_x += width;
+  page->shelf_height = MAX(page->shelf_height, height);
+
+  return true;
+}
+
+static void gld_AtlasUploadPatch(GLTexture *gltexture, int cm, atlas_entry_t *entry)
+{
+  int width = gltexture->realtexwidth;
+  int height = gltexture->realtexheight;
+  int x, y;
+  unsigned char *buffer;
+
+  entry->page = atlas_num_pages - 1;
+  if (entry->page < 0 ||
+      !gld_AtlasAllocate(&atlas_pages[entry->page],
+        width + 2 * ATLAS_PADDING, height + 2 * ATLAS_PADDING, &x, &y))
+  {
+    entry->page = gld_AtlasNewPage();
+    if (entry->page < 0 ||
+        !gld_AtlasAllocate(&atlas_pages[entry->page],
+          width + 2 * ATLAS_PADDING, height + 2 * ATLAS_PADDING, &x, &y))
+    {
+      entry->page = -1;
+      return;
+    }
+  }
+
+  x += ATLAS_PADDING;
+  y += ATLAS_PADDING;
+
+  // the same conversion as gld_BindPatch, laid out in the texture buffer
+  buffer = Z_Calloc(1, gltexture->buffer_size);
+  gld_AddPatchToTexture(gltexture, buffer, R_PatchByNum(gltexture->index), 0, 0, cm, 0);
+  if (gltexture->flags & GLTEXTURE_HASHOLES)
+    SmoothEdges(buffer, gltexture->buffer_width, gltexture->buffer_height);
+
+  glBindTexture(GL_TEXTURE_2D, atlas_pages[entry->page].texid);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, gltexture->buffer_width);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height,
+    GL_RGBA, GL_UNSIGNED_BYTE, buffer);
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  gld_ResetLastTexture();
+
+  Z_Free(buffer);
+
+  entry->u1 = (float)x / atlas_page_size;
+  entry->v1 = (float)y / atlas_page_size;
+  entry->u2 = (float)(x + width) / atlas_page_size;
+  entry->v2 = (float)(y + height) / atlas_page_size;
+}
+
+static atlas_entry_t *gld_AtlasGetPatch(GLTexture *gltexture, int cm)
+{
+  int lump = gltexture->index;
+  int hash = (lump * 31 + cm) & (ATLAS_HASH_SIZE - 1);
+  atlas_entry_t *entry;
+  int i;
+
+  for (i = atlas_hash[hash]; i; i = atlas_entries[i - 1].next)
+  {
+    entry = &atlas_entries[i - 1];
+    if (entry->lump == lump && entry->cm == cm)
+      return entry;
+  }
+
+  if (atlas_num_entries >= atlas_max_entries)
+  {
+    atlas_max_entries = (atlas_max_entries ? atlas_max_entries * 2 : 256);
+    atlas_entries = Z_Realloc(atlas_entries, atlas_max_entries * sizeof(atlas_entries[0]));
+  }
+
+  entry = &atlas_entries[atlas_num_entries++];
+  entry->lump = lump;
+  entry->cm = cm;
+  entry->next = atlas_hash[hash];
+  atlas_hash[hash] = atlas_num_entries;
+
+  gld_AtlasUploadPatch(gltexture, cm, entry);
+
+  return entry;
+}
+
+// Only plain palette conversions can be shared: hires replacements,
+// indexed textures and patches drawn through Boom colormaps keep their
+// own textures.
+static dboolean gld_AtlasEligible(GLTexture *gltexture)
+{
+  if (gltexture->textype != GLDT_PATCH)
+    return false;
+
+  if (gltexture->flags & (GLTEXTURE_INDEXED | GLTEXTURE_HIRES))
+    return false;
+
+#ifdef HAVE_LIBSDL2_IMAGE
+  // gld_BindPatch hasn't looked for a hires version yet
+  if (!(gltexture->flags & GLTEXTURE_HASNOHIRES))
+    return false;
+#endif
+
+  if (gl_boom_colormaps && use_boom_cm)
+    return false;
+
+  return gltexture->realtexwidth <= ATLAS_MAX_PATCH_SIZE &&
+         gltexture->realtexheight <= ATLAS_MAX_PATCH_SIZE;
+}
+
+dboolean gld_BatchUIPatch(GLTexture *gltexture, int cm,
+                          float x, float y, float width, float height, dboolean flip)
+{
+  atlas_entry_t *entry;
+  ui_batch_vertex_t *v;
+  float u1, u2;
+
+  if (!gld_AtlasEligible(gltexture))
+    return false;
+
+  entry = gld_AtlasGetPatch(gltexture, cm);
+  if (entry->page < 0)
+    return false;
+
+  if (ui_batch.count && ui_batch.page != entry->page)
+    gld_FlushUIBatch();
+
+  if (ui_batch.count + 6 > ui_batch.size)
+  {
+    ui_batch.size = (ui_batch.size ? ui_batch.size * 2 : 1536);
+    ui_batch.vertices = Z_Realloc(ui_batch.vertices, ui_batch.size * sizeof(ui_batch.vertices[0]));
+  }
+
+  ui_batch.page = entry->page;
+
+  if (flip)
+  {
+    u1 = entry->u2;
+    u2 = entry->u1;
+  }
+  else
+  {
+    u1 = entry->u1;
+    u2 = entry->u2;
+  }
+
+  v = &ui_batch.vertices[ui_batch.count];
+  v[0].x = x;         v[0].y = y;          v[0].u = u1; v[0].v = entry->v1;
+  v[1].x = x;         v[1].y = y + height; v[1].u = u1; v[1].v = entry->v2;
+  v[2].x = x + width; v[2].y = y;          v[2].u = u2; v[2].v = entry->v1;
+  v[3] = v[2];
+  v[4] = v[1];
+  v[5].x = x + width; v[5].y = y + height; v[5].u = u2; v[5].v = entry->v2;
+  ui_batch.count += 6;
+
+  return true;
+}
+
+void gld_FlushUIBatch(void)
+{
+  if (!ui_batch.count)
+    return;
+
+  glBindTexture(GL_TEXTURE_2D, atlas_pages[ui_batch.page].texid);
+  gld_ResetLastTexture();
+
+  // e6y: workaround for some on-board Intel video cards
+  glColor3f(1.0f, 1.0f, 1.0f);
+
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+  glVertexPointer(2, GL_FLOAT, sizeof(ui_batch.vertices[0]), &ui_batch.vertices[0].x);
+  glTexCoordPointer(2, GL_FLOAT, sizeof(ui_batch.vertices[0]), &ui_batch.vertices[0].u);
+
+  glDrawArrays(GL_TRIANGLES, 0, ui_batch.count);
+
+  glDisableClientState(GL_VERTEX_ARRAY);
+  glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+
+  ui_batch.count = 0;
+}
+
+void gld_CleanAtlas(void)
+{
+  int i;
+
+  // the batch refers to pages that are about to go
+  ui_batch.count = 0;
+
+  for (i = 0; i < atlas_num_pages; i++)
+  {
+    if (atlas_pages[i].texid)
+      glDeleteTextures(1, &atlas_pages[i].texid);
+    atlas_pages[i].texid = 0;
+  }
+  atlas_num_pages = 0;
+  atlas_page_size = 0;
+
+  atlas_num_entries = 0;
+  memset(atlas_hash, 0, sizeof(atlas_hash));
+
+  gld_ResetLastTexture();
+}
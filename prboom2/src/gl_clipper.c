@@ -74,108 +74,157 @@
 #include "gl_intern.h"
 #include "r_main.h"
 #include "e6y.h"
+#include "i_system.h"
+#include "lprintf.h"
+#include "m_file.h"
+
+#include "dsda/args.h"
 
 float frustum[6][4];
 
-typedef struct clipnode_s
+// The clipped ranges, sorted, with a gap of at least one between each
+// range and the next, so that both the starts and the ends are in order
+// and can be binary searched
+typedef struct
 {
-  struct clipnode_s *prev, *next;
   angle_t start, end;
-} clipnode_t;
+} cliprange_t;
 
-clipnode_t *freelist;
-clipnode_t *clipnodes;
-clipnode_t *cliphead;
+static cliprange_t *clipranges;
+static int numclipranges;
+static int maxclipranges;
 
-static clipnode_t * gld_clipnode_GetNew(void);
-static clipnode_t * gld_clipnode_NewRange(angle_t start, angle_t end);
 static dboolean gld_clipper_IsRangeVisible(angle_t startAngle, angle_t endAngle);
 static void gld_clipper_AddClipRange(angle_t start, angle_t end);
-static void gld_clipper_RemoveRange(clipnode_t * range);
-static void gld_clipnode_Free(clipnode_t *node);
 
-static clipnode_t * gld_clipnode_GetNew(void)
+// With -clipperdump, every call from the bsp walk is written out, so that
+// the clipper can be timed on real frames with -clipperreplay
+static FILE *clipper_dump;
+
+static void gld_clipper_CloseDump(void)
 {
-  if (freelist)
-  {
-    clipnode_t * p = freelist;
-    freelist = p->next;
-    return p;
-  }
-  else
+  if (clipper_dump)
   {
-    return Z_Malloc(sizeof(clipnode_t));
+    fclose(clipper_dump);
+    clipper_dump = NULL;
   }
 }
 
-static clipnode_t * gld_clipnode_NewRange(angle_t start, angle_t end)
+static void gld_clipper_OpenDump(void)
 {
-  clipnode_t * c = gld_clipnode_GetNew();
-  c->start = start;
-  c->end = end;
-  c->next = c->prev=NULL;
-  return c;
+  static dboolean opened;
+  unsigned int header[2] = { CLIPPER_DUMP_MAGIC, CLIPPER_DUMP_VERSION };
+  dsda_arg_t *arg;
+
+  if (opened)
+    return;
+
+  opened = true;
+
+  arg = dsda_Arg(dsda_arg_clipper_dump);
+
+  if (!arg->found)
+    return;
+
+  clipper_dump = M_OpenFile(arg->value.v_string, "wb");
+
+  if (!clipper_dump || fwrite(header, sizeof(header), 1, clipper_dump) != 1)
+    I_Error("gld_clipper_OpenDump: couldn't write %s", arg->value.v_string);
+
+  I_AtExit(gld_clipper_CloseDump, true, "gld_clipper_CloseDump", exit_priority_normal);
 }
 
-dboolean gld_clipper_SafeCheckRange(angle_t startAngle, angle_t endAngle)
+static void gld_clipper_Record(clipper_op_t op, angle_t start, angle_t end)
 {
-  if(startAngle > endAngle)
+  clipper_record_t record;
+
+  record.op = op;
+  record.start = start;
+  record.end = end;
+
+  if (fwrite(&record, sizeof(record), 1, clipper_dump) != 1)
   {
-    return (gld_clipper_IsRangeVisible(startAngle, ANGLE_MAX) || gld_clipper_IsRangeVisible(0, endAngle));
+    lprintf(LO_WARN, "gld_clipper_Record: write failed, stopping -clipperdump\n");
+    gld_clipper_CloseDump();
   }
-
-  return gld_clipper_IsRangeVisible(startAngle, endAngle);
 }
 
-static dboolean gld_clipper_IsRangeVisible(angle_t startAngle, angle_t endAngle)
+// Index of the first range that ends at or after angle
+static int gld_clipper_FirstEndingAfter(angle_t angle)
 {
-  clipnode_t *ci;
-  ci = cliphead;
+  int lo = 0, hi = numclipranges;
 
-  if (endAngle == 0 && ci && ci->start == 0)
-    return false;
-
-  while (ci != NULL && ci->start < endAngle)
+  while (lo < hi)
   {
-    if (startAngle >= ci->start && endAngle <= ci->end)
-    {
-      return false;
-    }
-    ci = ci->next;
+    int mid = (lo + hi) / 2;
+
+    if (clipranges[mid].end < angle)
+      lo = mid + 1;
+    else
+      hi = mid;
   }
 
-  return true;
+  return lo;
 }
 
-static void gld_clipnode_Free(clipnode_t *node)
+// Index of the first range that starts after angle
+static int gld_clipper_FirstStartingAfter(angle_t angle, int lo)
 {
-  node->next = freelist;
-  freelist = node;
+  int hi = numclipranges;
+
+  while (lo < hi)
+  {
+    int mid = (lo + hi) / 2;
+
+    if (clipranges[mid].start <= angle)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+
+  return lo;
 }
 
-static void gld_clipper_RemoveRange(clipnode_t *range)
+dboolean gld_clipper_SafeCheckRange(angle_t startAngle, angle_t endAngle)
 {
-  if (range == cliphead)
+  dboolean visible;
+
+  if(startAngle > endAngle)
   {
-    cliphead = cliphead->next;
+    visible = (gld_clipper_IsRangeVisible(startAngle, ANGLE_MAX) || gld_clipper_IsRangeVisible(0, endAngle));
   }
   else
   {
-    if (range->prev)
-    {
-      range->prev->next = range->next;
-    }
-    if (range->next)
-    {
-      range->next->prev = range->prev;
-    }
+    visible = gld_clipper_IsRangeVisible(startAngle, endAngle);
   }
 
-  gld_clipnode_Free(range);
+  if (clipper_dump)
+    gld_clipper_Record(visible ? clipper_op_visible : clipper_op_hidden, startAngle, endAngle);
+
+  return visible;
+}
+
+static dboolean gld_clipper_IsRangeVisible(angle_t startAngle, angle_t endAngle)
+{
+  int i;
+
+  if (endAngle == 0 && numclipranges && clipranges[0].start == 0)
+    return false;
+
+  // Only the last range starting at or before startAngle can cover it,
+  // and ranges starting at endAngle or later were never considered
+  i = gld_clipper_FirstStartingAfter(startAngle, 0) - 1;
+
+  return !(i >= 0 &&
+           clipranges[i].start < endAngle &&
+           endAngle <= clipranges[i].end);
 }
 
 void gld_clipper_SafeAddClipRange(angle_t startangle, angle_t endangle)
 {
+  if (clipper_dump)
+    gld_clipper_Record(clipper_op_add, startangle, endangle);
+
   if(startangle > endangle)
   {
     // The range has to added in two parts.
@@ -210,127 +259,43 @@ static void gld_clipper_SafeAddClipRangeRealAngles(angle_t startangle, angle_t e
 }
 
 
+// Merges the range with every range it overlaps or touches
 static void gld_clipper_AddClipRange(angle_t start, angle_t end)
 {
-  clipnode_t *node, *temp, *prevNode, *node2, *delnode;
+  int first = gld_clipper_FirstEndingAfter(start);
+  int last = gld_clipper_FirstStartingAfter(end, first);
 
-  if (cliphead)
+  if (first < last)
   {
-    //check to see if range contains any old ranges
-    node = cliphead;
-    while (node != NULL && node->start < end)
-    {
-      if (node->start >= start && node->end <= end)
-      {
-        temp = node;
-        node = node->next;
-        gld_clipper_RemoveRange(temp);
-      }
-      else
-      {
-        if (node->start <= start && node->end >= end)
-        {
-          return;
-        }
-        else
-        {
-          node = node->next;
-        }
-      }
-    }
+    clipranges[first].start = MIN(start, clipranges[first].start);
+    clipranges[first].end = MAX(end, clipranges[last - 1].end);
 
-    //check to see if range overlaps a range (or possibly 2)
-    node = cliphead;
-    while (node != NULL && node->start <= end)
+    if (last - first > 1)
     {
-      if (node->end >= start)
-      {
-        // we found the first overlapping node
-        if (node->start > start)
-        {
-          // the new range overlaps with this node's start point
-          node->start = start;
-        }
-        if (node->end < end)
-        {
-          node->end = end;
-        }
-
-        node2 = node->next;
-        while (node2 && node2->start <= node->end)
-        {
-          if (node2->end > node->end)
-          {
-            node->end = node2->end;
-          }
-
-          delnode = node2;
-          node2 = node2->next;
-          gld_clipper_RemoveRange(delnode);
-        }
-        return;
-      }
-      node = node->next;
+      memmove(&clipranges[first + 1], &clipranges[last],
+              (numclipranges - last) * sizeof(clipranges[0]));
+      numclipranges -= last - first - 1;
     }
 
-    //just add range
-    node = cliphead;
-    prevNode = NULL;
-    temp = gld_clipnode_NewRange(start, end);
-    while (node != NULL && node->start < end)
-    {
-      prevNode = node;
-      node = node->next;
-    }
-    temp->next = node;
-    if (node == NULL)
-    {
-      temp->prev = prevNode;
-      if (prevNode)
-      {
-        prevNode->next = temp;
-      }
-      if (!cliphead)
-      {
-        cliphead = temp;
-      }
-    }
-    else
-    {
-      if (node == cliphead)
-      {
-        cliphead->prev = temp;
-        cliphead = temp;
-      }
-      else
-      {
-        temp->prev = prevNode;
-        prevNode->next = temp;
-        node->prev = temp;
-      }
-    }
-  }
-  else
-  {
-    temp = gld_clipnode_NewRange(start, end);
-    cliphead = temp;
     return;
   }
-}
-
-static void gld_clipper_Clear(void)
-{
-  clipnode_t *node = cliphead;
-  clipnode_t *temp;
 
-  while (node != NULL)
+  if (numclipranges == maxclipranges)
   {
-    temp = node;
-    node = node->next;
-    gld_clipnode_Free(temp);
+    maxclipranges = (maxclipranges ? maxclipranges * 2 : 128);
+    clipranges = Z_Realloc(clipranges, maxclipranges * sizeof(clipranges[0]));
   }
 
-  cliphead = NULL;
+  memmove(&clipranges[first + 1], &clipranges[first],
+          (numclipranges - first) * sizeof(clipranges[0]));
+  clipranges[first].start = start;
+  clipranges[first].end = end;
+  numclipranges++;
+}
+
+void gld_clipper_Clear(void)
+{
+  numclipranges = 0;
 }
 
 static angle_t gld_FrustumAngle(void)
@@ -383,7 +348,12 @@ void gld_FrustumSetup(void)
   float clip[16];
   angle_t a1 = gld_FrustumAngle();
 
+  gld_clipper_OpenDump();
   gld_clipper_Clear();
+
+  if (clipper_dump)
+    gld_clipper_Record(clipper_op_frame, 0, 0);
+
   gld_clipper_SafeAddClipRangeRealAngles(viewangle + a1, viewangle - a1);
 
   clip[0]  = CALCMATRIX(0, 0, 1, 4, 2, 8, 3, 12);
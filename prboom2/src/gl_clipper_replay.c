@@ -0,0 +1,401 @@
+/* Emacs style mode select   -*- C -*-
+ *-----------------------------------------------------------------------------
+ *
+ *
+ *  PrBoom: a Doom port merged with LxDoom and LSDLDoom
+ *  based on BOOM, a modified and improved DOOM engine
+ *  Copyright (C) 1999 by
+ *  id Software, Chi Hoang, Lee Killough, Jim Flynn, Rand Phares, Ty Halderman
+ *  Copyright (C) 1999-2000 by
+ *  Jess Haas, Nicolas Kalkhof, Colin Phipps, Florian Schulze
+ *  Copyright 2005, 2006 by
+ *  Florian Schulze, Colin Phipps, Neil Stevens, Andrey Budko
+ *
+ *  This program is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU General Public License
+ *  as published by the Free Software Foundation; either version 2
+ *  of the License, or (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA
+ *  02111-1307, USA.
+ *
+ * DESCRIPTION:
+ *   Replay of recorded clipper calls
+ *
+ *   -clipperreplay runs the calls written by -clipperdump through the
+ *   clipper and through the linked list clipper it replaced, which is kept
+ *   here as the reference. Both must see the visibility that was recorded.
+ *   Then each is timed over the whole recording, repeated until enough
+ *   calls have been made to measure.
+ *
+ *---------------------------------------------------------------------
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <SDL_opengl.h>
+#include "gl_intern.h"
+#include "i_system.h"
+#include "lprintf.h"
+#include "m_file.h"
+#include "z_zone.h"
+
+#include "dsda/time.h"
+
+// Repeat the recording until about this many calls have been timed
+#define CLIPPER_REPLAY_CALLS 20000000
+
+//
+// The linked list clipper, as it was before the ranges became an array
+//
+
+typedef struct listclipnode_s
+{
+  struct listclipnode_s *prev, *next;
+  angle_t start, end;
+} listclipnode_t;
+
+static listclipnode_t *list_freelist;
+static listclipnode_t *list_cliphead;
+
+static listclipnode_t *gld_listclipper_NewRange(angle_t start, angle_t end)
+{
+  listclipnode_t *c;
+
+  if (list_freelist)
+  {
+    c = list_freelist;
+    list_freelist = c->next;
+  }
+  else
+  {
+    c = Z_Malloc(sizeof(*c));
+  }
+
+  c->start = start;
+  c->end = end;
+  c->next = c->prev = NULL;
+  return c;
+}
+
+static void gld_listclipper_Free(listclipnode_t *node)
+{
+  node->next = list_freelist;
+  list_freelist = node;
+}
+
+static dboolean gld_listclipper_IsRangeVisible(angle_t startAngle, angle_t endAngle)
+{
+  listclipnode_t *ci = list_cliphead;
+
+  if (endAngle == 0 && ci && ci->start == 0)
+    return false;
+
+  while (ci != NULL && ci->start < endAngle)
+  {
+    if (startAngle >= ci->start && endAngle <= ci->end)
+      return false;
+
+    ci = ci->next;
+  }
+
+  return true;
+}
+
+static dboolean gld_listclipper_SafeCheckRange(angle_t startAngle, angle_t endAngle)
+{
+  if (startAngle > endAngle)
+  {
+    return (gld_listclipper_IsRangeVisible(startAngle, ANGLE_MAX) ||
+            gld_listclipper_IsRangeVisible(0, endAngle));
+  }
+
+  return gld_listclipper_IsRangeVisible(startAngle, endAngle);
+}
+
+static void gld_listclipper_RemoveRange(listclipnode_t *range)
+{
+  if (range == list_cliphead)
+  {
+    list_cliphead = list_cliphead->next;
+  }
+  else
+  {
+    if (range->prev)
+      range->prev->next = range->next;
+    if (range->next)
+      range->next->prev = range->prev;
+  }
+
+  gld_listclipper_Free(range);
+}
+
+static void gld_listclipper_AddClipRange(angle_t start, angle_t end)
+{
+  listclipnode_t *node, *temp, *prevNode, *node2, *delnode;
+
+  if (!list_cliphead)
+  {
+    list_cliphead = gld_listclipper_NewRange(start, end);
+    return;
+  }
+
+  //check to see if range contains any old ranges
+  node = list_cliphead;
+  while (node != NULL && node->start < end)
+  {
+    if (node->start >= start && node->end <= end)
+    {
+      temp = node;
+      node = node->next;
+      gld_listclipper_RemoveRange(temp);
+    }
+    else if (node->start <= start && node->end >= end)
+    {
+      return;
+    }
+    else
+    {
+      node = node->next;
+    }
+  }
+
+  //check to see if range overlaps a range (or possibly 2)
+  node = list_cliphead;
+  while (node != NULL && node->start <= end)
+  {
+    if (node->end >= start)
+    {
+      // we found the first overlapping node
+      if (node->start > start)
+        node->start = start;
+      if (node->end < end)
+        node->end = end;
+
+      node2 = node->next;
+      while (node2 && node2->start <= node->end)
+      {
+        if (node2->end > node->end)
+          node->end = node2->end;
+
+        delnode = node2;
+        node2 = node2->next;
+        gld_listclipper_RemoveRange(delnode);
+      }
+      return;
+    }
+    node = node->next;
+  }
+
+  //just add range
+  node = list_cliphead;
+  prevNode = NULL;
+  temp = gld_listclipper_NewRange(start, end);
+  while (node != NULL && node->start < end)
+  {
+    prevNode = node;
+    node = node->next;
+  }
+  temp->next = node;
+  if (node == NULL)
+  {
+    temp->prev = prevNode;
+    if (prevNode)
+      prevNode->next = temp;
+    if (!list_cliphead)
+      list_cliphead = temp;
+  }
+  else if (node == list_cliphead)
+  {
+    list_cliphead->prev = temp;
+    list_cliphead = temp;
+  }
+  else
+  {
+    temp->prev = prevNode;
+    prevNode->next = temp;
+    node->prev = temp;
+  }
+}
+
+static void gld_listclipper_SafeAddClipRange(angle_t startangle, angle_t endangle)
+{
+  if (startangle > endangle)
+  {
+    gld_listclipper_AddClipRange(startangle, ANGLE_MAX);
+    gld_listclipper_AddClipRange(0, endangle);
+  }
+  else
+  {
+    gld_listclipper_AddClipRange(startangle, endangle);
+  }
+}
+
+static void gld_listclipper_Clear(void)
+{
+  while (list_cliphead)
+  {
+    listclipnode_t *node = list_cliphead;
+
+    list_cliphead = node->next;
+    gld_listclipper_Free(node);
+  }
+}
+
+static void gld_listclipper_Shutdown(void)
+{
+  gld_listclipper_Clear();
+
+  while (list_freelist)
+  {
+    listclipnode_t *node = list_freelist;
+
+    list_freelist = node->next;
+    Z_Free(node);
+  }
+}
+
+//
+// Replay
+//
+
+typedef struct
+{
+  const char *name;
+  void (*clear)(void);
+  dboolean (*check)(angle_t start, angle_t end);
+  void (*add)(angle_t start, angle_t end);
+} clipper_impl_t;
+
+static const clipper_impl_t clipper_impls[] = {
+  {
+    "array",
+    gld_clipper_Clear, gld_clipper_SafeCheckRange, gld_clipper_SafeAddClipRange
+  },
+  {
+    "list",
+    gld_listclipper_Clear, gld_listclipper_SafeCheckRange, gld_listclipper_SafeAddClipRange
+  },
+};
+
+#define NUM_CLIPPER_IMPLS (sizeof(clipper_impls) / sizeof(clipper_impls[0]))
+
+// Returns the number of checks that disagree with the recording
+static int gld_clipper_ReplayOnce(const clipper_impl_t *impl,
+                                  const clipper_record_t *records, int count)
+{
+  int mismatches = 0;
+  int i;
+
+  for (i = 0; i < count; i++)
+  {
+    const clipper_record_t *record = &records[i];
+
+    switch (record->op)
+    {
+      case clipper_op_frame:
+        impl->clear();
+        break;
+      case clipper_op_add:
+        impl->add(record->start, record->end);
+        break;
+      default:
+        if (impl->check(record->start, record->end) != (record->op == clipper_op_visible))
+          mismatches++;
+        break;
+    }
+  }
+
+  impl->clear();
+
+  return mismatches;
+}
+
+dboolean gld_clipper_Replay(const char *filename)
+{
+  const unsigned int *header;
+  const clipper_record_t *records;
+  byte *buffer;
+  int length;
+  int count, frames, checks;
+  int passes, i, p;
+  double ns_per_call[NUM_CLIPPER_IMPLS];
+  dboolean matched = true;
+
+  length = M_ReadFile(filename, &buffer);
+
+  if (length < 0)
+    I_Error("gld_clipper_Replay: couldn't read %s", filename);
+
+  header = (const unsigned int *) buffer;
+
+  if (
+    length < 2 * sizeof(*header) ||
+    header[0] != CLIPPER_DUMP_MAGIC ||
+    header[1] != CLIPPER_DUMP_VERSION ||
+    (length - 2 * sizeof(*header)) % sizeof(*records)
+  )
+    I_Error("gld_clipper_Replay: %s is not a -clipperdump recording", filename);
+
+  records = (const clipper_record_t *) (header + 2);
+  count = (length - 2 * sizeof(*header)) / sizeof(*records);
+
+  frames = checks = 0;
+  for (i = 0; i < count; i++)
+  {
+    if (records[i].op == clipper_op_frame)
+      frames++;
+    else if (records[i].op != clipper_op_add)
+      checks++;
+  }
+
+  if (!count || records[0].op != clipper_op_frame)
+    I_Error("gld_clipper_Replay: %s has no frames", filename);
+
+  passes = MAX(1, CLIPPER_REPLAY_CALLS / count);
+
+  lprintf(LO_INFO, "gld_clipper_Replay: %s: %d frames, %d calls, %d checks, %d passes\n",
+          filename, frames, count, checks, passes);
+
+  for (i = 0; i < NUM_CLIPPER_IMPLS; i++)
+  {
+    const clipper_impl_t *impl = &clipper_impls[i];
+    int mismatches;
+
+    // The first pass checks the results; the rest are only timed
+    mismatches = gld_clipper_ReplayOnce(impl, records, count);
+
+    if (mismatches)
+    {
+      lprintf(LO_WARN, "  %s: %d of %d checks differ from the recording\n",
+              impl->name, mismatches, checks);
+      matched = false;
+    }
+
+    dsda_StartTimer(dsda_timer_clipper_replay);
+
+    for (p = 0; p < passes; p++)
+      gld_clipper_ReplayOnce(impl, records, count);
+
+    ns_per_call[i] = (double) dsda_ElapsedTimeNS(dsda_timer_clipper_replay) / passes / count;
+
+    lprintf(LO_INFO, "  %s: %.1f ns per call, %.1f us per frame\n",
+            impl->name, ns_per_call[i], ns_per_call[i] * count / frames / 1000);
+  }
+
+  lprintf(LO_INFO, "  array is %.2fx the speed of list\n", ns_per_call[1] / ns_per_call[0]);
+
+  gld_listclipper_Shutdown();
+  Z_Free(buffer);
+
+  return matched;
+}
@@ -58,9 +58,14 @@
 #include "hu_stuff.h"
 #include "r_main.h"
 #include "r_sky.h"
+#include "m_file.h"
 #include "m_misc.h"
+#include "md5.h"
 #include "e6y.h"
+#include "i_glob.h"
 
+#include "dsda/configuration.h"
+#include "dsda/data_organizer.h"
 #include "dsda/font.h"
 #include "dsda/utility.h"
 
@@ -88,6 +93,8 @@ int gld_ProgressRestoreScreen(void)
 
   if (progress_texid)
   {
+    gld_FlushUIBatch();
+
     total_w = gld_GetTexDimension(SCREENWIDTH);
     total_h = gld_GetTexDimension(SCREENHEIGHT);
 
@@ -257,6 +264,280 @@ static void gld_HiRes_Bind(GLTexture *gltexture, GLuint *glTexID)
   glBindTexture(GL_TEXTURE_2D, *glTexID);
 }
 
+//
+// Decoded hires textures are kept in the data root, keyed by the md5 of
+// the image lump, so that each image only goes through SDL_image once per
+// machine. A cache file is a header followed by the RGBA pixels exactly
+// as they are handed to gld_BuildTexture.
+//
+
+#define HIRES_CACHE_MAGIC 0x43524844 // "DHRC"
+#define HIRES_CACHE_VERSION 1
+#define HIRES_CACHE_MAX_DIMENSION 16384
+
+typedef struct
+{
+  unsigned int magic;
+  unsigned int version;
+  byte md5[16];
+  int width;
+  int height;
+  int hasholes;
+} hires_cache_header_t;
+
+static char *hires_cache_dir;
+
+// Entries are raw RGBA, 4 MB for a 1024x1024 image, so the directory is
+// capped at gl_hires_cache_size megabytes; past that, nothing more is added.
+static uint64_t hires_cache_used;
+static dboolean hires_cache_scanned;
+static dboolean hires_cache_full;
+
+static const char *gld_HiRes_CacheDir(void)
+{
+  if (!hires_cache_dir)
+  {
+    dsda_string_t dir;
+
+    dsda_StringPrintF(&dir, "%s/hires_cache", dsda_DataRoot());
+    hires_cache_dir = dir.string;
+
+    M_MakeDir(hires_cache_dir, false);
+  }
+
+  return hires_cache_dir;
+}
+
+static void gld_HiRes_CacheFileName(dsda_string_t *str, const dsda_cksum_t *cksum)
+{
+  dsda_StringPrintF(str, "%s/%s.rgba", gld_HiRes_CacheDir(), cksum->string);
+}
+
+static void gld_HiRes_ScanCache(void)
+{
+  glob_t *glob;
+  const char *filename;
+
+  hires_cache_scanned = true;
+
+  glob = I_StartGlob(gld_HiRes_CacheDir(), "*.rgba", 0);
+
+  if (!glob)
+    return;
+
+  while ((filename = I_NextGlob(glob)))
+  {
+    FILE *file = M_OpenFile(filename, "rb");
+
+    if (file)
+    {
+      if (!fseek(file, 0, SEEK_END))
+      {
+        long length = ftell(file);
+
+        if (length > 0)
+          hires_cache_used += length;
+      }
+
+      fclose(file);
+    }
+  }
+
+  I_EndGlob(glob);
+}
+
+static dboolean gld_HiRes_CacheHasRoom(size_t size)
+{
+  uint64_t limit;
+
+  if (hires_cache_full)
+    return false;
+
+  if (!hires_cache_scanned)
+    gld_HiRes_ScanCache();
+
+  limit = (uint64_t) dsda_IntConfig(dsda_config_gl_hires_cache_size) << 20;
+
+  if (hires_cache_used + size > limit)
+  {
+    lprintf(LO_INFO, "gld_HiRes_SaveCache: %s is full, not caching more textures\n",
+            gld_HiRes_CacheDir());
+    hires_cache_full = true;
+
+    return false;
+  }
+
+  return true;
+}
+
+static unsigned char *gld_HiRes_LoadCache(const dsda_cksum_t *cksum, int *width, int *height, int *hasholes)
+{
+  dsda_string_t filename;
+  hires_cache_header_t header;
+  unsigned char *pixels = NULL;
+  FILE *file;
+
+  gld_HiRes_CacheFileName(&filename, cksum);
+  file = M_OpenFile(filename.string, "rb");
+  dsda_FreeString(&filename);
+
+  if (!file)
+    return NULL;
+
+  if (fread(&header, sizeof(header), 1, file) == 1 &&
+      header.magic == HIRES_CACHE_MAGIC &&
+      header.version == HIRES_CACHE_VERSION &&
+      !memcmp(header.md5, cksum->bytes, sizeof(header.md5)) &&
+      header.width > 0 && header.width <= HIRES_CACHE_MAX_DIMENSION &&
+      header.height > 0 && header.height <= HIRES_CACHE_MAX_DIMENSION)
+  {
+    size_t size = (size_t) header.width * header.height * 4;
+
+    pixels = malloc(size);
+    if (pixels && fread(pixels, 1, size, file) == size)
+    {
+      *width = header.width;
+      *height = header.height;
+      *hasholes = header.hasholes;
+    }
+    else
+    {
+      free(pixels);
+      pixels = NULL;
+    }
+  }
+
+  fclose(file);
+
+  return pixels;
+}
+
+static void gld_HiRes_SaveCache(const dsda_cksum_t *cksum, const unsigned char *pixels,
+                                int width, int height, int hasholes)
+{
+  dsda_string_t filename;
+  hires_cache_header_t header;
+  size_t size = (size_t) width * height * 4;
+  FILE *file;
+
+  if (!gld_HiRes_CacheHasRoom(sizeof(header) + size))
+    return;
+
+  gld_HiRes_CacheFileName(&filename, cksum);
+  file = M_OpenFile(filename.string, "wb");
+
+  if (!file)
+  {
+    dsda_FreeString(&filename);
+    return;
+  }
+
+  memset(&header, 0, sizeof(header));
+  header.magic = HIRES_CACHE_MAGIC;
+  header.version = HIRES_CACHE_VERSION;
+  memcpy(header.md5, cksum->bytes, sizeof(header.md5));
+  header.width = width;
+  header.height = height;
+  header.hasholes = hasholes;
+
+  if (fwrite(&header, sizeof(header), 1, file) != 1 ||
+      fwrite(pixels, 1, size, file) != size)
+  {
+    lprintf(LO_WARN, "gld_HiRes_SaveCache: couldn't write %s\n", filename.string);
+    fclose(file);
+    M_remove(filename.string);
+  }
+  else
+  {
+    fclose(file);
+    hires_cache_used += sizeof(header) + size;
+  }
+
+  dsda_FreeString(&filename);
+}
+
+static unsigned char *gld_HiRes_DecodeLump(int lump, int *width, int *height, int *hasholes)
+{
+  unsigned char *pixels = NULL;
+  SDL_RWops *rw_data = SDL_RWFromConstMem(W_LumpByNum(lump), W_LumpLength(lump));
+  SDL_Surface *surf_tmp = IMG_Load_RW(rw_data, false);
+
+  // SDL can't load some TGA with common method
+  if (!surf_tmp)
+  {
+    surf_tmp = IMG_LoadTyped_RW(rw_data, false, "TGA");
+  }
+
+  SDL_FreeRW(rw_data);
+
+  if (!surf_tmp)
+  {
+    lprintf(LO_WARN, "gld_LoadHiresTex: %s\n", SDL_GetError());
+  }
+  else
+  {
+    SDL_Surface *surf = SDL_ConvertSurface(surf_tmp, &RGBAFormat, 0);
+    SDL_FreeSurface(surf_tmp);
+
+    if (surf)
+    {
+      pixels = malloc((size_t) surf->w * surf->h * 4);
+
+      if (pixels && SDL_LockSurface(surf) >= 0)
+      {
+        int y;
+
+        *hasholes = SmoothEdges(surf->pixels, surf->pitch / 4, surf->h);
+
+        for (y = 0; y < surf->h; y++)
+          memcpy(pixels + y * surf->w * 4, (byte *) surf->pixels + y * surf->pitch, surf->w * 4);
+
+        *width = surf->w;
+        *height = surf->h;
+
+        SDL_UnlockSurface(surf);
+      }
+      else
+      {
+        free(pixels);
+        pixels = NULL;
+      }
+
+      SDL_FreeSurface(surf);
+    }
+  }
+
+  return pixels;
+}
+
+// The pixels of a hires lump, from the cache when the lump is unchanged
+static unsigned char *gld_HiRes_LoadLump(int lump, int *width, int *height, int *hasholes)
+{
+  struct MD5Context md5;
+  dsda_cksum_t cksum;
+  unsigned char *pixels;
+
+  if (!dsda_IntConfig(dsda_config_gl_hires_cache))
+    return gld_HiRes_DecodeLump(lump, width, height, hasholes);
+
+  MD5Init(&md5);
+  MD5Update(&md5, W_LumpByNum(lump), W_LumpLength(lump));
+  MD5Final(cksum.bytes, &md5);
+  dsda_TranslateCheckSum(&cksum);
+
+  pixels = gld_HiRes_LoadCache(&cksum, width, height, hasholes);
+
+  if (!pixels)
+  {
+    pixels = gld_HiRes_DecodeLump(lump, width, height, hasholes);
+
+    if (pixels)
+      gld_HiRes_SaveCache(&cksum, pixels, *width, *height, *hasholes);
+  }
+
+  return pixels;
+}
+
 void gld_HiRes_ProcessColormap(unsigned char *buffer, int bufSize)
 {
   int pos;
@@ -417,41 +698,20 @@ int gld_LoadHiresTex(GLTexture *gltexture, int cm)
           int lump = W_CheckNumForName2(lumpname, ns_hires);
           if (lump != LUMP_NOT_FOUND)
           {
-            SDL_RWops *rw_data = SDL_RWFromConstMem(W_LumpByNum(lump), W_LumpLength(lump));
-            SDL_Surface *surf_tmp = IMG_Load_RW(rw_data, false);
-
-            // SDL can't load some TGA with common method
-            if (!surf_tmp)
-            {
-              surf_tmp = IMG_LoadTyped_RW(rw_data, false, "TGA");
-            }
-
-            SDL_FreeRW(rw_data);
+            int width, height, hasholes;
+            unsigned char *pixels = gld_HiRes_LoadLump(lump, &width, &height, &hasholes);
 
-            if (!surf_tmp)
+            if (pixels)
             {
-              lprintf(LO_WARN, "gld_LoadHiresTex: %s\n", SDL_GetError());
-            }
-            else
-            {
-              SDL_Surface *surf = SDL_ConvertSurface(surf_tmp, &RGBAFormat, 0);
-              SDL_FreeSurface(surf_tmp);
+              if (hasholes)
+                gltexture->flags |= GLTEXTURE_HASHOLES;
+              else
+                gltexture->flags &= ~GLTEXTURE_HASHOLES;
 
-              if (surf)
-              {
-                if (SDL_LockSurface(surf) >= 0)
-                {
-                  if (SmoothEdges(surf->pixels, surf->pitch / 4, surf->h))
-                    gltexture->flags |= GLTEXTURE_HASHOLES;
-                  else
-                    gltexture->flags &= ~GLTEXTURE_HASHOLES;
-                  SDL_UnlockSurface(surf);
-                }
-                gld_HiRes_Bind(gltexture, texid);
-                gld_BuildTexture(gltexture, surf->pixels, true, surf->w, surf->h);
+              gld_HiRes_Bind(gltexture, texid);
+              gld_BuildTexture(gltexture, pixels, true, width, height);
 
-                SDL_FreeSurface(surf);
-              }
+              free(pixels);
             }
           }
         }
@@ -191,6 +191,19 @@ typedef struct
   GLLoopDef *loops; // the loops itself
 } GLMapSubsector;
 
+// GLSectorPlanes keeps a floor and a ceiling copy of a sector's loops,
+// as triangles with the height in the vertexes, in sectorplanes_vbo.
+// A copy is only rewritten when the height it is drawn at changes.
+typedef struct
+{
+  int vertexindex; // floor copy, followed by the ceiling copy
+  int vertexcount; // number of vertexes in each copy
+  int indexindex;  // floor triangles, followed by the ceiling ones
+  int indexcount;  // number of indexes in each
+  float z[2];      // heights the floor and ceiling copies hold
+  unsigned int batch[2]; // last flat batch each copy was queued in
+} GLSectorPlanes;
+
 typedef struct
 {
   GLfloat x;
@@ -329,6 +342,8 @@ void gld_AddDrawItem(GLDrawItemType itemtype, void *itemdata);
 void gld_DrawTriangleStrip(GLWall *wall, gl_strip_coords_t *c);
 void gld_DrawTriangleStripARB(GLWall *wall, gl_strip_coords_t *c1, gl_strip_coords_t *c2);
 
+void gld_FlushBatches(void);
+
 extern float roll;
 extern float yaw;
 extern float inv_yaw;
@@ -342,6 +357,7 @@ void gld_ResetDrawInfo(void);
 
 extern GLSector *sectorloops;
 extern GLMapSubsector *subsectorloops;
+extern GLSectorPlanes *sectorplanes;
 
 extern int gl_tex_format;
 extern GLfloat gl_texture_filter_anisotropic;
@@ -407,6 +423,8 @@ void gld_ResetGammaRamp(void);
 //gl_vertex
 void gld_SplitLeftEdge(const GLWall *wall, dboolean detail);
 void gld_SplitRightEdge(const GLWall *wall, dboolean detail);
+const float *gld_GetLeftEdgeSplits(const GLWall *wall, int *count);
+const float *gld_GetRightEdgeSplits(const GLWall *wall, int *count);
 void gld_RecalcVertexHeights(const vertex_t *v);
 
 //e6y
@@ -416,6 +434,35 @@ void gld_ResetLastTexture(void);
 unsigned char* gld_GetTextureBuffer(GLuint texid, int miplevel, int *width, int *height);
 
 int gld_BuildTexture(GLTexture *gltexture, void *data, dboolean readonly, int width, int height);
+void gld_AddPatchToTexture(GLTexture *gltexture, unsigned char *buffer, const rpatch_t *patch, int originx, int originy, int cm, int paletted);
+
+//atlas
+dboolean gld_BatchUIPatch(GLTexture *gltexture, int cm,
+                          float x, float y, float width, float height, dboolean flip);
+void gld_FlushUIBatch(void);
+void gld_CleanAtlas(void);
+
+//clipper
+// A -clipperdump file is a header of the magic and the version followed by
+// one record per call; each frame starts with a clipper_op_frame record.
+#define CLIPPER_DUMP_MAGIC 0x50494c43 // "CLIP"
+#define CLIPPER_DUMP_VERSION 1
+
+typedef enum
+{
+  clipper_op_frame,
+  clipper_op_add,
+  clipper_op_visible, // a check that found the range visible
+  clipper_op_hidden,
+} clipper_op_t;
+
+typedef struct
+{
+  unsigned int op;
+  angle_t start, end;
+} clipper_record_t;
+
+void gld_clipper_Clear(void);
 
 //hires
 extern unsigned int gl_has_hires;
@@ -455,6 +502,7 @@ void gld_SetupFloodedPlaneCoords(GLWall *wall, gl_strip_coords_t *c);
 void gld_SetupFloodedPlaneLight(GLWall *wall);
 
 //light
+dboolean gld_StaticLightColor(float light, float alpha, GLfloat *rgba, float *shader_light);
 void gld_StaticLightAlpha(float light, float alpha);
 #define gld_StaticLight(light) gld_StaticLightAlpha(light, 1.0f)
 void gld_InitLightTable(void);
@@ -527,6 +575,10 @@ extern vbo_xyz_uv_t *flats_vbo;
 #define NULL_VBO_XYZ_UV ((vbo_xyz_uv_t*)NULL)
 #define flats_vbo_x (gl_ext_arb_vertex_buffer_object ? &NULL_VBO_XYZ_UV->x : &flats_vbo[0].x)
 #define flats_vbo_u (gl_ext_arb_vertex_buffer_object ? &NULL_VBO_XYZ_UV->u : &flats_vbo[0].u)
+extern vbo_xyz_uv_t *sectorplanes_vbo;
+extern GLuint *sectorplanes_indices;
+#define sectorplanes_vbo_x (gl_ext_arb_vertex_buffer_object ? &NULL_VBO_XYZ_UV->x : &sectorplanes_vbo[0].x)
+#define sectorplanes_vbo_u (gl_ext_arb_vertex_buffer_object ? &NULL_VBO_XYZ_UV->u : &sectorplanes_vbo[0].u)
 
 typedef struct vbo_xy_uv_rgba_s
 {
@@ -551,6 +603,7 @@ extern box_skybox_t *BoxSkybox_default;
 extern byte *segrendered; // true if sector rendered (only here for malloc)
 extern byte *linerendered[2]; // true if linedef rendered (only here for malloc)
 extern GLuint flats_vbo_id;
+extern GLuint sectorplanes_vbo_id;
 
 typedef struct GLShader_s
 {
@@ -186,38 +186,60 @@ static float gld_CalcLightLevel_shaders(int lightlevel)
   return (float)light/255.0f;
 }
 
-void gld_StaticLightAlpha(float light, float alpha)
+// The color gld_StaticLightAlpha sets; returns whether the shaders take
+// a light level as well, and if so which
+dboolean gld_StaticLightColor(float light, float alpha, GLfloat *rgba, float *shader_light)
 {
   player_t *player = &players[displayplayer];
   int shaders = (gl_lightmode == gl_lightmode_shaders || V_IsWorldLightmodeIndexed());
 
+  rgba[3] = alpha;
+
   if (!player->fixedcolormap)
   {
     float ll = (shaders ? 1.0f : light);
-    glColor4f(ll, ll, ll, alpha);
+    rgba[0] = rgba[1] = rgba[2] = ll;
   }
   else
   {
     if (invul_method != INVUL_BW)
     {
-      glColor4f(1.0f, 1.0f, 1.0f, alpha);
+      rgba[0] = rgba[1] = rgba[2] = 1.0f;
     }
     else
     {
       if (SceneInTexture)
       {
-        glColor4f(0.5f, 0.5f, 0.5f, alpha);
+        rgba[0] = rgba[1] = rgba[2] = 0.5f;
       }
       else
       {
-        glColor4f(bw_red, bw_green, bw_blue, alpha);
+        rgba[0] = bw_red;
+        rgba[1] = bw_green;
+        rgba[2] = bw_blue;
       }
     }
   }
 
   if (shaders)
   {
-    glsl_SetLightLevel((player->fixedcolormap ? 1.0f : light));
+    *shader_light = (player->fixedcolormap ? 1.0f : light);
+  }
+
+  return shaders;
+}
+
+void gld_StaticLightAlpha(float light, float alpha)
+{
+  GLfloat rgba[4];
+  float shader_light;
+  dboolean shaders = gld_StaticLightColor(light, alpha, rgba, &shader_light);
+
+  glColor4fv(rgba);
+
+  if (shaders)
+  {
+    glsl_SetLightLevel(shader_light);
   }
 }
 
@@ -301,6 +323,12 @@ static float gld_CalcFogDensity_glboom(sector_t *sector, int lightlevel, GLDrawI
 
 void gld_SetFog(float fogdensity)
 {
+  // Batched geometry has to be drawn with the fog it was queued under
+  if (fogdensity ? (!gl_fogenabled || fogdensity != gl_CurrentFogDensity) : gl_fogenabled)
+  {
+    gld_FlushBatches();
+  }
+
   if (fogdensity)
   {
     gl_EnableFog(true);
@@ -403,6 +403,8 @@ void gld_MapDrawSubsectors(player_t *plr, int fx, int fy, fixed_t mx, fixed_t my
   if (alpha == 0)
     return;
 
+  gld_FlushUIBatch();
+
   if (numsubsectors > visible_subsectors_size)
   {
     visible_subsectors_size = numsubsectors;
@@ -583,6 +585,8 @@ void gld_DrawTriangleStrip(GLWall *wall, gl_strip_coords_t *c)
 
 void gld_BeginUIDraw(void)
 {
+  gld_FlushUIBatch();
+
   if (V_IsWorldLightmodeIndexed())
   {
     gld_InitColormapTextures(true);
@@ -593,6 +597,8 @@ void gld_BeginUIDraw(void)
 
 void gld_EndUIDraw(void)
 {
+  gld_FlushUIBatch();
+
   if (V_IsWorldLightmodeIndexed())
   {
     gl_ui_lightmode_indexed = false;
@@ -603,6 +609,8 @@ void gld_EndUIDraw(void)
 
 void gld_BeginAutomapDraw(void)
 {
+  gld_FlushUIBatch();
+
   if (V_IsWorldLightmodeIndexed())
   {
     gld_InitColormapTextures(true);
@@ -613,6 +621,8 @@ void gld_BeginAutomapDraw(void)
 
 void gld_EndAutomapDraw(void)
 {
+  gld_FlushUIBatch();
+
   if (V_IsWorldLightmodeIndexed())
   {
     gl_automap_lightmode_indexed = false;
@@ -631,21 +641,12 @@ void gld_DrawNumPatch_f(float x, float y, int lump, int cm, enum patch_translati
 
   cmap = ((flags & VPT_TRANS) ? cm : CR_DEFAULT);
   gltexture=gld_RegisterPatch(lump, cmap, false, V_IsUILightmodeIndexed());
-  gld_BindPatch(gltexture, cmap);
 
   if (!gltexture)
-    return;
-  fV1=0.0f;
-  fV2=gltexture->scaleyfac;
-  if (flags & VPT_FLIP)
   {
-    fU1=gltexture->scalexfac;
-    fU2=0.0f;
-  }
-  else
-  {
-    fU1=0.0f;
-    fU2=gltexture->scalexfac;
+    gld_FlushUIBatch();
+    gld_BindPatch(gltexture, cmap);
+    return;
   }
 
   if (flags & VPT_NOOFFSET)
@@ -680,6 +681,25 @@ void gld_DrawNumPatch_f(float x, float y, int lump, int cm, enum patch_translati
     height = (float)(gltexture->realtexheight);
   }
 
+  if (gld_BatchUIPatch(gltexture, cmap, xpos, ypos, width, height, (flags & VPT_FLIP)))
+    return;
+
+  gld_FlushUIBatch();
+  gld_BindPatch(gltexture, cmap);
+
+  fV1=0.0f;
+  fV2=gltexture->scaleyfac;
+  if (flags & VPT_FLIP)
+  {
+    fU1=gltexture->scalexfac;
+    fU2=0.0f;
+  }
+  else
+  {
+    fU1=0.0f;
+    fU2=gltexture->scalexfac;
+  }
+
   // e6y
   // This is a workaround for some on-board Intel video cards.
   // Do you know more elegant solution?
@@ -707,6 +727,8 @@ void gld_FillRaw(int lump, int x, int y, int src_width, int src_height, int dst_
   int saved_boom_cm = boom_cm;
   boom_cm = 0;
 
+  gld_FlushUIBatch();
+
   gltexture = gld_RegisterRaw(lump, src_width, src_height, false, V_IsUILightmodeIndexed());
   gld_BindRaw(gltexture, 0);
 
@@ -757,6 +779,8 @@ void gld_FillPatch(int lump, int x, int y, int width, int height, enum patch_tra
   int saved_boom_cm = boom_cm;
   boom_cm = 0;
 
+  gld_FlushUIBatch();
+
   gltexture = gld_RegisterPatch(lump, CR_DEFAULT, false, V_IsUILightmodeIndexed());
   gld_BindPatch(gltexture, CR_DEFAULT);
 
@@ -917,6 +941,8 @@ void gld_DrawWeapon(int weaponlump, vissprite_t *vis, int lightlevel)
   int x1,y1,x2,y2;
   float light;
 
+  gld_FlushUIBatch();
+
   gltexture=gld_RegisterPatch(firstspritelump+weaponlump, CR_DEFAULT, false, V_IsWorldLightmodeIndexed());
   if (!gltexture)
     return;
@@ -968,6 +994,8 @@ void gld_FillBlock(int x, int y, int width, int height, int col)
 {
   color_rgb_t color = gld_LookupIndexedColor(col, V_IsUILightmodeIndexed() || V_IsAutomapLightmodeIndexed());
 
+  gld_FlushUIBatch();
+
   glsl_SuspendActiveShader();
 
   gld_EnableTexture2D(GL_TEXTURE0_ARB, false);
@@ -1091,6 +1119,8 @@ unsigned char *gld_ReadScreen(void)
 
   int src_row, dest_row, size, pixels_per_row;
 
+  gld_FlushUIBatch();
+
   pixels_per_row = gl_window_width * 3;
   size = pixels_per_row * gl_window_height;
   if (!scr || size > scr_size)
@@ -1127,6 +1157,8 @@ unsigned char *gld_ReadScreen(void)
 
 GLvoid gld_Set2DMode(void)
 {
+  gld_FlushUIBatch();
+
   glMatrixMode(GL_MODELVIEW);
   glLoadIdentity();
   glMatrixMode(GL_PROJECTION);
@@ -1154,6 +1186,7 @@ void gld_Finish(void)
 }
 
 GLuint flats_vbo_id = 0; // ID of VBO
+GLuint sectorplanes_vbo_id = 0;
 
 vbo_xyz_uv_t *flats_vbo = NULL;
 
@@ -1196,6 +1229,8 @@ void gld_Clear(void)
 
 void gld_StartDrawScene(void)
 {
+  gld_FlushUIBatch();
+
   // Progress fuzz time seed
   glsl_SetFuzzTime(gametic);
 
@@ -1444,6 +1479,198 @@ static void gld_AddDrawWallItem(GLDrawItemType itemtype, void *itemdata)
  *               *
  *****************/
 
+//
+// Plain walls drawn by the opaque passes are collected into one vertex
+// array and drawn with a single glDrawArrays for each run of walls that
+// share a texture, clamping, fog and shader light level, instead of a
+// glBegin/glEnd pair for each wall. The draw items are already sorted by
+// texture, so the runs are long.
+//
+
+typedef struct
+{
+  GLfloat x, y, z;
+  GLfloat u, v;
+  GLfloat rgba[4];
+} gl_batch_vertex_t;
+
+static struct
+{
+  dboolean active;
+  GLTexture *gltexture;
+  unsigned int flags;
+  dboolean shaders;
+  float shader_light;
+
+  gl_batch_vertex_t *vertices;
+  int count;
+  int size;
+
+  gl_batch_vertex_t *fan;
+  int fan_size;
+} wall_batch;
+
+// The scene draws from flats_vbo unless a batch is being flushed
+static void gld_BindFlatsArrays(void)
+{
+  if (gl_ext_arb_vertex_buffer_object)
+    GLEXT_glBindBufferARB(GL_ARRAY_BUFFER, flats_vbo_id);
+  glVertexPointer(3, GL_FLOAT, sizeof(flats_vbo[0]), flats_vbo_x);
+  glTexCoordPointer(2, GL_FLOAT, sizeof(flats_vbo[0]), flats_vbo_u);
+}
+
+static void gld_BeginWallBatch(void)
+{
+  wall_batch.active = true;
+  wall_batch.count = 0;
+}
+
+static void gld_FlushWallBatch(void)
+{
+  gl_batch_vertex_t *vertices = wall_batch.vertices;
+
+  if (!wall_batch.count)
+    return;
+
+  if (wall_batch.shaders)
+    glsl_SetLightLevel(wall_batch.shader_light);
+
+  if (gl_ext_arb_vertex_buffer_object)
+    GLEXT_glBindBufferARB(GL_ARRAY_BUFFER, 0);
+  glVertexPointer(3, GL_FLOAT, sizeof(vertices[0]), &vertices[0].x);
+  glTexCoordPointer(2, GL_FLOAT, sizeof(vertices[0]), &vertices[0].u);
+  glColorPointer(4, GL_FLOAT, sizeof(vertices[0]), vertices[0].rgba);
+  glEnableClientState(GL_COLOR_ARRAY);
+
+  glDrawArrays(GL_TRIANGLES, 0, wall_batch.count);
+
+  // the current color is undefined after drawing with a color array
+  glDisableClientState(GL_COLOR_ARRAY);
+  glColor4fv(vertices[wall_batch.count - 1].rgba);
+
+  gld_BindFlatsArrays();
+
+  wall_batch.count = 0;
+}
+
+static void gld_EndWallBatch(void)
+{
+  gld_FlushWallBatch();
+  wall_batch.active = false;
+}
+
+static void gld_AddWallFanVertex(int *count, const GLfloat *rgba,
+                                 float x, float y, float z, GLfloat u, GLfloat v)
+{
+  gl_batch_vertex_t *vertex;
+
+  if (*count >= wall_batch.fan_size)
+  {
+    wall_batch.fan_size = (wall_batch.fan_size ? wall_batch.fan_size * 2 : 64);
+    wall_batch.fan = Z_Realloc(wall_batch.fan, wall_batch.fan_size * sizeof(wall_batch.fan[0]));
+  }
+
+  vertex = &wall_batch.fan[(*count)++];
+  vertex->x = x;
+  vertex->y = y;
+  vertex->z = z;
+  vertex->u = u;
+  vertex->v = v;
+  memcpy(vertex->rgba, rgba, sizeof(vertex->rgba));
+}
+
+// Same vertices, in the same order, as the triangle fan gld_DrawWall draws
+static void gld_BatchWall(GLWall *wall, unsigned int flags)
+{
+  GLfloat rgba[4];
+  float shader_light = 0;
+  dboolean shaders;
+  const float *heights;
+  int i, count, fan_count = 0;
+
+  shaders = gld_StaticLightColor(wall->light, wall->alpha, rgba, &shader_light);
+
+  if (wall_batch.count && (
+      wall_batch.gltexture != wall->gltexture ||
+      wall_batch.flags != flags ||
+      (shaders && wall_batch.shader_light != shader_light)))
+  {
+    gld_FlushWallBatch();
+  }
+
+  gld_BindTexture(wall->gltexture, flags);
+  gld_BindDetailARB(wall->gltexture, false);
+
+  wall_batch.gltexture = wall->gltexture;
+  wall_batch.flags = flags;
+  wall_batch.shaders = shaders;
+  wall_batch.shader_light = shader_light;
+
+  // lower left corner
+  gld_AddWallFanVertex(&fan_count, rgba,
+    wall->glseg->x1, wall->ybottom, wall->glseg->z1, wall->ul, wall->vb);
+
+  // split left edge of wall
+  if (!wall->glseg->fracleft)
+  {
+    heights = gld_GetLeftEdgeSplits(wall, &count);
+    if (count)
+    {
+      float polyh = wall->ytop - wall->ybottom;
+      float factv = (polyh ? (wall->vt - wall->vb) / polyh : 0);
+
+      for (i = 0; i < count; i++)
+        gld_AddWallFanVertex(&fan_count, rgba,
+          wall->glseg->x1, heights[i], wall->glseg->z1,
+          wall->ul, factv * (heights[i] - wall->ytop) + wall->vt);
+    }
+  }
+
+  // upper left corner
+  gld_AddWallFanVertex(&fan_count, rgba,
+    wall->glseg->x1, wall->ytop, wall->glseg->z1, wall->ul, wall->vt);
+
+  // upper right corner
+  gld_AddWallFanVertex(&fan_count, rgba,
+    wall->glseg->x2, wall->ytop, wall->glseg->z2, wall->ur, wall->vt);
+
+  // split right edge of wall
+  if (!wall->glseg->fracright)
+  {
+    heights = gld_GetRightEdgeSplits(wall, &count);
+    if (count)
+    {
+      float polyh = wall->ytop - wall->ybottom;
+      float factv = (polyh ? (wall->vt - wall->vb) / polyh : 0);
+
+      for (i = count - 1; i >= 0; i--)
+        gld_AddWallFanVertex(&fan_count, rgba,
+          wall->glseg->x2, heights[i], wall->glseg->z2,
+          wall->ur, factv * (heights[i] - wall->ytop) + wall->vt);
+    }
+  }
+
+  // lower right corner
+  gld_AddWallFanVertex(&fan_count, rgba,
+    wall->glseg->x2, wall->ybottom, wall->glseg->z2, wall->ur, wall->vb);
+
+  // the fan, as triangles
+  if (wall_batch.count + (fan_count - 2) * 3 > wall_batch.size)
+  {
+    while (wall_batch.count + (fan_count - 2) * 3 > wall_batch.size)
+      wall_batch.size = (wall_batch.size ? wall_batch.size * 2 : 1024);
+    wall_batch.vertices = Z_Realloc(wall_batch.vertices,
+      wall_batch.size * sizeof(wall_batch.vertices[0]));
+  }
+
+  for (i = 1; i < fan_count - 1; i++)
+  {
+    wall_batch.vertices[wall_batch.count++] = wall_batch.fan[0];
+    wall_batch.vertices[wall_batch.count++] = wall_batch.fan[i];
+    wall_batch.vertices[wall_batch.count++] = wall_batch.fan[i + 1];
+  }
+}
+
 static void gld_DrawWall(GLWall *wall)
 {
   int has_detail;
@@ -1464,6 +1691,15 @@ static void gld_DrawWall(GLWall *wall)
   else
     flags = 0;
 
+  if (wall_batch.active && !has_detail && wall->gltexture &&
+      wall->flag != GLDWF_TOPFLUD && wall->flag != GLDWF_BOTFLUD)
+  {
+    gld_BatchWall(wall, flags);
+    return;
+  }
+
+  gld_FlushWallBatch();
+
   gld_BindTexture(wall->gltexture, flags);
   gld_BindDetailARB(wall->gltexture, has_detail);
 
@@ -2047,6 +2283,141 @@ bottomtexture:
  *               *
  *****************/
 
+//
+// Flats without detail textures or texture transforms are drawn from
+// sectorplanes, which holds every sector's floor and ceiling at the
+// height it was last seen at. Each run of flats sharing a texture,
+// clamping, color, fog and shader light level becomes one glDrawElements
+// over the indexes of their triangles, with no matrix changes, and only
+// planes that have moved since they were last drawn are rewritten.
+//
+
+static struct
+{
+  dboolean active;
+  unsigned int serial;
+  GLTexture *gltexture;
+  unsigned int flags;
+  GLfloat rgba[4];
+  dboolean shaders;
+  float shader_light;
+
+  GLuint *indices;
+  int count;
+  int size;
+} flat_batch;
+
+static void gld_BeginFlatBatch(void)
+{
+  flat_batch.active = true;
+  flat_batch.count = 0;
+  flat_batch.serial++;
+}
+
+static void gld_FlushFlatBatch(void)
+{
+  if (!flat_batch.count)
+    return;
+
+  glColor4fv(flat_batch.rgba);
+  if (flat_batch.shaders)
+    glsl_SetLightLevel(flat_batch.shader_light);
+
+  if (gl_ext_arb_vertex_buffer_object)
+    GLEXT_glBindBufferARB(GL_ARRAY_BUFFER, sectorplanes_vbo_id);
+  glVertexPointer(3, GL_FLOAT, sizeof(sectorplanes_vbo[0]), sectorplanes_vbo_x);
+  glTexCoordPointer(2, GL_FLOAT, sizeof(sectorplanes_vbo[0]), sectorplanes_vbo_u);
+
+  glDrawElements(GL_TRIANGLES, flat_batch.count, GL_UNSIGNED_INT, flat_batch.indices);
+
+  gld_BindFlatsArrays();
+
+  flat_batch.count = 0;
+  flat_batch.serial++;
+}
+
+static void gld_EndFlatBatch(void)
+{
+  gld_FlushFlatBatch();
+  flat_batch.active = false;
+}
+
+void gld_FlushBatches(void)
+{
+  gld_FlushWallBatch();
+  gld_FlushFlatBatch();
+}
+
+static void gld_SetSectorPlaneHeight(GLSectorPlanes *planes, int ceiling, float z)
+{
+  int first = planes->vertexindex + (ceiling ? planes->vertexcount : 0);
+  int i;
+
+  for (i = 0; i < planes->vertexcount; i++)
+    sectorplanes_vbo[first + i].y = z;
+
+  if (gl_ext_arb_vertex_buffer_object)
+  {
+    GLEXT_glBindBufferARB(GL_ARRAY_BUFFER, sectorplanes_vbo_id);
+    GLEXT_glBufferSubDataARB(GL_ARRAY_BUFFER,
+      first * sizeof(sectorplanes_vbo[0]),
+      planes->vertexcount * sizeof(sectorplanes_vbo[0]),
+      &sectorplanes_vbo[first]);
+    GLEXT_glBindBufferARB(GL_ARRAY_BUFFER, flats_vbo_id);
+  }
+
+  planes->z[ceiling] = z;
+}
+
+static void gld_BatchFlat(GLFlat *flat, unsigned int flags)
+{
+  GLSectorPlanes *planes = &sectorplanes[flat->sectornum];
+  int ceiling = ((flat->flags & GLFLAT_CEILING) ? 1 : 0);
+  GLfloat rgba[4];
+  float shader_light = 0;
+  dboolean shaders;
+
+  shaders = gld_StaticLightColor(flat->light, flat->alpha, rgba, &shader_light);
+
+  // A plane that is already queued can't move until it has been drawn
+  if (flat_batch.count && (
+      flat_batch.gltexture != flat->gltexture ||
+      flat_batch.flags != flags ||
+      memcmp(flat_batch.rgba, rgba, sizeof(rgba)) ||
+      (shaders && flat_batch.shader_light != shader_light) ||
+      (planes->batch[ceiling] == flat_batch.serial && planes->z[ceiling] != flat->z)))
+  {
+    gld_FlushFlatBatch();
+  }
+
+  gld_BindFlat(flat->gltexture, flags);
+  gld_BindDetailARB(flat->gltexture, false);
+
+  flat_batch.gltexture = flat->gltexture;
+  flat_batch.flags = flags;
+  memcpy(flat_batch.rgba, rgba, sizeof(rgba));
+  flat_batch.shaders = shaders;
+  flat_batch.shader_light = shader_light;
+
+  if (planes->z[ceiling] != flat->z)
+    gld_SetSectorPlaneHeight(planes, ceiling, flat->z);
+
+  planes->batch[ceiling] = flat_batch.serial;
+
+  if (flat_batch.count + planes->indexcount > flat_batch.size)
+  {
+    while (flat_batch.count + planes->indexcount > flat_batch.size)
+      flat_batch.size = (flat_batch.size ? flat_batch.size * 2 : 4096);
+    flat_batch.indices = Z_Realloc(flat_batch.indices,
+      flat_batch.size * sizeof(flat_batch.indices[0]));
+  }
+
+  memcpy(&flat_batch.indices[flat_batch.count],
+         &sectorplanes_indices[planes->indexindex + ceiling * planes->indexcount],
+         planes->indexcount * sizeof(flat_batch.indices[0]));
+  flat_batch.count += planes->indexcount;
+}
+
 static void gld_DrawFlat(GLFlat *flat)
 {
   int loopnum; // current loop number
@@ -2071,6 +2442,14 @@ static void gld_DrawFlat(GLFlat *flat)
   else
     flags = 0;
 
+  if (flat_batch.active && !has_offset && flat->sectornum >= 0)
+  {
+    gld_BatchFlat(flat, flags);
+    return;
+  }
+
+  gld_FlushFlatBatch();
+
   gld_BindFlat(flat->gltexture, flags);
   gld_StaticLightAlpha(flat->light, flat->alpha);
 
@@ -3001,20 +3380,24 @@ void gld_DrawScene(player_t *player)
   // floors
   glCullFace(GL_FRONT);
   gld_DrawItemsSortByTexture(GLDIT_FLOOR);
+  gld_BeginFlatBatch();
   for (i = gld_drawinfo.num_items[GLDIT_FLOOR] - 1; i >= 0; i--)
   {
     gld_SetFog(gld_drawinfo.items[GLDIT_FLOOR][i].item.flat->fogdensity);
     gld_DrawFlat(gld_drawinfo.items[GLDIT_FLOOR][i].item.flat);
   }
+  gld_EndFlatBatch();
 
   // ceilings
   glCullFace(GL_BACK);
   gld_DrawItemsSortByTexture(GLDIT_CEILING);
+  gld_BeginFlatBatch();
   for (i = gld_drawinfo.num_items[GLDIT_CEILING] - 1; i >= 0; i--)
   {
     gld_SetFog(gld_drawinfo.items[GLDIT_CEILING][i].item.flat->fogdensity);
     gld_DrawFlat(gld_drawinfo.items[GLDIT_CEILING][i].item.flat);
   }
+  gld_EndFlatBatch();
 
   // disable backside removing
   glDisable(GL_CULL_FACE);
@@ -3024,11 +3407,13 @@ void gld_DrawScene(player_t *player)
 
   // top, bottom, one-sided walls
   gld_DrawItemsSortByTexture(GLDIT_WALL);
+  gld_BeginWallBatch();
   for (i = gld_drawinfo.num_items[GLDIT_WALL] - 1; i >= 0; i--)
   {
     gld_SetFog(gld_drawinfo.items[GLDIT_WALL][i].item.wall->fogdensity);
     gld_ProcessWall(gld_drawinfo.items[GLDIT_WALL][i].item.wall);
   }
+  gld_EndWallBatch();
 
   // masked geometry
   glEnable(GL_ALPHA_TEST);
@@ -3092,11 +3477,13 @@ void gld_DrawScene(player_t *player)
   else
   {
     // opaque mid walls
+    gld_BeginWallBatch();
     for (i = gld_drawinfo.num_items[GLDIT_MWALL] - 1; i >= 0; i--)
     {
       gld_SetFog(gld_drawinfo.items[GLDIT_MWALL][i].item.wall->fogdensity);
       gld_ProcessWall(gld_drawinfo.items[GLDIT_MWALL][i].item.wall);
     }
+    gld_EndWallBatch();
   }
 
   gl_EnableFog(false);
@@ -156,6 +156,8 @@ void gld_DrawNiceThings(int fx, int fy, int fw, int fh)
 {
   int i;
 
+  gld_FlushUIBatch();
+
   dsda_GLSetScreenSpaceScissor(fx, fy, fw, fh);
   glEnable(GL_SCISSOR_TEST);
 
@@ -214,6 +216,8 @@ void gld_DrawMapLines(void)
   {
     map_point_t *point = (map_point_t*)map_lines.data;
 
+    gld_FlushUIBatch();
+
     gld_EnableTexture2D(GL_TEXTURE0_ARB, false);
     glEnableClientState(GL_VERTEX_ARRAY);
     glEnableClientState(GL_COLOR_ARRAY);
@@ -244,9 +244,11 @@ void gld_InitOpenGL(void)
       GLEXT_glDeleteBuffersARB = SDL_GL_GetProcAddress("glDeleteBuffersARB");
       GLEXT_glBindBufferARB = SDL_GL_GetProcAddress("glBindBufferARB");
       GLEXT_glBufferDataARB = SDL_GL_GetProcAddress("glBufferDataARB");
+      GLEXT_glBufferSubDataARB = SDL_GL_GetProcAddress("glBufferSubDataARB");
 
       if (!GLEXT_glGenBuffersARB || !GLEXT_glDeleteBuffersARB ||
-          !GLEXT_glBindBufferARB || !GLEXT_glBufferDataARB)
+          !GLEXT_glBindBufferARB || !GLEXT_glBufferDataARB ||
+          !GLEXT_glBufferSubDataARB)
         gl_ext_arb_vertex_buffer_object = false;
     }
     if (gl_ext_arb_vertex_buffer_object)
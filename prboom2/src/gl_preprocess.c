@@ -55,6 +55,8 @@
 #include "am_map.h"
 #include "lprintf.h"
 
+#include "dsda/time.h"
+
 static FILE *levelinfo;
 
 static int gld_max_vertexes = 0;
@@ -69,6 +71,12 @@ GLSector *sectorloops;
 // uses by textured automap
 GLMapSubsector *subsectorloops;
 
+// floor and ceiling triangles for all sectors
+GLSectorPlanes *sectorplanes;
+vbo_xyz_uv_t *sectorplanes_vbo;
+GLuint *sectorplanes_indices;
+static int sectorplanes_num_vertexes;
+
 static void gld_AddGlobalVertexes(int count)
 {
   if ((gld_num_vertexes+count)>=gld_max_vertexes)
@@ -1000,6 +1008,110 @@ static void gld_PreprocessSectors(void)
   gld_MarkSectorsForClamp();
 }
 
+/*****************************
+ *
+ * SECTOR PLANES
+ *
+ *****************************/
+
+static int gld_LoopTriangleIndexes(const GLLoopDef *loop)
+{
+  if (loop->vertexcount < 3)
+    return 0;
+
+  if (loop->mode == GL_TRIANGLES)
+    return loop->vertexcount - loop->vertexcount % 3;
+
+  return (loop->vertexcount - 2) * 3;
+}
+
+// Copies the loops of every sector out of flats_vbo, twice, and turns
+// them into plain triangles so that any set of sectors can be drawn with
+// a single glDrawElements
+static void gld_PreprocessSectorPlanes(void)
+{
+  int i, j, k;
+  int num_vertexes = 0;
+  int num_indexes = 0;
+
+  sectorplanes = Z_Calloc(numsectors, sizeof(sectorplanes[0]));
+
+  for (i = 0; i < numsectors; i++)
+  {
+    GLSectorPlanes *planes = &sectorplanes[i];
+
+    planes->vertexindex = num_vertexes;
+    planes->indexindex = num_indexes;
+
+    for (j = 0; j < sectorloops[i].loopcount; j++)
+    {
+      planes->vertexcount += sectorloops[i].loops[j].vertexcount;
+      planes->indexcount += gld_LoopTriangleIndexes(&sectorloops[i].loops[j]);
+    }
+
+    num_vertexes += planes->vertexcount * 2;
+    num_indexes += planes->indexcount * 2;
+  }
+
+  sectorplanes_num_vertexes = num_vertexes;
+  sectorplanes_vbo = Z_Malloc(MAX(num_vertexes, 1) * sizeof(sectorplanes_vbo[0]));
+  sectorplanes_indices = Z_Malloc(MAX(num_indexes, 1) * sizeof(sectorplanes_indices[0]));
+
+  for (i = 0; i < numsectors; i++)
+  {
+    GLSectorPlanes *planes = &sectorplanes[i];
+    vbo_xyz_uv_t *floor_vbo = &sectorplanes_vbo[planes->vertexindex];
+    GLuint *floor_indices = &sectorplanes_indices[planes->indexindex];
+    int vertex = 0;
+    int index = 0;
+
+    for (j = 0; j < sectorloops[i].loopcount; j++)
+    {
+      GLLoopDef *loop = &sectorloops[i].loops[j];
+      GLuint first = planes->vertexindex + vertex;
+
+      memcpy(&floor_vbo[vertex], &flats_vbo[loop->vertexindex],
+             loop->vertexcount * sizeof(floor_vbo[0]));
+      vertex += loop->vertexcount;
+
+      if (loop->vertexcount < 3)
+        continue;
+
+      // keep the winding of the original primitives for face culling
+      for (k = 0; k < loop->vertexcount - 2; k++)
+      {
+        if (loop->mode == GL_TRIANGLES)
+        {
+          if (k % 3)
+            continue;
+
+          floor_indices[index++] = first + k;
+          floor_indices[index++] = first + k + 1;
+          floor_indices[index++] = first + k + 2;
+        }
+        else if (loop->mode == GL_TRIANGLE_STRIP)
+        {
+          floor_indices[index++] = first + k + (k & 1);
+          floor_indices[index++] = first + k + 1 - (k & 1);
+          floor_indices[index++] = first + k + 2;
+        }
+        else
+        {
+          floor_indices[index++] = first;
+          floor_indices[index++] = first + k + 1;
+          floor_indices[index++] = first + k + 2;
+        }
+      }
+    }
+
+    // the ceiling copy
+    memcpy(&floor_vbo[planes->vertexcount], floor_vbo,
+           planes->vertexcount * sizeof(floor_vbo[0]));
+    for (k = 0; k < planes->indexcount; k++)
+      floor_indices[planes->indexcount + k] = floor_indices[k] + planes->vertexcount;
+  }
+}
+
 static void gld_PreprocessSegs(void)
 {
   int i;
@@ -1025,6 +1137,8 @@ static void gld_PreprocessSegs(void)
 
 void gld_PreprocessLevel(void)
 {
+  dsda_BeginTimedPhase("gld_PreprocessLevel");
+
   // e6y: speedup of level reloading
   // Do not preprocess GL data twice for same level
   if (!gl_preprocessed)
@@ -1053,9 +1167,19 @@ void gld_PreprocessLevel(void)
       Z_Free(subsectorloops[i].loops);
     }
     Z_Free(subsectorloops);
+    Z_Free(sectorplanes);
+    Z_Free(sectorplanes_vbo);
+    Z_Free(sectorplanes_indices);
 
+    dsda_BeginTimedPhase("gld_Precache");
     gld_Precache();
+    dsda_EndTimedPhase();
+
+    dsda_BeginTimedPhase("gld_PreprocessSectors");
     gld_PreprocessSectors();
+    dsda_EndTimedPhase();
+
+    gld_PreprocessSectorPlanes();
     gld_PreprocessFakeSectors();
     gld_PreprocessSegs();
 
@@ -1096,6 +1220,19 @@ void gld_PreprocessLevel(void)
 
       Z_Free(flats_vbo);
       flats_vbo = NULL;
+
+      // the sector planes are rewritten as heights change,
+      // so the local copy stays around
+      if (sectorplanes_vbo_id)
+      {
+        GLEXT_glDeleteBuffersARB(1, &sectorplanes_vbo_id);
+      }
+      GLEXT_glGenBuffersARB(1, &sectorplanes_vbo_id);
+      GLEXT_glBindBufferARB(GL_ARRAY_BUFFER, sectorplanes_vbo_id);
+      GLEXT_glBufferDataARB(GL_ARRAY_BUFFER,
+        sectorplanes_num_vertexes * sizeof(sectorplanes_vbo[0]),
+        sectorplanes_vbo, GL_DYNAMIC_DRAW_ARB);
+      GLEXT_glBindBufferARB(GL_ARRAY_BUFFER, 0);
     }
   }
 
@@ -1104,6 +1241,8 @@ void gld_PreprocessLevel(void)
   gld_InitVertexData();
 
   gl_preprocessed = true;
+
+  dsda_EndTimedPhase();
 }
 
 /*****************************
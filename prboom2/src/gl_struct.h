@@ -143,6 +143,7 @@ int gld_wipe_EndScreen(void);
 //clipper
 dboolean gld_clipper_SafeCheckRange(angle_t startAngle, angle_t endAngle);
 void gld_clipper_SafeAddClipRange(angle_t startangle, angle_t endangle);
+dboolean gld_clipper_Replay(const char *filename);
 void gld_FrustumSetup(void);
 dboolean gld_SphereInFrustum(float x, float y, float z, float radius);
 
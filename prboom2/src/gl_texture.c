@@ -48,6 +48,7 @@
 #define CALLBACK
 #endif
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <SDL.h>
 #include "doomtype.h"
@@ -1701,6 +1702,7 @@ static void gld_CleanTexItems(int count, GLTexture ***items)
 
 void gld_FlushTextures(void)
 {
+  gld_CleanAtlas();
   gld_CleanTexItems(numtextures, &gld_GLTextures);
   gld_CleanTexItems(numlumps, &gld_GLPatchTextures);
   gld_CleanTexItems(numlumps, &gld_GLStaticPatchTextures);
@@ -1741,6 +1743,278 @@ static void CalcHitsCount(const byte *hitlist, int size, int *hit, int*hitcount)
   }
 }
 
+//
+// Precache conversion
+//
+// gld_Precache first gathers everything the level needs, then converts
+// the patches and flats to RGBA on a pool of workers while the main thread
+// uploads the finished ones, in the order they were gathered. Workers only
+// read the rpatch_t or lump they are handed, the palette and the
+// colormaps, all of which are set up beforehand and stay put until the
+// precache is done. Anything that touches GL stays on the main thread.
+//
+
+#define PRECACHE_MAX_WORKERS 8
+
+// How far the workers may run ahead of the uploads,
+// to bound the memory held in converted buffers
+#define PRECACHE_MAX_AHEAD 64
+
+typedef enum
+{
+  precache_texture,
+  precache_flat,
+  precache_patch,
+} precache_kind_t;
+
+typedef struct
+{
+  GLTexture *gltexture;
+  precache_kind_t kind;
+  int cm;
+  const void *source;
+  unsigned char *buffer;
+  dboolean done;
+} precache_job_t;
+
+static precache_job_t *precache_jobs;
+static int precache_count;
+static int precache_size;
+static int precache_next;
+static int precache_uploaded;
+static SDL_mutex *precache_mutex;
+static SDL_cond *precache_cond;
+
+static void gld_QueuePrecache(GLTexture *gltexture, precache_kind_t kind, int cm)
+{
+  static const int textypes[] = { GLDT_TEXTURE, GLDT_FLAT, GLDT_PATCH };
+  precache_job_t *job;
+  const void *source;
+
+  if (!gltexture || gltexture->textype != textypes[kind])
+    return;
+
+#ifdef HAVE_LIBSDL2_IMAGE
+  if (gld_LoadHiresTex(gltexture, cm))
+    return;
+#endif
+
+  gld_GetTextureTexID(gltexture, cm);
+
+  // Already uploaded, or queued under another name
+  if (*gltexture->texid_p != 0)
+    return;
+
+  switch (kind)
+  {
+    case precache_texture:
+      source = R_TextureCompositePatchByNum(gltexture->index);
+      break;
+    case precache_flat:
+      source = W_LumpByNum(gltexture->index);
+      break;
+    default:
+      source = R_PatchByNum(gltexture->index);
+      break;
+  }
+
+  glGenTextures(1, gltexture->texid_p);
+
+  if (precache_count == precache_size)
+  {
+    precache_size = (precache_size ? precache_size * 2 : 256);
+    precache_jobs = Z_Realloc(precache_jobs, precache_size * sizeof(precache_jobs[0]));
+  }
+
+  job = &precache_jobs[precache_count++];
+  job->gltexture = gltexture;
+  job->kind = kind;
+  job->cm = cm;
+  job->source = source;
+  job->buffer = NULL;
+  job->done = false;
+}
+
+// The same conversion gld_BindTexture, gld_BindRaw and gld_BindPatch do
+static void gld_ConvertPrecacheJob(precache_job_t *job)
+{
+  GLTexture *gltexture = job->gltexture;
+
+  job->buffer = calloc(1, gltexture->buffer_size);
+  if (!job->buffer)
+    return;
+
+  if (job->kind == precache_flat)
+  {
+    gld_AddRawToTexture(gltexture, job->buffer, job->source, 0);
+  }
+  else
+  {
+    gld_AddPatchToTexture(gltexture, job->buffer, job->source, 0, 0, job->cm, 0);
+
+    if (gltexture->flags & GLTEXTURE_HASHOLES)
+    {
+      SmoothEdges(job->buffer, gltexture->buffer_width, gltexture->buffer_height);
+    }
+  }
+}
+
+static int gld_PrecacheWorker(void *unused)
+{
+  SDL_LockMutex(precache_mutex);
+
+  while (precache_next < precache_count)
+  {
+    precache_job_t *job;
+
+    if (precache_next >= precache_uploaded + PRECACHE_MAX_AHEAD)
+    {
+      SDL_CondWait(precache_cond, precache_mutex);
+      continue;
+    }
+
+    job = &precache_jobs[precache_next++];
+
+    SDL_UnlockMutex(precache_mutex);
+    gld_ConvertPrecacheJob(job);
+    SDL_LockMutex(precache_mutex);
+
+    job->done = true;
+    SDL_CondBroadcast(precache_cond);
+  }
+
+  SDL_UnlockMutex(precache_mutex);
+
+  return 0;
+}
+
+// Rather than sit idle, the main thread converts jobs itself
+static void gld_WaitForPrecacheJob(precache_job_t *job)
+{
+  if (!precache_mutex)
+  {
+    gld_ConvertPrecacheJob(job);
+    return;
+  }
+
+  SDL_LockMutex(precache_mutex);
+
+  while (!job->done)
+  {
+    if (precache_next < precache_count)
+    {
+      precache_job_t *next = &precache_jobs[precache_next++];
+
+      SDL_UnlockMutex(precache_mutex);
+      gld_ConvertPrecacheJob(next);
+      SDL_LockMutex(precache_mutex);
+
+      next->done = true;
+      SDL_CondBroadcast(precache_cond);
+    }
+    else
+    {
+      SDL_CondWait(precache_cond, precache_mutex);
+    }
+  }
+
+  SDL_UnlockMutex(precache_mutex);
+}
+
+static void gld_UploadPrecacheJob(precache_job_t *job)
+{
+  GLTexture *gltexture = job->gltexture;
+
+  if (!job->buffer)
+  {
+    // Leave it to be built when it is first drawn
+    glDeleteTextures(1, gltexture->texid_p);
+    *gltexture->texid_p = 0;
+    return;
+  }
+
+  glBindTexture(GL_TEXTURE_2D, *gltexture->texid_p);
+  last_glTexID = gltexture->texid_p;
+
+  gld_BuildTexture(gltexture, job->buffer, true, gltexture->buffer_width, gltexture->buffer_height);
+
+  free(job->buffer);
+  job->buffer = NULL;
+
+  gld_SetTexClamp(gltexture, (job->kind == precache_patch ? GLTEXTURE_CLAMPXY : 0));
+}
+
+static void gld_RunPrecacheJobs(void)
+{
+  SDL_Thread *workers[PRECACHE_MAX_WORKERS];
+  int num_workers = 0;
+  int i;
+  unsigned int tics = SDL_GetTicks();
+
+  if (!precache_count)
+    return;
+
+  // The palette is loaded on first use
+  V_GetPlaypal();
+
+  precache_next = 0;
+  precache_uploaded = 0;
+  precache_mutex = SDL_CreateMutex();
+  precache_cond = SDL_CreateCond();
+
+  if (precache_mutex && precache_cond)
+  {
+    int count = BETWEEN(1, PRECACHE_MAX_WORKERS, SDL_GetCPUCount() - 1);
+
+    for (i = 0; i < count; i++)
+    {
+      workers[num_workers] = SDL_CreateThread(gld_PrecacheWorker, "gld_PrecacheWorker", NULL);
+      if (workers[num_workers])
+        num_workers++;
+    }
+  }
+  else
+  {
+    if (precache_cond)
+      SDL_DestroyCond(precache_cond);
+    if (precache_mutex)
+      SDL_DestroyMutex(precache_mutex);
+    precache_cond = NULL;
+    precache_mutex = NULL;
+  }
+
+  for (i = 0; i < precache_count; i++)
+  {
+    gld_ProgressUpdate("Uploading Textures...", i + 1, precache_count);
+    gld_WaitForPrecacheJob(&precache_jobs[i]);
+    gld_UploadPrecacheJob(&precache_jobs[i]);
+
+    if (precache_mutex)
+    {
+      SDL_LockMutex(precache_mutex);
+      precache_uploaded = i + 1;
+      SDL_CondBroadcast(precache_cond);
+      SDL_UnlockMutex(precache_mutex);
+    }
+  }
+
+  for (i = 0; i < num_workers; i++)
+    SDL_WaitThread(workers[i], NULL);
+
+  if (precache_mutex)
+  {
+    SDL_DestroyCond(precache_cond);
+    SDL_DestroyMutex(precache_mutex);
+    precache_cond = NULL;
+    precache_mutex = NULL;
+  }
+
+  lprintf(LO_DEBUG, "gld_Precache: %d textures converted on %d threads in %d ms\n",
+          precache_count, num_workers + 1, SDL_GetTicks() - tics);
+
+  precache_count = 0;
+}
+
 void gld_Precache(void)
 {
   int i;
@@ -1811,10 +2085,7 @@ void gld_Precache(void)
     {
       gld_ProgressUpdate("Loading Flats...", ++hit, hitcount);
       gltexture = gld_RegisterFlat(i, true, indexed);
-      if (gltexture)
-      {
-        gld_BindFlat(gltexture, 0);
-      }
+      gld_QueuePrecache(gltexture, precache_flat, CR_DEFAULT);
     }
 
   // Precache textures.
@@ -1908,10 +2179,7 @@ void gld_Precache(void)
     {
       gld_ProgressUpdate("Loading Textures...", ++hit, hitcount);
       gltexture = gld_RegisterTexture(i, i != skytexture, false, indexed);
-      if (gltexture)
-      {
-        gld_BindTexture(gltexture, 0);
-      }
+      gld_QueuePrecache(gltexture, precache_texture, CR_DEFAULT);
     }
 
   // Precache sprites.
@@ -1947,16 +2215,15 @@ void gld_Precache(void)
             {
               gld_ProgressUpdate("Loading Sprites...", ++hit, hitcount);
               gltexture = gld_RegisterPatch(firstspritelump + sflump[k], CR_LIMIT, true, indexed);
-              if (gltexture)
-              {
-                gld_BindPatch(gltexture, CR_LIMIT);
-              }
+              gld_QueuePrecache(gltexture, precache_patch, CR_LIMIT);
             }
             while (--k >= 0);
           }
       }
   Z_Free(hitlist);
 
+  gld_RunPrecacheJobs();
+
   gld_ProgressEnd();
 
   gld_InitFBO();
@@ -1984,6 +2251,7 @@ void gld_CleanMemory(void)
 
 void gld_CleanStaticMemory(void)
 {
+  gld_CleanAtlas();
   gld_CleanTexItems(numlumps, &gld_GLStaticPatchTextures);
   gld_CleanTexItems(numlumps, &gld_GLIndexedStaticPatchTextures);
   gld_CleanTexItems(gld_numGLColormaps, &gld_GLColormapTextures);
@@ -102,62 +102,126 @@ static splitsbysector_t * gl_splitsbysector = NULL;
 
 //==========================================================================
 //
-// Split left edge of wall
+// Heights at which the left edge of wall has to be split, bottom to top
 //
 //==========================================================================
-void gld_SplitLeftEdge(const GLWall *wall, dboolean detail)
+const float *gld_GetLeftEdgeSplits(const GLWall *wall, int *count)
 {
   vertex_t *v;
   vertexsplit_info_t *vi;
+  int i = 0, first;
+
+  *count = 0;
 
   v = wall->seg->linedef->v1;
 
   if (v == NULL)
-    return;
+    return NULL;
 
   vi = &gl_vertexsplit[v - vertexes];
 
-  if (vi->numheights)
+  while (i < vi->numheights && vi->heightlist[i] <= wall->ybottom)
+    i++;
+
+  first = i;
+
+  while (i < vi->numheights && vi->heightlist[i] < wall->ytop)
+    i++;
+
+  *count = i - first;
+
+  return vi->heightlist + first;
+}
+
+//==========================================================================
+//
+// Heights at which the right edge of wall has to be split, bottom to top.
+// They are drawn in the opposite order.
+//
+//==========================================================================
+const float *gld_GetRightEdgeSplits(const GLWall *wall, int *count)
+{
+  vertex_t *v;
+  vertexsplit_info_t *vi;
+  int i, last;
+
+  *count = 0;
+
+  v = wall->seg->linedef->v2;
+
+  if (v == NULL)
+    return NULL;
+
+  vi = &gl_vertexsplit[v - vertexes];
+
+  i = vi->numheights - 1;
+
+  while (i > 0 && vi->heightlist[i] >= wall->ytop)
+    i--;
+
+  last = i;
+
+  while (i > 0 && vi->heightlist[i] > wall->ybottom)
+    i--;
+
+  *count = last - i;
+
+  return vi->heightlist + i + 1;
+}
+
+static void gld_SplitEdgeVertex(const GLWall *wall, dboolean detail,
+                                GLfloat s, GLfloat t, float x, float y, float z)
+{
+  if (detail)
   {
-    int i = 0;
+    GLTexture *tex = wall->gltexture;
 
+    if (gl_arb_multitexture)
+    {
+      GLEXT_glMultiTexCoord2fARB(GL_TEXTURE0_ARB, s, t);
+      GLEXT_glMultiTexCoord2fARB(GL_TEXTURE1_ARB,
+        s * tex->detail_width + tex->detail->offsetx,
+        t * tex->detail_height + tex->detail->offsety);
+    }
+    else
+    {
+      glTexCoord2f(
+        s * tex->detail_width + tex->detail->offsetx,
+        t * tex->detail_height + tex->detail->offsety);
+    }
+  }
+  else
+  {
+    glTexCoord2f(s, t);
+  }
+  glVertex3f(x, y, z);
+}
+
+//==========================================================================
+//
+// Split left edge of wall
+//
+//==========================================================================
+void gld_SplitLeftEdge(const GLWall *wall, dboolean detail)
+{
+  int i, count;
+  const float *heights = gld_GetLeftEdgeSplits(wall, &count);
+
+  if (count)
+  {
     float polyh1 = wall->ytop - wall->ybottom;
     float factv1 = (polyh1 ? (wall->vt - wall->vb) / polyh1 : 0);
     float factu1 = (polyh1 ? (wall->ul - wall->ul) / polyh1 : 0);
 
     detail = detail && wall->gltexture->detail;
 
-    while (i < vi->numheights && vi->heightlist[i] <= wall->ybottom)
-      i++;
-
-    while (i < vi->numheights && vi->heightlist[i] < wall->ytop)
+    for (i = 0; i < count; i++)
     {
-      GLTexture *tex = wall->gltexture;
-      GLfloat s = factu1 * (vi->heightlist[i] - wall->ytop) + wall->ul;
-      GLfloat t = factv1 * (vi->heightlist[i] - wall->ytop) + wall->vt;
+      GLfloat s = factu1 * (heights[i] - wall->ytop) + wall->ul;
+      GLfloat t = factv1 * (heights[i] - wall->ytop) + wall->vt;
 
-      if (detail)
-      {
-        if (gl_arb_multitexture)
-        {
-          GLEXT_glMultiTexCoord2fARB(GL_TEXTURE0_ARB, s, t);
-          GLEXT_glMultiTexCoord2fARB(GL_TEXTURE1_ARB,
-            s * tex->detail_width + tex->detail->offsetx,
-            t * tex->detail_height + tex->detail->offsety);
-        }
-        else
-        {
-          glTexCoord2f(
-            s * tex->detail_width + tex->detail->offsetx,
-            t * tex->detail_height + tex->detail->offsety);
-        }
-      }
-      else
-      {
-        glTexCoord2f(s, t);
-      }
-      glVertex3f(wall->glseg->x1, vi->heightlist[i], wall->glseg->z1);
-      i++;
+      gld_SplitEdgeVertex(wall, detail, s, t,
+                          wall->glseg->x1, heights[i], wall->glseg->z1);
     }
   }
 }
@@ -169,57 +233,24 @@ void gld_SplitLeftEdge(const GLWall *wall, dboolean detail)
 //==========================================================================
 void gld_SplitRightEdge(const GLWall *wall, dboolean detail)
 {
-  vertex_t *v;
-  vertexsplit_info_t * vi;
-
-  v = wall->seg->linedef->v2;
-
-  if (v == NULL)
-    return;
+  int i, count;
+  const float *heights = gld_GetRightEdgeSplits(wall, &count);
 
-  vi = &gl_vertexsplit[v - vertexes];
-
-  if (vi->numheights)
+  if (count)
   {
-    int i = vi->numheights - 1;
-
     float polyh2 = wall->ytop - wall->ybottom;
     float factv2 = (polyh2 ? (wall->vt - wall->vb) / polyh2 : 0);
     float factu2 = (polyh2 ? (wall->ur - wall->ur) / polyh2 : 0);
 
     detail = detail && wall->gltexture->detail;
 
-    while (i > 0 && vi->heightlist[i] >= wall->ytop)
-      i--;
-
-    while (i > 0 && vi->heightlist[i] > wall->ybottom)
+    for (i = count - 1; i >= 0; i--)
     {
-      GLTexture *tex = wall->gltexture;
-      GLfloat s = factu2 * (vi->heightlist[i] - wall->ytop) + wall->ur;
-      GLfloat t = factv2 * (vi->heightlist[i] - wall->ytop) + wall->vt;
+      GLfloat s = factu2 * (heights[i] - wall->ytop) + wall->ur;
+      GLfloat t = factv2 * (heights[i] - wall->ytop) + wall->vt;
 
-      if (detail)
-      {
-        if (gl_arb_multitexture)
-        {
-          GLEXT_glMultiTexCoord2fARB(GL_TEXTURE0_ARB, s, t);
-          GLEXT_glMultiTexCoord2fARB(GL_TEXTURE1_ARB,
-            s * tex->detail_width + tex->detail->offsetx,
-            t * tex->detail_height + tex->detail->offsety);
-        }
-        else
-        {
-          glTexCoord2f(
-            s * tex->detail_width + tex->detail->offsetx,
-            t * tex->detail_height + tex->detail->offsety);
-        }
-      }
-      else
-      {
-        glTexCoord2f(s, t);
-      }
-      glVertex3f(wall->glseg->x2, vi->heightlist[i], wall->glseg->z2);
-      i--;
+      gld_SplitEdgeVertex(wall, detail, s, t,
+                          wall->glseg->x2, heights[i], wall->glseg->z2);
     }
   }
 }
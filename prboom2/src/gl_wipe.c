@@ -52,6 +52,8 @@ GLuint CaptureScreenAsTexID(void)
 {
   GLuint id;
 
+  gld_FlushUIBatch();
+
   gld_EnableTexture2D(GL_TEXTURE0_ARB, true);
 
   glGenTextures(1, &id);
@@ -74,6 +74,113 @@ static int Pop(void);
 static int Top(void);
 static void Drop(void);
 
+typedef enum
+{
+    PCD_NOP,
+    PCD_TERMINATE,
+    PCD_SUSPEND,
+    PCD_PUSH_NUMBER,
+    PCD_LSPEC1,
+    PCD_LSPEC2,
+    PCD_LSPEC3,
+    PCD_LSPEC4,
+    PCD_LSPEC5,
+    PCD_LSPEC1_DIRECT,
+    PCD_LSPEC2_DIRECT,
+    PCD_LSPEC3_DIRECT,
+    PCD_LSPEC4_DIRECT,
+    PCD_LSPEC5_DIRECT,
+    PCD_ADD,
+    PCD_SUBTRACT,
+    PCD_MULTIPLY,
+    PCD_DIVIDE,
+    PCD_MODULUS,
+    PCD_EQ,
+    PCD_NE,
+    PCD_LT,
+    PCD_GT,
+    PCD_LE,
+    PCD_GE,
+    PCD_ASSIGN_SCRIPT_VAR,
+    PCD_ASSIGN_MAP_VAR,
+    PCD_ASSIGN_WORLD_VAR,
+    PCD_PUSH_SCRIPT_VAR,
+    PCD_PUSH_MAP_VAR,
+    PCD_PUSH_WORLD_VAR,
+    PCD_ADD_SCRIPT_VAR,
+    PCD_ADD_MAP_VAR,
+    PCD_ADD_WORLD_VAR,
+    PCD_SUB_SCRIPT_VAR,
+    PCD_SUB_MAP_VAR,
+    PCD_SUB_WORLD_VAR,
+    PCD_MUL_SCRIPT_VAR,
+    PCD_MUL_MAP_VAR,
+    PCD_MUL_WORLD_VAR,
+    PCD_DIV_SCRIPT_VAR,
+    PCD_DIV_MAP_VAR,
+    PCD_DIV_WORLD_VAR,
+    PCD_MOD_SCRIPT_VAR,
+    PCD_MOD_MAP_VAR,
+    PCD_MOD_WORLD_VAR,
+    PCD_INC_SCRIPT_VAR,
+    PCD_INC_MAP_VAR,
+    PCD_INC_WORLD_VAR,
+    PCD_DEC_SCRIPT_VAR,
+    PCD_DEC_MAP_VAR,
+    PCD_DEC_WORLD_VAR,
+    PCD_GOTO,
+    PCD_IF_GOTO,
+    PCD_DROP,
+    PCD_DELAY,
+    PCD_DELAY_DIRECT,
+    PCD_RANDOM,
+    PCD_RANDOM_DIRECT,
+    PCD_THING_COUNT,
+    PCD_THING_COUNT_DIRECT,
+    PCD_TAG_WAIT,
+    PCD_TAG_WAIT_DIRECT,
+    PCD_POLY_WAIT,
+    PCD_POLY_WAIT_DIRECT,
+    PCD_CHANGE_FLOOR,
+    PCD_CHANGE_FLOOR_DIRECT,
+    PCD_CHANGE_CEILING,
+    PCD_CHANGE_CEILING_DIRECT,
+    PCD_RESTART,
+    PCD_AND_LOGICAL,
+    PCD_OR_LOGICAL,
+    PCD_AND_BITWISE,
+    PCD_OR_BITWISE,
+    PCD_EOR_BITWISE,
+    PCD_NEGATE_LOGICAL,
+    PCD_LSHIFT,
+    PCD_RSHIFT,
+    PCD_UNARY_MINUS,
+    PCD_IF_NOT_GOTO,
+    PCD_LINE_SIDE,
+    PCD_SCRIPT_WAIT,
+    PCD_SCRIPT_WAIT_DIRECT,
+    PCD_CLEAR_LINE_SPECIAL,
+    PCD_CASE_GOTO,
+    PCD_BEGIN_PRINT,
+    PCD_END_PRINT,
+    PCD_PRINT_STRING,
+    PCD_PRINT_NUMBER,
+    PCD_PRINT_CHARACTER,
+    PCD_PLAYER_COUNT,
+    PCD_GAME_TYPE,
+    PCD_GAME_SKILL,
+    PCD_TIMER,
+    PCD_SECTOR_SOUND,
+    PCD_AMBIENT_SOUND,
+    PCD_SOUND_SEQUENCE,
+    PCD_SET_LINE_TEXTURE,
+    PCD_SET_LINE_BLOCKING,
+    PCD_SET_LINE_SPECIAL,
+    PCD_THING_SOUND,
+    PCD_END_PRINT_BOLD,
+    PCODE_COMMAND_COUNT
+} pcode_t;
+
 static int CmdNOP(void);
 static int CmdTerminate(void);
 static int CmdSuspend(void);
@@ -187,147 +294,72 @@ int MapVars[MAX_ACS_MAP_VARS];
 int WorldVars[MAX_ACS_WORLD_VARS];
 acsstore_t ACSStore[MAX_ACS_STORE + 1]; // +1 for termination marker
 
-static char EvalContext[64];
 static acs_t *ACScript;
 static unsigned int PCodeOffset;
+static const int *ActionCodeWords;
 static int SpecArgs[8];
 static int ACStringCount;
 static const char **ACStrings;
 static char PrintBuffer[PRINT_BUFFER_SIZE];
 static acs_t *NewScript;
 
-static int (*PCodeCmds[]) (void) =
-{
-        CmdNOP,
-        CmdTerminate,
-        CmdSuspend,
-        CmdPushNumber,
-        CmdLSpec1,
-        CmdLSpec2,
-        CmdLSpec3,
-        CmdLSpec4,
-        CmdLSpec5,
-        CmdLSpec1Direct,
-        CmdLSpec2Direct,
-        CmdLSpec3Direct,
-        CmdLSpec4Direct,
-        CmdLSpec5Direct,
-        CmdAdd,
-        CmdSubtract,
-        CmdMultiply,
-        CmdDivide,
-        CmdModulus,
-        CmdEQ,
-        CmdNE,
-        CmdLT,
-        CmdGT,
-        CmdLE,
-        CmdGE,
-        CmdAssignScriptVar,
-        CmdAssignMapVar,
-        CmdAssignWorldVar,
-        CmdPushScriptVar,
-        CmdPushMapVar,
-        CmdPushWorldVar,
-        CmdAddScriptVar,
-        CmdAddMapVar,
-        CmdAddWorldVar,
-        CmdSubScriptVar,
-        CmdSubMapVar,
-        CmdSubWorldVar,
-        CmdMulScriptVar,
-        CmdMulMapVar,
-        CmdMulWorldVar,
-        CmdDivScriptVar,
-        CmdDivMapVar,
-        CmdDivWorldVar,
-        CmdModScriptVar,
-        CmdModMapVar,
-        CmdModWorldVar,
-        CmdIncScriptVar,
-        CmdIncMapVar,
-        CmdIncWorldVar,
-        CmdDecScriptVar,
-        CmdDecMapVar,
-        CmdDecWorldVar,
-        CmdGoto,
-        CmdIfGoto,
-        CmdDrop,
-        CmdDelay,
-        CmdDelayDirect,
-        CmdRandom,
-        CmdRandomDirect,
-        CmdThingCount,
-        CmdThingCountDirect,
-        CmdTagWait,
-        CmdTagWaitDirect,
-        CmdPolyWait,
-        CmdPolyWaitDirect,
-        CmdChangeFloor,
-        CmdChangeFloorDirect,
-        CmdChangeCeiling,
-        CmdChangeCeilingDirect,
-        CmdRestart,
-        CmdAndLogical,
-        CmdOrLogical,
-        CmdAndBitwise,
-        CmdOrBitwise,
-        CmdEorBitwise,
-        CmdNegateLogical,
-        CmdLShift,
-        CmdRShift,
-        CmdUnaryMinus,
-        CmdIfNotGoto,
-        CmdLineSide,
-        CmdScriptWait,
-        CmdScriptWaitDirect,
-        CmdClearLineSpecial,
-        CmdCaseGoto,
-        CmdBeginPrint,
-        CmdEndPrint,
-        CmdPrintString,
-        CmdPrintNumber,
-        CmdPrintCharacter,
-        CmdPlayerCount,
-        CmdGameType,
-        CmdGameSkill,
-        CmdTimer,
-        CmdSectorSound,
-        CmdAmbientSound,
-        CmdSoundSequence,
-        CmdSetLineTexture,
-        CmdSetLineBlocking,
-        CmdSetLineSpecial,
-        CmdThingSound,
-        CmdEndPrintBold,
-};
-
-static void ACSAssert(int condition, const char *fmt, ...)
+
+// Where the interpreter is, for assertion messages.
+// Only recorded as plain values; the text is built when an assertion fails.
+static struct
+{
+    int lump;                   // >= 0 while parsing the header
+    int script;
+    unsigned int offset;
+    int cmd;
+    dboolean have_cmd;
+} EvalContext = { -1 };
+
+static void ACSError(const char *fmt, ...)
 {
+    char context[64];
     char buf[128];
     va_list args;
 
-    if (condition)
-    {
-        return;
-    }
+    if (EvalContext.lump >= 0)
+        snprintf(context, sizeof(context), "header parsing of lump #%d",
+                 EvalContext.lump);
+    else if (EvalContext.have_cmd)
+        snprintf(context, sizeof(context), "script %d @0x%x, cmd=%d",
+                 EvalContext.script, EvalContext.offset, EvalContext.cmd);
+    else
+        snprintf(context, sizeof(context), "script %d @0x%x",
+                 EvalContext.script, EvalContext.offset);
 
     va_start(args, fmt);
     vsnprintf(buf, sizeof(buf), fmt, args);
     va_end(args);
-    I_Error("ACS assertion failure: in %s: %s", EvalContext, buf);
+    I_Error("ACS assertion failure: in %s: %s", context, buf);
 }
 
+#define ACSAssert(condition, ...) \
+    do { if (!(condition)) ACSError(__VA_ARGS__); } while (0)
+
 static int ReadCodeInt(void)
 {
     int result;
-    const int *ptr;
 
+    // The code isn't validated at load time: vanilla only fails on code a
+    // script actually reaches, and garbage past a terminate or between
+    // jump targets must still load, so the bounds check stays on every read.
     ACSAssert(PCodeOffset + 3 < ActionCodeSize,
               "unexpectedly reached end of ACS lump");
 
-    ptr = (const int *) (ActionCodeBase + PCodeOffset);
-    result = LittleLong(*ptr);
+    // Aligned words were byte-swapped once at load time
+    if (!(PCodeOffset & 3))
+    {
+        result = ActionCodeWords[PCodeOffset >> 2];
+    }
+    else
+    {
+        const int *ptr = (const int *) (ActionCodeBase + PCodeOffset);
+        result = LittleLong(*ptr);
+    }
     PCodeOffset += 4;
 
     return result;
@@ -387,7 +419,18 @@ void P_LoadACScripts(int lump)
     ActionCodeBase = W_LumpByNum(lump);
     ActionCodeSize = W_LumpLength(lump);
 
-    snprintf(EvalContext, sizeof(EvalContext), "header parsing of lump #%d", lump);
+    // Decode the code words up front so the interpreter can read them directly
+    {
+        int *words;
+        const int *src = (const int *) ActionCodeBase;
+
+        words = Z_MallocLevel((ActionCodeSize / 4 + 1) * sizeof(*words));
+        for (i = 0; i < ActionCodeSize / 4; i++)
+            words[i] = LittleLong(src[i]);
+        ActionCodeWords = words;
+    }
+
+    EvalContext.lump = lump;
 
     header = (const acsHeader_t *) ActionCodeBase;
     PCodeOffset = LittleLong(header->infoOffset);
@@ -396,6 +439,7 @@ void P_LoadACScripts(int lump)
 
     if (ACScriptCount == 0)
     {                           // Empty behavior lump
+        EvalContext.lump = -1;
         return;
     }
 
@@ -442,6 +486,8 @@ void P_LoadACScripts(int lump)
     }
 
     memset(MapVars, 0, sizeof(MapVars));
+
+    EvalContext.lump = -1;
 }
 
 static void StartOpenACS(int number, int infoIndex, int offset)
@@ -663,19 +709,334 @@ void T_InterpretACS(acs_t * script)
     ACScript = script;
     PCodeOffset = ACScript->ip;
 
+    EvalContext.script = ACSInfo[script->infoIndex].number;
+
     do
     {
-        snprintf(EvalContext, sizeof(EvalContext), "script %d @0x%x",
-                 ACSInfo[script->infoIndex].number, PCodeOffset);
+        EvalContext.offset = PCodeOffset;
+        EvalContext.have_cmd = false;
         cmd = ReadCodeInt();
-        snprintf(EvalContext, sizeof(EvalContext), "script %d @0x%x, cmd=%d",
-                 ACSInfo[script->infoIndex].number, PCodeOffset, cmd);
-        ACSAssert(cmd >= 0, "negative ACS instruction %d", cmd);
-        ACSAssert(cmd < arrlen(PCodeCmds),
-                  "invalid ACS instruction %d (maybe this WAD is designed "
-                  "for an advanced source port and is not vanilla "
-                  "compatible)", cmd);
-        action = PCodeCmds[cmd]();
+        EvalContext.offset = PCodeOffset;
+        EvalContext.cmd = cmd;
+        EvalContext.have_cmd = true;
+
+        switch (cmd)
+        {
+            case PCD_NOP:
+                action = CmdNOP();
+                break;
+            case PCD_TERMINATE:
+                action = CmdTerminate();
+                break;
+            case PCD_SUSPEND:
+                action = CmdSuspend();
+                break;
+            case PCD_PUSH_NUMBER:
+                action = CmdPushNumber();
+                break;
+            case PCD_LSPEC1:
+                action = CmdLSpec1();
+                break;
+            case PCD_LSPEC2:
+                action = CmdLSpec2();
+                break;
+            case PCD_LSPEC3:
+                action = CmdLSpec3();
+                break;
+            case PCD_LSPEC4:
+                action = CmdLSpec4();
+                break;
+            case PCD_LSPEC5:
+                action = CmdLSpec5();
+                break;
+            case PCD_LSPEC1_DIRECT:
+                action = CmdLSpec1Direct();
+                break;
+            case PCD_LSPEC2_DIRECT:
+                action = CmdLSpec2Direct();
+                break;
+            case PCD_LSPEC3_DIRECT:
+                action = CmdLSpec3Direct();
+                break;
+            case PCD_LSPEC4_DIRECT:
+                action = CmdLSpec4Direct();
+                break;
+            case PCD_LSPEC5_DIRECT:
+                action = CmdLSpec5Direct();
+                break;
+            case PCD_ADD:
+                action = CmdAdd();
+                break;
+            case PCD_SUBTRACT:
+                action = CmdSubtract();
+                break;
+            case PCD_MULTIPLY:
+                action = CmdMultiply();
+                break;
+            case PCD_DIVIDE:
+                action = CmdDivide();
+                break;
+            case PCD_MODULUS:
+                action = CmdModulus();
+                break;
+            case PCD_EQ:
+                action = CmdEQ();
+                break;
+            case PCD_NE:
+                action = CmdNE();
+                break;
+            case PCD_LT:
+                action = CmdLT();
+                break;
+            case PCD_GT:
+                action = CmdGT();
+                break;
+            case PCD_LE:
+                action = CmdLE();
+                break;
+            case PCD_GE:
+                action = CmdGE();
+                break;
+            case PCD_ASSIGN_SCRIPT_VAR:
+                action = CmdAssignScriptVar();
+                break;
+            case PCD_ASSIGN_MAP_VAR:
+                action = CmdAssignMapVar();
+                break;
+            case PCD_ASSIGN_WORLD_VAR:
+                action = CmdAssignWorldVar();
+                break;
+            case PCD_PUSH_SCRIPT_VAR:
+                action = CmdPushScriptVar();
+                break;
+            case PCD_PUSH_MAP_VAR:
+                action = CmdPushMapVar();
+                break;
+            case PCD_PUSH_WORLD_VAR:
+                action = CmdPushWorldVar();
+                break;
+            case PCD_ADD_SCRIPT_VAR:
+                action = CmdAddScriptVar();
+                break;
+            case PCD_ADD_MAP_VAR:
+                action = CmdAddMapVar();
+                break;
+            case PCD_ADD_WORLD_VAR:
+                action = CmdAddWorldVar();
+                break;
+            case PCD_SUB_SCRIPT_VAR:
+                action = CmdSubScriptVar();
+                break;
+            case PCD_SUB_MAP_VAR:
+                action = CmdSubMapVar();
+                break;
+            case PCD_SUB_WORLD_VAR:
+                action = CmdSubWorldVar();
+                break;
+            case PCD_MUL_SCRIPT_VAR:
+                action = CmdMulScriptVar();
+                break;
+            case PCD_MUL_MAP_VAR:
+                action = CmdMulMapVar();
+                break;
+            case PCD_MUL_WORLD_VAR:
+                action = CmdMulWorldVar();
+                break;
+            case PCD_DIV_SCRIPT_VAR:
+                action = CmdDivScriptVar();
+                break;
+            case PCD_DIV_MAP_VAR:
+                action = CmdDivMapVar();
+                break;
+            case PCD_DIV_WORLD_VAR:
+                action = CmdDivWorldVar();
+                break;
+            case PCD_MOD_SCRIPT_VAR:
+                action = CmdModScriptVar();
+                break;
+            case PCD_MOD_MAP_VAR:
+                action = CmdModMapVar();
+                break;
+            case PCD_MOD_WORLD_VAR:
+                action = CmdModWorldVar();
+                break;
+            case PCD_INC_SCRIPT_VAR:
+                action = CmdIncScriptVar();
+                break;
+            case PCD_INC_MAP_VAR:
+                action = CmdIncMapVar();
+                break;
+            case PCD_INC_WORLD_VAR:
+                action = CmdIncWorldVar();
+                break;
+            case PCD_DEC_SCRIPT_VAR:
+                action = CmdDecScriptVar();
+                break;
+            case PCD_DEC_MAP_VAR:
+                action = CmdDecMapVar();
+                break;
+            case PCD_DEC_WORLD_VAR:
+                action = CmdDecWorldVar();
+                break;
+            case PCD_GOTO:
+                action = CmdGoto();
+                break;
+            case PCD_IF_GOTO:
+                action = CmdIfGoto();
+                break;
+            case PCD_DROP:
+                action = CmdDrop();
+                break;
+            case PCD_DELAY:
+                action = CmdDelay();
+                break;
+            case PCD_DELAY_DIRECT:
+                action = CmdDelayDirect();
+                break;
+            case PCD_RANDOM:
+                action = CmdRandom();
+                break;
+            case PCD_RANDOM_DIRECT:
+                action = CmdRandomDirect();
+                break;
+            case PCD_THING_COUNT:
+                action = CmdThingCount();
+                break;
+            case PCD_THING_COUNT_DIRECT:
+                action = CmdThingCountDirect();
+                break;
+            case PCD_TAG_WAIT:
+                action = CmdTagWait();
+                break;
+            case PCD_TAG_WAIT_DIRECT:
+                action = CmdTagWaitDirect();
+                break;
+            case PCD_POLY_WAIT:
+                action = CmdPolyWait();
+                break;
+            case PCD_POLY_WAIT_DIRECT:
+                action = CmdPolyWaitDirect();
+                break;
+            case PCD_CHANGE_FLOOR:
+                action = CmdChangeFloor();
+                break;
+            case PCD_CHANGE_FLOOR_DIRECT:
+                action = CmdChangeFloorDirect();
+                break;
+            case PCD_CHANGE_CEILING:
+                action = CmdChangeCeiling();
+                break;
+            case PCD_CHANGE_CEILING_DIRECT:
+                action = CmdChangeCeilingDirect();
+                break;
+            case PCD_RESTART:
+                action = CmdRestart();
+                break;
+            case PCD_AND_LOGICAL:
+                action = CmdAndLogical();
+                break;
+            case PCD_OR_LOGICAL:
+                action = CmdOrLogical();
+                break;
+            case PCD_AND_BITWISE:
+                action = CmdAndBitwise();
+                break;
+            case PCD_OR_BITWISE:
+                action = CmdOrBitwise();
+                break;
+            case PCD_EOR_BITWISE:
+                action = CmdEorBitwise();
+                break;
+            case PCD_NEGATE_LOGICAL:
+                action = CmdNegateLogical();
+                break;
+            case PCD_LSHIFT:
+                action = CmdLShift();
+                break;
+            case PCD_RSHIFT:
+                action = CmdRShift();
+                break;
+            case PCD_UNARY_MINUS:
+                action = CmdUnaryMinus();
+                break;
+            case PCD_IF_NOT_GOTO:
+                action = CmdIfNotGoto();
+                break;
+            case PCD_LINE_SIDE:
+                action = CmdLineSide();
+                break;
+            case PCD_SCRIPT_WAIT:
+                action = CmdScriptWait();
+                break;
+            case PCD_SCRIPT_WAIT_DIRECT:
+                action = CmdScriptWaitDirect();
+                break;
+            case PCD_CLEAR_LINE_SPECIAL:
+                action = CmdClearLineSpecial();
+                break;
+            case PCD_CASE_GOTO:
+                action = CmdCaseGoto();
+                break;
+            case PCD_BEGIN_PRINT:
+                action = CmdBeginPrint();
+                break;
+            case PCD_END_PRINT:
+                action = CmdEndPrint();
+                break;
+            case PCD_PRINT_STRING:
+                action = CmdPrintString();
+                break;
+            case PCD_PRINT_NUMBER:
+                action = CmdPrintNumber();
+                break;
+            case PCD_PRINT_CHARACTER:
+                action = CmdPrintCharacter();
+                break;
+            case PCD_PLAYER_COUNT:
+                action = CmdPlayerCount();
+                break;
+            case PCD_GAME_TYPE:
+                action = CmdGameType();
+                break;
+            case PCD_GAME_SKILL:
+                action = CmdGameSkill();
+                break;
+            case PCD_TIMER:
+                action = CmdTimer();
+                break;
+            case PCD_SECTOR_SOUND:
+                action = CmdSectorSound();
+                break;
+            case PCD_AMBIENT_SOUND:
+                action = CmdAmbientSound();
+                break;
+            case PCD_SOUND_SEQUENCE:
+                action = CmdSoundSequence();
+                break;
+            case PCD_SET_LINE_TEXTURE:
+                action = CmdSetLineTexture();
+                break;
+            case PCD_SET_LINE_BLOCKING:
+                action = CmdSetLineBlocking();
+                break;
+            case PCD_SET_LINE_SPECIAL:
+                action = CmdSetLineSpecial();
+                break;
+            case PCD_THING_SOUND:
+                action = CmdThingSound();
+                break;
+            case PCD_END_PRINT_BOLD:
+                action = CmdEndPrintBold();
+                break;
+            default:
+                ACSAssert(cmd >= 0, "negative ACS instruction %d", cmd);
+                ACSAssert(cmd < PCODE_COMMAND_COUNT,
+                          "invalid ACS instruction %d (maybe this WAD is designed "
+                          "for an advanced source port and is not vanilla "
+                          "compatible)", cmd);
+                action = SCRIPT_TERMINATE;
+                break;
+        }
     } while (action == SCRIPT_CONTINUE);
 
     ACScript->ip = PCodeOffset;
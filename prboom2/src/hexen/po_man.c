@@ -45,6 +45,8 @@ static void UpdateSegBBox(seg_t * seg);
 static void RotatePt(int an, fixed_t * x, fixed_t * y, fixed_t startSpotX, fixed_t startSpotY);
 void UnLinkPolyobj(polyobj_t * po);
 void LinkPolyobj(polyobj_t * po);
+static void RelinkPolyobj(polyobj_t * po);
+static dboolean PolyobjNearMobjs(polyobj_t * po);
 static dboolean CheckMobjBlocking(seg_t * seg, polyobj_t * po);
 static void InitBlockMap(void);
 static void IterFindPolySegs(int x, int y, seg_t ** segList);
@@ -736,14 +738,13 @@ dboolean PO_MovePolyobj(int num, int x, int y)
     polyobj_t *po;
     vertex_t *prevPts;
     dboolean blocked;
+    dboolean unlinked;
 
     if (!(po = GetPolyobj(num)))
     {
         I_Error("PO_MovePolyobj:  Invalid polyobj number: %d\n", num);
     }
 
-    UnLinkPolyobj(po);
-
     segList = po->segs;
     prevPts = po->prevPts;
     blocked = false;
@@ -774,12 +775,19 @@ dboolean PO_MovePolyobj(int num, int x, int y)
         (*prevPts).x += x;      // previous points are unique for each seg
         (*prevPts).y += y;
     }
-    segList = po->segs;
-    for (count = po->numsegs; count; count--, segList++)
+    unlinked = PolyobjNearMobjs(po);
+    if (unlinked)
     {
-        if (CheckMobjBlocking(*segList, po))
+        // Thrusting checks positions, which must not see this polyobj
+        UnLinkPolyobj(po);
+
+        segList = po->segs;
+        for (count = po->numsegs; count; count--, segList++)
         {
-            blocked = true;
+            if (CheckMobjBlocking(*segList, po))
+            {
+                blocked = true;
+            }
         }
     }
     if (blocked)
@@ -821,7 +829,14 @@ dboolean PO_MovePolyobj(int num, int x, int y)
     }
     po->startSpot.x += x;
     po->startSpot.y += y;
-    LinkPolyobj(po);
+    if (unlinked)
+    {
+        LinkPolyobj(po);
+    }
+    else
+    {
+        RelinkPolyobj(po);
+    }
     ResetPolySubSector(po);
     return true;
 }
@@ -853,6 +868,7 @@ dboolean PO_RotatePolyobj(int num, angle_t angle)
     int an;
     polyobj_t *po;
     dboolean blocked;
+    dboolean unlinked;
 
     if (!(po = GetPolyobj(num)))
     {
@@ -860,8 +876,6 @@ dboolean PO_RotatePolyobj(int num, angle_t angle)
     }
     an = (po->angle + angle) >> ANGLETOFINESHIFT;
 
-    UnLinkPolyobj(po);
-
     segList = po->segs;
     originalPts = po->originalPts;
     prevPts = po->prevPts;
@@ -876,12 +890,18 @@ dboolean PO_RotatePolyobj(int num, angle_t angle)
         RotatePt(an, &(*segList)->v1->x, &(*segList)->v1->y, po->startSpot.x,
                  po->startSpot.y);
     }
+    unlinked = PolyobjNearMobjs(po);
+    if (unlinked)
+    {
+        // Thrusting checks positions, which must not see this polyobj
+        UnLinkPolyobj(po);
+    }
     segList = po->segs;
     blocked = false;
     validcount++;
     for (count = po->numsegs; count; count--, segList++)
     {
-        if (CheckMobjBlocking(*segList, po))
+        if (unlinked && CheckMobjBlocking(*segList, po))
         {
             blocked = true;
         }
@@ -916,50 +936,114 @@ dboolean PO_RotatePolyobj(int num, angle_t angle)
         return false;
     }
     po->angle += angle;
-    LinkPolyobj(po);
+    if (unlinked)
+    {
+        LinkPolyobj(po);
+    }
+    else
+    {
+        RelinkPolyobj(po);
+    }
     ResetPolySubSector(po);
     return true;
 }
 
-void UnLinkPolyobj(polyobj_t * po)
+static void UnLinkPolyobjCell(polyobj_t * po, int index)
 {
     polyblock_t *link;
-    int i, j;
-    int index;
 
-    // remove the polyobj from each blockmap section
-    for (j = po->bbox[BOXBOTTOM]; j <= po->bbox[BOXTOP]; j++)
+    link = PolyBlockMap[index];
+    while (link != NULL && link->polyobj != po)
     {
-        index = j * bmapwidth;
-        for (i = po->bbox[BOXLEFT]; i <= po->bbox[BOXRIGHT]; i++)
+        link = link->next;
+    }
+    if (link == NULL)
+    {                           // polyobj not located in the link cell
+        return;
+    }
+    link->polyobj = NULL;
+}
+
+static void LinkPolyobjCell(polyobj_t * po, int index)
+{
+    polyblock_t **link;
+    polyblock_t *tempLink;
+
+    link = &PolyBlockMap[index];
+    if (!(*link))
+    {                           // Create a new link at the current block cell
+        *link = Z_MallocLevel(sizeof(polyblock_t));
+        (*link)->next = NULL;
+        (*link)->prev = NULL;
+        (*link)->polyobj = po;
+        return;
+    }
+
+    tempLink = *link;
+    while (tempLink->next != NULL && tempLink->polyobj != NULL)
+    {
+        tempLink = tempLink->next;
+    }
+    if (tempLink->polyobj == NULL)
+    {
+        tempLink->polyobj = po;
+    }
+    else
+    {
+        tempLink->next = Z_MallocLevel(sizeof(polyblock_t));
+        tempLink->next->next = NULL;
+        tempLink->next->prev = tempLink;
+        tempLink->next->polyobj = po;
+    }
+}
+
+// Same as UnLinkPolyobjCell followed by LinkPolyobjCell: the polyobj ends
+// up in the first free slot of the cell, which is its own unless another
+// polyobj has left the cell since it was linked.
+
+static void RelinkPolyobjCell(polyobj_t * po, int index)
+{
+    polyblock_t *link;
+
+    link = PolyBlockMap[index];
+    while (link != NULL && link->polyobj != NULL && link->polyobj != po)
+    {
+        link = link->next;
+    }
+    if (link == NULL)
+    {                           // polyobj not located in the link cell
+        LinkPolyobjCell(po, index);
+        return;
+    }
+    if (link->polyobj == po)
+    {
+        return;
+    }
+    link->polyobj = po;
+    for (link = link->next; link != NULL; link = link->next)
+    {
+        if (link->polyobj == po)
         {
-            if (i >= 0 && i < bmapwidth && j >= 0 && j < bmapheight)
-            {
-                link = PolyBlockMap[index + i];
-                while (link != NULL && link->polyobj != po)
-                {
-                    link = link->next;
-                }
-                if (link == NULL)
-                {               // polyobj not located in the link cell
-                    continue;
-                }
-                link->polyobj = NULL;
-            }
+            link->polyobj = NULL;
+            return;
         }
     }
 }
 
-void LinkPolyobj(polyobj_t * po)
+static dboolean PolyobjBlockInBox(const int *bbox, int i, int j)
+{
+    return i >= bbox[BOXLEFT] && i <= bbox[BOXRIGHT]
+        && j >= bbox[BOXBOTTOM] && j <= bbox[BOXTOP];
+}
+
+// calculate the polyobj bbox, in blockmap cells
+static void SetPolyobjBlockBox(polyobj_t * po)
 {
     int leftX, rightX;
     int topY, bottomY;
     seg_t **tempSeg;
-    polyblock_t **link;
-    polyblock_t *tempLink;
-    int i, j;
+    int i;
 
-    // calculate the polyobj bbox
     tempSeg = po->segs;
     rightX = leftX = (*tempSeg)->v1->x;
     topY = bottomY = (*tempSeg)->v1->y;
@@ -987,49 +1071,156 @@ void LinkPolyobj(polyobj_t * po)
     po->bbox[BOXLEFT] = (leftX - bmaporgx) >> MAPBLOCKSHIFT;
     po->bbox[BOXTOP] = (topY - bmaporgy) >> MAPBLOCKSHIFT;
     po->bbox[BOXBOTTOM] = (bottomY - bmaporgy) >> MAPBLOCKSHIFT;
+}
+
+void UnLinkPolyobj(polyobj_t * po)
+{
+    int i, j;
+
+    // remove the polyobj from each blockmap section
+    for (j = po->bbox[BOXBOTTOM]; j <= po->bbox[BOXTOP]; j++)
+    {
+        for (i = po->bbox[BOXLEFT]; i <= po->bbox[BOXRIGHT]; i++)
+        {
+            if (i >= 0 && i < bmapwidth && j >= 0 && j < bmapheight)
+            {
+                UnLinkPolyobjCell(po, j * bmapwidth + i);
+            }
+        }
+    }
+}
+
+void LinkPolyobj(polyobj_t * po)
+{
+    int i, j;
+
+    SetPolyobjBlockBox(po);
+
     // add the polyobj to each blockmap section
-    for (j = po->bbox[BOXBOTTOM] * bmapwidth;
-         j <= po->bbox[BOXTOP] * bmapwidth; j += bmapwidth)
+    for (j = po->bbox[BOXBOTTOM]; j <= po->bbox[BOXTOP]; j++)
     {
         for (i = po->bbox[BOXLEFT]; i <= po->bbox[BOXRIGHT]; i++)
         {
-            if (i >= 0 && i < bmapwidth && j >= 0
-                && j < bmapheight * bmapwidth)
+            if (i >= 0 && i < bmapwidth && j >= 0 && j < bmapheight)
             {
-                link = &PolyBlockMap[j + i];
-                if (!(*link))
-                {               // Create a new link at the current block cell
-                    *link = Z_MallocLevel(sizeof(polyblock_t));
-                    (*link)->next = NULL;
-                    (*link)->prev = NULL;
-                    (*link)->polyobj = po;
-                    continue;
-                }
-                else
+                LinkPolyobjCell(po, j * bmapwidth + i);
+            }
+            // else, don't link the polyobj, since it's off the map
+        }
+    }
+}
+
+// Move a polyobj that was never unlinked to the cells it covers now.
+// The result is the same as UnLinkPolyobj before the move and
+// LinkPolyobj after it, but only cells entered or left by the polyobj
+// need more than a short walk.
+
+static void RelinkPolyobj(polyobj_t * po)
+{
+    int oldbbox[4];
+    int i, j;
+
+    memcpy(oldbbox, po->bbox, sizeof(oldbbox));
+    SetPolyobjBlockBox(po);
+
+    for (j = oldbbox[BOXBOTTOM]; j <= oldbbox[BOXTOP]; j++)
+    {
+        for (i = oldbbox[BOXLEFT]; i <= oldbbox[BOXRIGHT]; i++)
+        {
+            if (i >= 0 && i < bmapwidth && j >= 0 && j < bmapheight
+                && !PolyobjBlockInBox(po->bbox, i, j))
+            {
+                UnLinkPolyobjCell(po, j * bmapwidth + i);
+            }
+        }
+    }
+
+    for (j = po->bbox[BOXBOTTOM]; j <= po->bbox[BOXTOP]; j++)
+    {
+        for (i = po->bbox[BOXLEFT]; i <= po->bbox[BOXRIGHT]; i++)
+        {
+            if (i >= 0 && i < bmapwidth && j >= 0 && j < bmapheight)
+            {
+                if (PolyobjBlockInBox(oldbbox, i, j))
                 {
-                    tempLink = *link;
-                    while (tempLink->next != NULL
-                           && tempLink->polyobj != NULL)
-                    {
-                        tempLink = tempLink->next;
-                    }
+                    RelinkPolyobjCell(po, j * bmapwidth + i);
                 }
-                if (tempLink->polyobj == NULL)
+                else
                 {
-                    tempLink->polyobj = po;
-                    continue;
+                    LinkPolyobjCell(po, j * bmapwidth + i);
                 }
-                else
+            }
+        }
+    }
+}
+
+// Whether CheckMobjBlocking could find anything for any seg of the
+// polyobj.  The box covers the line bboxes as they are now and as they
+// will be once rotated into place, since a rotation checks each seg
+// before updating its line.  If nothing solid is close, the per-seg scans
+// are skipped, and the polyobj can stay in the blockmap while it moves.
+
+static dboolean PolyobjNearMobjs(polyobj_t * po)
+{
+    mobj_t *mobj;
+    int i, j;
+    int left, right, top, bottom;
+    fixed_t bbox[4];
+    seg_t **segList;
+    int count;
+
+    segList = po->segs;
+    memcpy(bbox, (*segList)->linedef->bbox, sizeof(bbox));
+    for (count = po->numsegs; count; count--, segList++)
+    {
+        line_t *ld = (*segList)->linedef;
+
+        bbox[BOXTOP] = MAX(bbox[BOXTOP], ld->bbox[BOXTOP]);
+        bbox[BOXBOTTOM] = MIN(bbox[BOXBOTTOM], ld->bbox[BOXBOTTOM]);
+        bbox[BOXLEFT] = MIN(bbox[BOXLEFT], ld->bbox[BOXLEFT]);
+        bbox[BOXRIGHT] = MAX(bbox[BOXRIGHT], ld->bbox[BOXRIGHT]);
+
+        bbox[BOXTOP] = MAX(bbox[BOXTOP], MAX((*segList)->v1->y, (*segList)->v2->y));
+        bbox[BOXBOTTOM] = MIN(bbox[BOXBOTTOM], MIN((*segList)->v1->y, (*segList)->v2->y));
+        bbox[BOXLEFT] = MIN(bbox[BOXLEFT], MIN((*segList)->v1->x, (*segList)->v2->x));
+        bbox[BOXRIGHT] = MAX(bbox[BOXRIGHT], MAX((*segList)->v1->x, (*segList)->v2->x));
+    }
+
+    top = (bbox[BOXTOP] - bmaporgy + MAXRADIUS) >> MAPBLOCKSHIFT;
+    bottom = (bbox[BOXBOTTOM] - bmaporgy - MAXRADIUS) >> MAPBLOCKSHIFT;
+    left = (bbox[BOXLEFT] - bmaporgx - MAXRADIUS) >> MAPBLOCKSHIFT;
+    right = (bbox[BOXRIGHT] - bmaporgx + MAXRADIUS) >> MAPBLOCKSHIFT;
+
+    bottom = bottom < 0 ? 0 : bottom;
+    bottom = bottom >= bmapheight ? bmapheight - 1 : bottom;
+    top = top < 0 ? 0 : top;
+    top = top >= bmapheight ? bmapheight - 1 : top;
+    left = left < 0 ? 0 : left;
+    left = left >= bmapwidth ? bmapwidth - 1 : left;
+    right = right < 0 ? 0 : right;
+    right = right >= bmapwidth ? bmapwidth - 1 : right;
+
+    for (j = bottom * bmapwidth; j <= top * bmapwidth; j += bmapwidth)
+    {
+        for (i = left; i <= right; i++)
+        {
+            for (mobj = blocklinks[j + i]; mobj; mobj = mobj->bnext)
+            {
+                if (mobj->flags & MF_SOLID || mobj->player)
                 {
-                    tempLink->next = Z_MallocLevel(sizeof(polyblock_t));
-                    tempLink->next->next = NULL;
-                    tempLink->next->prev = tempLink;
-                    tempLink->next->polyobj = po;
+                    if (mobj->x + mobj->radius <= bbox[BOXLEFT]
+                        || mobj->x - mobj->radius >= bbox[BOXRIGHT]
+                        || mobj->y + mobj->radius <= bbox[BOXBOTTOM]
+                        || mobj->y - mobj->radius >= bbox[BOXTOP])
+                    {
+                        continue;
+                    }
+                    return true;
                 }
             }
-            // else, don't link the polyobj, since it's off the map
         }
     }
+    return false;
 }
 
 static dboolean CheckMobjBlocking(seg_t * seg, polyobj_t * po)
@@ -15,6 +15,7 @@
 //
 
 #include <stdint.h>
+#include <zlib.h>
 
 #include "doomstat.h"
 #include "p_tick.h"
@@ -97,19 +98,120 @@ static int TargetPlayerCount;
 extern int inv_ptr;
 extern int curpos;
 
-typedef struct
-{
-  size_t size;
-  byte *buffer;
+// Hub map archives are kept compressed and shared. Each archive is
+// immutable once written; the live hub state, key frames and copies of
+// key frames all hold references to the same archive instead of copies.
+typedef struct map_archive_s
+{
+  int id;
+  int refcount;
+  uint32_t hash;           // crc32 of the uncompressed data
+  size_t size;             // uncompressed length
+  size_t stored_size;      // compressed length
+  byte *data;
+  struct map_archive_s *next;
 } map_archive_t;
 
-static map_archive_t map_archive[MAX_MAPS];
-static map_archive_t *ma_p;
+struct map_archive_refs_s
+{
+  map_archive_t *archive[MAX_MAPS];
+};
+
+// Written in place of the size when a save references an archive
+#define MAP_ARCHIVE_SHARED ((size_t) -1)
+
+static map_archive_t *map_archive[MAX_MAPS];
+static map_archive_t *archive_list;
+static int last_archive_id;
+
+static dboolean share_map_archives;
+static map_archive_refs_t *stored_refs;
+
+// Uncompressed working copy of the map being read or written
+static byte *sv_buffer;
+static size_t sv_buffer_size;
+static size_t sv_buffer_length;
 static byte *buffer_p;
 
+static void ReserveBuffer(size_t size)
+{
+  if (size > sv_buffer_size)
+  {
+    if (!sv_buffer_size)
+      sv_buffer_size = 64 * 1024;
+
+    while (size > sv_buffer_size)
+      sv_buffer_size *= 2;
+
+    sv_buffer = Z_Realloc(sv_buffer, sv_buffer_size);
+  }
+}
+
+static map_archive_t *NewMapArchive(const byte *data, size_t size)
+{
+  map_archive_t *ma;
+  uLongf stored_size;
+  byte *stored;
+
+  stored_size = compressBound(size);
+  stored = Z_Malloc(stored_size);
+
+  if (compress2(stored, &stored_size, data, size, Z_BEST_SPEED) != Z_OK)
+    I_Error("NewMapArchive: compression failed");
+
+  ma = Z_Malloc(sizeof(*ma));
+  ma->id = ++last_archive_id;
+  ma->refcount = 1;
+  ma->hash = crc32(0, data, size);
+  ma->size = size;
+  ma->stored_size = stored_size;
+  ma->data = Z_Realloc(stored, stored_size);
+  ma->next = archive_list;
+  archive_list = ma;
+
+  return ma;
+}
+
+static void ExpandMapArchive(const map_archive_t *ma, byte *dest)
+{
+  uLongf size = ma->size;
+
+  if (uncompress(dest, &size, ma->data, ma->stored_size) != Z_OK || size != ma->size)
+    I_Error("ExpandMapArchive: corrupt map archive");
+}
+
+static void ReleaseMapArchive(map_archive_t *ma)
+{
+  map_archive_t **link;
+
+  if (!ma || --ma->refcount > 0)
+    return;
+
+  for (link = &archive_list; *link; link = &(*link)->next)
+    if (*link == ma)
+    {
+      *link = ma->next;
+      break;
+    }
+
+  Z_Free(ma->data);
+  Z_Free(ma);
+}
+
+static map_archive_t *FindMapArchive(int id, uint32_t hash)
+{
+  map_archive_t *ma;
+
+  for (ma = archive_list; ma; ma = ma->next)
+    if (ma->id == id && ma->hash == hash)
+      return ma;
+
+  return NULL;
+}
+
 static dboolean MapArchiveExists(int map)
 {
-  return (map_archive[map].buffer != NULL);
+  return (map_archive[map] != NULL);
 }
 
 static void FreeMapArchive(void)
@@ -117,45 +219,141 @@ static void FreeMapArchive(void)
   int map;
 
   for (map = 0; map < MAX_MAPS; ++map)
-    if (map_archive[map].buffer)
-    {
-      Z_Free(map_archive[map].buffer);
-      map_archive[map].buffer = NULL;
-      map_archive[map].size = 0;
-    }
+  {
+    ReleaseMapArchive(map_archive[map]);
+    map_archive[map] = NULL;
+  }
+}
+
+// Controls whether the next SV_StoreMapArchive writes references to the
+// shared archives instead of their contents. Only valid for buffers that
+// stay in memory; the references are collected for SV_TakeMapArchiveRefs.
+void SV_ShareMapArchives(dboolean share)
+{
+  share_map_archives = share;
+}
+
+map_archive_refs_t *SV_TakeMapArchiveRefs(void)
+{
+  map_archive_refs_t *refs = stored_refs;
+
+  stored_refs = NULL;
+
+  return refs;
+}
+
+map_archive_refs_t *SV_CopyMapArchiveRefs(const map_archive_refs_t *refs)
+{
+  map_archive_refs_t *copy;
+  int i;
+
+  if (!refs)
+    return NULL;
+
+  copy = Z_Malloc(sizeof(*copy));
+  *copy = *refs;
+
+  for (i = 0; i < MAX_MAPS; ++i)
+    if (copy->archive[i])
+      copy->archive[i]->refcount++;
+
+  return copy;
+}
+
+void SV_ReleaseMapArchiveRefs(map_archive_refs_t *refs)
+{
+  int i;
+
+  if (!refs)
+    return;
+
+  for (i = 0; i < MAX_MAPS; ++i)
+    ReleaseMapArchive(refs->archive[i]);
+
+  Z_Free(refs);
 }
 
 void SV_StoreMapArchive(void)
 {
   int i;
 
+  if (share_map_archives)
+  {
+    SV_ReleaseMapArchiveRefs(stored_refs);
+    stored_refs = Z_Calloc(1, sizeof(*stored_refs));
+  }
+
   for (i = 0; i < MAX_MAPS; ++i)
   {
-    P_SAVE_X(map_archive[i].size);
+    map_archive_t *ma = map_archive[i];
+    size_t size;
 
-    if (map_archive[i].size)
+    if (!ma)
+    {
+      size = 0;
+      P_SAVE_X(size);
+    }
+    else if (share_map_archives)
+    {
+      size = MAP_ARCHIVE_SHARED;
+      P_SAVE_X(size);
+      P_SAVE_X(ma->id);
+      P_SAVE_X(ma->hash);
+
+      ma->refcount++;
+      stored_refs->archive[i] = ma;
+    }
+    else
     {
-      P_SAVE_SIZE(map_archive[i].buffer, map_archive[i].size);
+      size = ma->size;
+      P_SAVE_X(size);
+
+      CheckSaveGame(size);
+      ExpandMapArchive(ma, save_p);
+      save_p += size;
     }
   }
 }
 
 void SV_RestoreMapArchive(void)
 {
+  map_archive_t *restored[MAX_MAPS];
   int i;
 
-  FreeMapArchive();
-
   for (i = 0; i < MAX_MAPS; ++i)
   {
-    P_LOAD_X(map_archive[i].size);
+    size_t size;
+
+    P_LOAD_X(size);
+
+    if (size == MAP_ARCHIVE_SHARED)
+    {
+      int id;
+      uint32_t hash;
 
-    if (map_archive[i].size)
+      P_LOAD_X(id);
+      P_LOAD_X(hash);
+
+      restored[i] = FindMapArchive(id, hash);
+      if (!restored[i])
+        I_Error("SV_RestoreMapArchive: missing map archive %d", id);
+
+      restored[i]->refcount++;
+    }
+    else if (size)
+    {
+      restored[i] = NewMapArchive(save_p, size);
+      save_p += size;
+    }
+    else
     {
-      map_archive[i].buffer = Z_Malloc(map_archive[i].size);
-      P_LOAD_SIZE(map_archive[i].buffer, map_archive[i].size);
+      restored[i] = NULL;
     }
   }
+
+  // Release only after taking the new references, which may be the same
+  FreeMapArchive();
+  memcpy(map_archive, restored, sizeof(map_archive));
 }
 
 static dboolean SV_IsMobjThinker(thinker_t *th)
@@ -166,19 +364,15 @@ static dboolean SV_IsMobjThinker(thinker_t *th)
 
 static void CheckBuffer(size_t size)
 {
-  size_t delta = buffer_p - ma_p->buffer;
+  size_t delta = buffer_p - sv_buffer;
 
-  while (delta + size > ma_p->size)
-  {
-    ma_p->size += 1024;
-    ma_p->buffer = Z_Realloc(ma_p->buffer, ma_p->size);
-    buffer_p = ma_p->buffer + delta;
-  }
+  ReserveBuffer(delta + size);
+  buffer_p = sv_buffer + delta;
 }
 
 static void SV_Read(void *buffer, size_t size)
 {
-  if (buffer_p - ma_p->buffer + size > ma_p->size)
+  if (buffer_p - sv_buffer + size > sv_buffer_length)
   {
     I_Error("Invalid map archive in SV_Read");
   }
@@ -244,20 +438,41 @@ static void SV_WriteFlags(uint64_t val)
 
 static void SV_OpenRead(int map)
 {
-  ma_p = &map_archive[map];
-  buffer_p = ma_p->buffer;
+  map_archive_t *ma = map_archive[map];
+
+  ReserveBuffer(ma->size);
+  ExpandMapArchive(ma, sv_buffer);
+  sv_buffer_length = ma->size;
+  buffer_p = sv_buffer;
 }
 
 static void SV_OpenWrite(int map)
 {
-  ma_p = &map_archive[map];
-  if (ma_p->buffer)
+  ReserveBuffer(1024);
+  buffer_p = sv_buffer;
+}
+
+// Stores the written map, keeping the old archive if nothing changed
+static void SV_CloseWrite(int map)
+{
+  map_archive_t *ma = map_archive[map];
+  size_t size = buffer_p - sv_buffer;
+
+  if (ma && ma->size == size && ma->hash == crc32(0, sv_buffer, size))
   {
-    Z_Free(ma_p->buffer);
+    byte *old = Z_Malloc(size);
+    dboolean same;
+
+    ExpandMapArchive(ma, old);
+    same = !memcmp(old, sv_buffer, size);
+    Z_Free(old);
+
+    if (same)
+      return;
   }
-  ma_p->size = 1024;
-  ma_p->buffer = Z_Malloc(ma_p->size);
-  buffer_p = ma_p->buffer;
+
+  ReleaseMapArchive(ma);
+  map_archive[map] = NewMapArchive(sv_buffer, size);
 }
 
 static int GetMobjNum(mobj_t * mobj)
@@ -1902,6 +2117,8 @@ void SV_SaveMap(void)
 
     // Place a termination marker
     SV_WriteLong(ASEG_END);
+
+    SV_CloseWrite(gamemap);
 }
 
 void SV_LoadMap(void)
@@ -17,9 +17,18 @@
 #ifndef __HEXEN_SV_SAVE__
 #define __HEXEN_SV_SAVE__
 
+#include "doomtype.h"
+
 void SV_Init(void);
 void SV_MapTeleport(int map, int position);
 void SV_StoreMapArchive(void);
 void SV_RestoreMapArchive(void);
 
+typedef struct map_archive_refs_s map_archive_refs_t;
+
+void SV_ShareMapArchives(dboolean share);
+map_archive_refs_t *SV_TakeMapArchiveRefs(void);
+map_archive_refs_t *SV_CopyMapArchiveRefs(const map_archive_refs_t *refs);
+void SV_ReleaseMapArchiveRefs(map_archive_refs_t *refs);
+
 #endif
@@ -66,6 +66,7 @@ void HUlib_clearTextLine(hu_textline_t* t)
   t->linelen =         // killough 1/23 98: support multiple lines
     t->len = 0;
   t->l[0] = 0;
+  t->glyphs_valid = false;
 }
 
 //
@@ -115,35 +116,48 @@ dboolean HUlib_addCharToTextLine
 
     t->l[t->len++] = ch;
     t->l[t->len] = 0;
+    t->glyphs_valid = false;
     return true;
   }
 
 }
 
+static void HUlib_addGlyph(hu_textline_t* l, int x, int y, int lumpnum, int cm)
+{
+  hu_glyph_t* glyph;
+
+  if (l->glyph_count == l->glyph_capacity)
+  {
+    l->glyph_capacity = l->glyph_capacity ? l->glyph_capacity * 2 : 32;
+    l->glyphs = Z_Realloc(l->glyphs, l->glyph_capacity * sizeof(*l->glyphs));
+  }
+
+  glyph = &l->glyphs[l->glyph_count++];
+  glyph->x = x;
+  glyph->y = y;
+  glyph->lumpnum = lumpnum;
+  glyph->cm = cm;
+}
+
 //
-// HUlib_drawTextLine()
+// HUlib_layoutTextLine()
 //
-// Draws a hu_textline_t widget
+// Works out where each character of a hu_textline_t widget goes, so that
+// drawing it again is just a matter of drawing the patches
 //
-// Passed the hu_textline_t and flag whether to draw a cursor
-// Returns nothing
-//
-void HUlib_drawTextLine
-( hu_textline_t* l,
-  dboolean drawcursor )
+static void HUlib_layoutTextLine(hu_textline_t* l)
 {
-
   int     i;
   int     w;
   int     x;
   unsigned char c;
-  int oc = l->cm; //jff 2/17/98 remember default color
+  int cm = l->cm; //jff 2/17/98 remember default color
   int y;          // killough 1/18/98 -- support multiple lines
 
-  // draw the new stuff
+  l->glyph_count = 0;
 
   x = l->x;
-  y = l->y;
+  y = 0;
   for (i=0;i<l->len;i++)
   {
     c = toupper(l->l[i]); //jff insure were not getting a cheap toupper conv.
@@ -160,7 +174,7 @@ void HUlib_drawTextLine
       if (++i < l->len)
       {
         if (l->l[i] >= HU_COLOR && l->l[i] < HU_COLOR + CR_LIMIT)
-          l->cm = l->l[i] - HU_COLOR;
+          cm = l->l[i] - HU_COLOR;
         else if (l->l[i] < HU_COLOR)
           x += l->l[i];
       }
@@ -171,8 +185,7 @@ void HUlib_drawTextLine
       if (x+w-l->f[c - l->sc].leftoffset > BASE_WIDTH)
         break;
       // killough 1/18/98 -- support multiple lines:
-      // CPhipps - patch drawing updated
-      V_DrawNumPatch(x, y, FG, l->f[c - l->sc].lumpnum, l->cm, VPT_TRANS | l->flags);
+      HUlib_addGlyph(l, x, y, l->f[c - l->sc].lumpnum, cm);
       x += w;
     }
     else
@@ -182,14 +195,43 @@ void HUlib_drawTextLine
       break;
     }
   }
-  l->cm = oc; //jff 2/17/98 restore original color
+
+  l->cursor_x = x;
+  l->cursor_y = y;
+  l->glyph_x = l->x;
+  l->glyph_cm = l->cm;
+  l->glyphs_valid = true;
+}
+
+//
+// HUlib_drawTextLine()
+//
+// Draws a hu_textline_t widget
+//
+// Passed the hu_textline_t and flag whether to draw a cursor
+// Returns nothing
+//
+void HUlib_drawTextLine
+( hu_textline_t* l,
+  dboolean drawcursor )
+{
+  int i;
+  const hu_glyph_t* glyph;
+
+  if (!l->glyphs_valid || l->glyph_x != l->x || l->glyph_cm != l->cm)
+    HUlib_layoutTextLine(l);
+
+  // CPhipps - patch drawing updated
+  for (i = 0, glyph = l->glyphs; i < l->glyph_count; i++, glyph++)
+    V_DrawNumPatch(glyph->x, l->y + glyph->y, FG, glyph->lumpnum, glyph->cm, VPT_TRANS | l->flags);
 
   // draw the cursor if requested
-  if (drawcursor && x + l->f['_' - l->sc].width <= BASE_WIDTH)
+  if (drawcursor && l->cursor_x + l->f['_' - l->sc].width <= BASE_WIDTH)
   {
     // killough 1/18/98 -- support multiple lines
     // CPhipps - patch drawing updated
-    V_DrawNumPatch(x, y, FG, l->f['_' - l->sc].lumpnum, CR_DEFAULT, VPT_NONE | l->flags);
+    V_DrawNumPatch(l->cursor_x, l->y + l->cursor_y, FG, l->f['_' - l->sc].lumpnum,
+                   CR_DEFAULT, VPT_NONE | l->flags);
   }
 }
 
@@ -44,6 +44,15 @@
 
 #define HU_MAXLINELENGTH  80
 
+// A character of a text line, laid out and ready to draw
+typedef struct
+{
+  int x;
+  int y;                                // relative to the line
+  int lumpnum;
+  int cm;
+} hu_glyph_t;
+
 // Text Line widget
 typedef struct
 {
@@ -69,6 +78,16 @@ typedef struct
 
   int line_height;
   int space_width;
+
+  // The glyph run for l, kept until the text, x position or color changes
+  hu_glyph_t* glyphs;
+  int glyph_count;
+  int glyph_capacity;
+  int glyph_x;
+  int glyph_cm;
+  int cursor_x;
+  int cursor_y;
+  dboolean glyphs_valid;
 } hu_textline_t;
 
 //
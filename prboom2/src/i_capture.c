@@ -33,12 +33,14 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "i_sound.h"
 #include "i_video.h"
 #include "lprintf.h"
 #include "m_file.h"
 #include "i_system.h"
 #include "i_capture.h"
+#include "z_zone.h"
 
 #include "dsda/configuration.h"
 
@@ -65,6 +67,7 @@ static pipeinfo_t muxpipe;
 int cap_fps;
 int cap_frac;
 int cap_wipescreen;
+static int cap_yuv420;
 
 // parses a command with simple printf-style replacements.
 
@@ -72,6 +75,8 @@ int cap_wipescreen;
 // %h video height (px)
 // %s sound rate (hz)
 // %f filename passed to -viddump
+// %r capture frame rate
+// %p pixel format of the video stream (rgb24 or yuv420p)
 // %% single percent sign
 // TODO: add aspect ratio information
 //
@@ -102,6 +107,9 @@ static int parsecommand (char *out, const char *in, int len)
         case 'r':
           i = snprintf (out, len, "%u", cap_fps);
           break;
+        case 'p':
+          i = snprintf (out, len, "%s", cap_yuv420 ? "yuv420p" : "rgb24");
+          break;
         case '%':
           i = snprintf (out, len, "%%");
           break;
@@ -488,6 +496,259 @@ static int threadstderrproc (void *data)
 }
 
 
+// bounded frame queues
+// the game thread copies each frame into a preallocated slot and the
+// writer thread for that pipe pushes it to the encoder. the game thread
+// only waits when a queue is full, so no frames are ever dropped and
+// every video frame keeps its matching chunk of audio.
+
+#define CAPTURE_VIDEO_SLOTS 4
+#define CAPTURE_SOUND_SLOTS 16
+
+typedef struct
+{
+  unsigned char *data;   // raw frame as grabbed (rgb24 or s16le)
+  int data_size;
+  unsigned char *conv;   // yuv420p output, video only
+  int conv_size;
+  int length;            // bytes of data in use
+  int width;             // even-sized area converted to yuv420p
+  int height;
+  int stride;
+} capslot_t;
+
+typedef struct
+{
+  const char *name;
+  pipeinfo_t *pipe;
+  capslot_t *slots;
+  int numslots;
+  int head;
+  int tail;
+  int count;
+  int quit;
+  int yuv;
+  SDL_mutex *mutex;
+  SDL_cond *cond;
+  SDL_Thread *thread;
+
+  // statistics
+  int queued;
+  int written;
+  int dropped;
+  int stalls;
+  int peak;
+} capqueue_t;
+
+static capslot_t videoslots[CAPTURE_VIDEO_SLOTS];
+static capslot_t soundslots[CAPTURE_SOUND_SLOTS];
+static capqueue_t videoqueue = { "video", &videopipe, videoslots, CAPTURE_VIDEO_SLOTS };
+static capqueue_t soundqueue = { "sound", &soundpipe, soundslots, CAPTURE_SOUND_SLOTS };
+
+
+// rgb24 -> yuv420p, bt.601 limited range, chroma from 2x2 averages.
+// width and height must be even. plain fixed point so the compiler is
+// free to vectorize the inner loops.
+static void I_ConvertYUV420 (unsigned char *dst, const unsigned char *src,
+                             int width, int height, int stride)
+{
+  unsigned char *py = dst;
+  unsigned char *pu = dst + width * height;
+  unsigned char *pv = pu + (width / 2) * (height / 2);
+  int x, y;
+
+  for (y = 0; y < height; y += 2)
+  {
+    const unsigned char *s0 = src + y * stride;
+    const unsigned char *s1 = s0 + stride;
+    unsigned char *y0 = py + y * width;
+    unsigned char *y1 = y0 + width;
+
+    for (x = 0; x < width; x++)
+    {
+      const unsigned char *a = s0 + x * 3;
+      const unsigned char *b = s1 + x * 3;
+
+      y0[x] = (unsigned char) (((66 * a[0] + 129 * a[1] + 25 * a[2] + 128) >> 8) + 16);
+      y1[x] = (unsigned char) (((66 * b[0] + 129 * b[1] + 25 * b[2] + 128) >> 8) + 16);
+    }
+
+    for (x = 0; x < width / 2; x++)
+    {
+      const unsigned char *a = s0 + x * 6;
+      const unsigned char *b = s1 + x * 6;
+      int r = a[0] + a[3] + b[0] + b[3];
+      int g = a[1] + a[4] + b[1] + b[4];
+      int bl = a[2] + a[5] + b[2] + b[5];
+
+      // biased so the shift never sees a negative value
+      *pu++ = (unsigned char) ((-38 * r - 74 * g + 112 * bl + (128 << 10) + 512) >> 10);
+      *pv++ = (unsigned char) ((112 * r - 94 * g - 18 * bl + (128 << 10) + 512) >> 10);
+    }
+  }
+}
+
+static int capwriterproc (void *data)
+{
+  capqueue_t *q = (capqueue_t *) data;
+
+  SDL_LockMutex (q->mutex);
+
+  while (1)
+  {
+    capslot_t *slot;
+    const unsigned char *out;
+    int outlen;
+    int ok;
+
+    while (!q->count && !q->quit)
+      SDL_CondWait (q->cond, q->mutex);
+
+    if (!q->count)
+      break;
+
+    slot = &q->slots[q->tail];
+    SDL_UnlockMutex (q->mutex);
+
+    if (q->yuv)
+    {
+      I_ConvertYUV420 (slot->conv, slot->data, slot->width, slot->height, slot->stride);
+      out = slot->conv;
+      outlen = slot->width * slot->height * 3 / 2;
+    }
+    else
+    {
+      out = slot->data;
+      outlen = slot->length;
+    }
+
+    ok = (fwrite (out, outlen, 1, q->pipe->f_stdin) == 1);
+
+    SDL_LockMutex (q->mutex);
+    if (ok)
+      q->written++;
+    else
+      q->dropped++;
+    q->tail = (q->tail + 1) % q->numslots;
+    q->count--;
+    SDL_CondSignal (q->cond);
+  }
+
+  SDL_UnlockMutex (q->mutex);
+  return 0;
+}
+
+static int I_StartCaptureQueue (capqueue_t *q)
+{
+  q->head = q->tail = q->count = q->quit = 0;
+  q->queued = q->written = q->dropped = q->stalls = q->peak = 0;
+
+  q->mutex = SDL_CreateMutex ();
+  q->cond = SDL_CreateCond ();
+  if (q->mutex && q->cond)
+    q->thread = SDL_CreateThread (capwriterproc, q->name, q);
+
+  if (!q->thread)
+  {
+    lprintf (LO_WARN, "I_CapturePrep: %s writer thread failed, writing from game thread\n", q->name);
+    if (q->cond)
+      SDL_DestroyCond (q->cond);
+    if (q->mutex)
+      SDL_DestroyMutex (q->mutex);
+    q->cond = NULL;
+    q->mutex = NULL;
+    return 0;
+  }
+
+  return 1;
+}
+
+// returns a free slot, waiting for the writer if the queue is full
+static capslot_t *I_CaptureSlot (capqueue_t *q)
+{
+  if (!q->thread)
+    return &q->slots[0];
+
+  SDL_LockMutex (q->mutex);
+  if (q->count == q->numslots)
+  {
+    q->stalls++;
+    while (q->count == q->numslots)
+      SDL_CondWait (q->cond, q->mutex);
+  }
+  SDL_UnlockMutex (q->mutex);
+
+  return &q->slots[q->head];
+}
+
+static void I_QueueCaptureSlot (capqueue_t *q, capslot_t *slot)
+{
+  q->queued++;
+
+  if (!q->thread)
+  { // synchronous fallback
+    const unsigned char *out = slot->data;
+    int outlen = slot->length;
+
+    if (q->yuv)
+    {
+      I_ConvertYUV420 (slot->conv, slot->data, slot->width, slot->height, slot->stride);
+      out = slot->conv;
+      outlen = slot->width * slot->height * 3 / 2;
+    }
+
+    if (fwrite (out, outlen, 1, q->pipe->f_stdin) != 1)
+    {
+      lprintf (LO_WARN, "I_CaptureFrame: error writing %spipe.\n", q->name);
+      q->dropped++;
+    }
+    else
+      q->written++;
+    return;
+  }
+
+  SDL_LockMutex (q->mutex);
+  q->head = (q->head + 1) % q->numslots;
+  q->count++;
+  if (q->count > q->peak)
+    q->peak = q->count;
+  SDL_CondSignal (q->cond);
+  SDL_UnlockMutex (q->mutex);
+}
+
+// drains the queue and stops the writer
+static void I_StopCaptureQueue (capqueue_t *q)
+{
+  int i;
+
+  if (q->thread)
+  {
+    SDL_LockMutex (q->mutex);
+    q->quit = 1;
+    SDL_CondSignal (q->cond);
+    SDL_UnlockMutex (q->mutex);
+
+    SDL_WaitThread (q->thread, NULL);
+    SDL_DestroyCond (q->cond);
+    SDL_DestroyMutex (q->mutex);
+    q->thread = NULL;
+    q->cond = NULL;
+    q->mutex = NULL;
+  }
+
+  for (i = 0; i < q->numslots; i++)
+  {
+    Z_Free (q->slots[i].data);
+    Z_Free (q->slots[i].conv);
+    memset (&q->slots[i], 0, sizeof (q->slots[i]));
+  }
+
+  lprintf (LO_INFO, "I_CaptureFinish: %s: %d frames queued, %d written, %d dropped, "
+           "%d stalls, peak queue %d/%d\n", q->name, q->queued, q->written,
+           q->dropped, q->stalls, q->peak, q->numslots);
+}
+
+
 // init and open sound, video pipes
 // fn is filename passed from command line, typically final output file
 void I_CapturePrep (const char *fn)
@@ -501,9 +762,27 @@ void I_CapturePrep (const char *fn)
   cap_muxcommand = dsda_StringConfig(dsda_config_cap_muxcommand);
   cap_wipescreen = dsda_IntConfig(dsda_config_cap_wipescreen);
   cap_fps = dsda_IntConfig(dsda_config_cap_fps);
+  cap_yuv420 = dsda_IntConfig(dsda_config_cap_yuv420);
 
   vid_fname = fn;
 
+  if (cap_yuv420 && !strstr (cap_videocommand, "%p"))
+  {
+    lprintf (LO_WARN, "I_CapturePrep: cap_videocommand has no %%p, using rgb24\n");
+    cap_yuv420 = 0;
+  }
+
+  if (cap_yuv420)
+  {
+    I_UpdateRenderSize ();
+    if ((renderW | renderH) & 1)
+    {
+      lprintf (LO_WARN, "I_CapturePrep: %dx%d is not valid for yuv420p, using rgb24\n",
+               renderW, renderH);
+      cap_yuv420 = 0;
+    }
+  }
+
   if (!parsecommand (soundpipe.command, cap_soundcommand, sizeof(soundpipe.command)))
   {
     lprintf (LO_ERROR, "I_CapturePrep: malformed command %s\n", cap_soundcommand);
@@ -552,6 +831,11 @@ void I_CapturePrep (const char *fn)
   videopipe.outthread = SDL_CreateThread (threadstdoutproc, "videopipe.outthread", &videopipe);
   videopipe.errthread = SDL_CreateThread (threadstderrproc, "videopipe.errthread", &videopipe);
 
+  // start writer threads
+  videoqueue.yuv = cap_yuv420;
+  I_StartCaptureQueue (&videoqueue);
+  I_StartCaptureQueue (&soundqueue);
+
   I_AtExit (I_CaptureFinish, true, "I_CaptureFinish", exit_priority_normal);
 }
 
@@ -563,7 +847,7 @@ void I_CapturePrep (const char *fn)
 void I_CaptureFrame (void)
 {
   unsigned char *snd;
-  unsigned char *vid;
+  capslot_t *slot;
   static int partsof35 = 0; // correct for sync when samplerate % 35 != 0
   int nsampreq;
 
@@ -581,18 +865,31 @@ void I_CaptureFrame (void)
   snd = I_GrabSound (nsampreq);
   if (snd)
   {
-    if (fwrite (snd, nsampreq * 4, 1, soundpipe.f_stdin) != 1)
-      lprintf(LO_WARN, "I_CaptureFrame: error writing soundpipe.\n");
-    //Z_Free (snd); // static buffer
+    slot = I_CaptureSlot (&soundqueue);
+    slot->length = nsampreq * 4;
+    if (slot->length > slot->data_size)
+    {
+      slot->data_size = slot->length;
+      slot->data = Z_Realloc (slot->data, slot->data_size);
+    }
+    memcpy (slot->data, snd, slot->length);
+    I_QueueCaptureSlot (&soundqueue, slot);
   }
-  vid = I_GrabScreen ();
-  if (vid)
+
+  slot = I_CaptureSlot (&videoqueue);
+  if (I_GrabScreenInto (&slot->data, &slot->data_size))
   {
-    if (fwrite (vid, renderW * renderH * 3, 1, videopipe.f_stdin) != 1)
-      lprintf(LO_WARN, "I_CaptureFrame: error writing videopipe.\n");
-    //Z_Free (vid); // static buffer
+    slot->length = renderW * renderH * 3;
+    slot->stride = renderW * 3;
+    slot->width = renderW & ~1;
+    slot->height = renderH & ~1;
+    if (videoqueue.yuv && slot->width * slot->height * 3 / 2 > slot->conv_size)
+    {
+      slot->conv_size = slot->width * slot->height * 3 / 2;
+      slot->conv = Z_Realloc (slot->conv, slot->conv_size);
+    }
+    I_QueueCaptureSlot (&videoqueue, slot);
   }
-
 }
 
 
@@ -610,6 +907,9 @@ void I_CaptureFinish (void)
   // is there a better way to do this?
 
   // (on windows, it doesn't matter what order we do it in)
+  I_StopCaptureQueue (&videoqueue);
+  I_StopCaptureQueue (&soundqueue);
+
   my_pclose3 (&videopipe);
   SDL_WaitThread (videopipe.outthread, &s);
   SDL_WaitThread (videopipe.errthread, &s);
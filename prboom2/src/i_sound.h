@@ -62,6 +62,9 @@ void I_SetChannels(void);
 // Get raw data lump index for sound descriptor.
 int I_GetSfxLumpNum (sfxinfo_t *sfxinfo);
 
+// Convert the sound lumps for mixing, in the background.
+void I_PrecacheSounds(void);
+
 // Starts a sound in a particular sound channel.
 int I_StartSound(int id, int channel, sfx_params_t *params);
 
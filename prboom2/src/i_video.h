@@ -65,8 +65,11 @@ void I_SetPalette(int pal); /* CPhipps - pass down palette number */
 void I_FinishUpdate (void);
 
 int I_ScreenShot (const char *fname);
+void I_FlushScreenShots (void);
 // NSM expose lower level screen data grab for vidcap
 unsigned char *I_GrabScreen (void);
+// grab into a caller-owned RGB24 buffer, reallocated as needed
+dboolean I_GrabScreenInto (unsigned char **pixels, int *pixels_size);
 
 /* I_StartTic
  * Called by D_DoomLoop,
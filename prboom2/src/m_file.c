@@ -57,6 +57,8 @@
 
 #include "m_file.h"
 
+#include "dsda/time.h"
+
 #ifdef _MSC_VER
 #define S_ISDIR(m)  (((m) & S_IFMT) == S_IFDIR)
 #define F_OK 0
@@ -427,6 +429,7 @@ int M_ReadFile(char const *name, byte **buffer)
       if (fread(*buffer, 1, length, fp) == length)
         {
           fclose(fp);
+          dsda_CountBytesRead(length);
           return length;
         }
       fclose(fp);
@@ -452,6 +455,7 @@ int M_ReadFileToString(char const *name, char **buffer) {
     if (fread(*buffer, 1, length, fp) == length)
     {
       fclose(fp);
+      dsda_CountBytesRead(length);
       (*buffer)[length] = '\0';
       return length;
     }
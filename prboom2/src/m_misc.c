@@ -124,6 +124,7 @@ cfg_def_t cfg_defs[] =
   MIGRATED_SETTING(dsda_config_mus_fluidsynth_reverb),
   MIGRATED_SETTING(dsda_config_mus_fluidsynth_gain),
   MIGRATED_SETTING(dsda_config_mus_opl_gain),
+  MIGRATED_SETTING(dsda_config_mus_opl_cache),
   MIGRATED_SETTING(dsda_config_mus_portmidi_reset_type),
   MIGRATED_SETTING(dsda_config_mus_portmidi_reset_delay),
   MIGRATED_SETTING(dsda_config_mus_portmidi_filter_sysex),
@@ -169,6 +170,8 @@ cfg_def_t cfg_defs[] =
   MIGRATED_SETTING(dsda_config_gl_usegamma),
   MIGRATED_SETTING(dsda_config_gl_health_bar),
   MIGRATED_SETTING(dsda_config_gl_usevbo),
+  MIGRATED_SETTING(dsda_config_gl_hires_cache),
+  MIGRATED_SETTING(dsda_config_gl_hires_cache_size),
 
   SETTING_HEADING("Mouse settings"),
   MIGRATED_SETTING(dsda_config_use_mouse),
@@ -322,6 +325,7 @@ cfg_def_t cfg_defs[] =
   MIGRATED_SETTING(dsda_config_cap_remove_tempfiles),
   MIGRATED_SETTING(dsda_config_cap_wipescreen),
   MIGRATED_SETTING(dsda_config_cap_fps),
+  MIGRATED_SETTING(dsda_config_cap_yuv420),
 
   SETTING_HEADING("Overrun settings"),
   MIGRATED_SETTING(dsda_config_overrun_spechit_warn),
@@ -383,13 +383,6 @@ void P_UnqualifiedMove(mobj_t *thing, fixed_t x, fixed_t y)
 
 dboolean P_TeleportMove (mobj_t* thing,fixed_t x,fixed_t y, dboolean boss)
 {
-  int     xl;
-  int     xh;
-  int     yl;
-  int     yh;
-  int     bx;
-  int     by;
-
   subsector_t*  newsubsec;
 
   /* killough 8/9/98: make telefragging more consistent, preserve compatibility */
@@ -426,15 +419,8 @@ dboolean P_TeleportMove (mobj_t* thing,fixed_t x,fixed_t y, dboolean boss)
 
   // stomp on any things contacted
 
-  xl = P_GetSafeBlockX(tmbbox[BOXLEFT] - bmaporgx - MAXRADIUS);
-  xh = P_GetSafeBlockX(tmbbox[BOXRIGHT] - bmaporgx + MAXRADIUS);
-  yl = P_GetSafeBlockY(tmbbox[BOXBOTTOM] - bmaporgy - MAXRADIUS);
-  yh = P_GetSafeBlockY(tmbbox[BOXTOP] - bmaporgy + MAXRADIUS);
-
-  for (bx=xl ; bx<=xh ; bx++)
-    for (by=yl ; by<=yh ; by++)
-      if (!P_BlockThingsIterator(bx,by,PIT_StompThing))
-        return false;
+  if (!P_BlockThingsNearBox(tmbbox, PIT_StompThing))
+    return false;
 
   // the move is ok,
   // so unlink from the old position & link into the new position
@@ -1297,17 +1283,10 @@ dboolean P_CheckPosition (mobj_t* thing,fixed_t x,fixed_t y)
   // based on their origin point, and can overlap
   // into adjacent blocks by up to MAXRADIUS units.
 
-  xl = P_GetSafeBlockX(tmbbox[BOXLEFT] - bmaporgx - MAXRADIUS);
-  xh = P_GetSafeBlockX(tmbbox[BOXRIGHT] - bmaporgx + MAXRADIUS);
-  yl = P_GetSafeBlockY(tmbbox[BOXBOTTOM] - bmaporgy - MAXRADIUS);
-  yh = P_GetSafeBlockY(tmbbox[BOXTOP] - bmaporgy + MAXRADIUS);
-
   BlockingMobj = NULL;
 
-  for (bx=xl ; bx<=xh ; bx++)
-    for (by=yl ; by<=yh ; by++)
-      if (!P_BlockThingsIterator(bx,by,PIT_CheckThing))
-        return false;
+  if (!P_BlockThingsNearBox(tmbbox, PIT_CheckThing))
+    return false;
 
   if (hexen && tmflags & MF_NOCLIP)
   {
@@ -2756,21 +2735,9 @@ dboolean PIT_RadiusAttack (mobj_t* thing)
 //
 void P_RadiusAttack(mobj_t* spot,mobj_t* source, int damage, int distance, dboolean damageSource)
 {
-  int x;
-  int y;
-
-  int xl;
-  int xh;
-  int yl;
-  int yh;
-
   fixed_t dist;
 
   dist = (distance+MAXRADIUS)<<FRACBITS;
-  yh = P_GetSafeBlockY(spot->y + dist - bmaporgy);
-  yl = P_GetSafeBlockY(spot->y - dist - bmaporgy);
-  xh = P_GetSafeBlockX(spot->x + dist - bmaporgx);
-  xl = P_GetSafeBlockX(spot->x - dist - bmaporgx);
   bombspot = spot;
   if (heretic && spot->type == HERETIC_MT_POD && spot->target)
   {
@@ -2783,12 +2750,16 @@ void P_RadiusAttack(mobj_t* spot,mobj_t* source, int damage, int distance, dbool
   bombdamage = damage;
   bombdistance = distance;
   DamageSource = damageSource;
-  for (y=yl ; y<=yh ; y++)
-    for (x=xl ; x<=xh ; x++)
-      P_BlockThingsIterator (x, y, PIT_RadiusAttack );
+  P_BlockThingsInRadius(spot->x, spot->y, dist, PIT_RadiusAttack);
 
   if (map_format.zdoom)
   {
+    int xl, xh, yl, yh;
+
+    yh = P_GetSafeBlockY(spot->y + dist - bmaporgy);
+    yl = P_GetSafeBlockY(spot->y - dist - bmaporgy);
+    xh = P_GetSafeBlockX(spot->x + dist - bmaporgx);
+    xl = P_GetSafeBlockX(spot->x - dist - bmaporgx);
     dsda_RadiusAttackDestructibles(xl, xh, yl, yh);
   }
 }
@@ -2909,9 +2880,6 @@ dboolean PIT_ChangeSector (mobj_t* thing)
 //
 dboolean P_ChangeSector(sector_t* sector, int crunch)
 {
-  int   x;
-  int   y;
-
   nofit = false;
   crushchange = crunch;
 
@@ -2924,15 +2892,22 @@ dboolean P_ChangeSector(sector_t* sector, int crunch)
 
   // re-check heights for all things near the moving sector
 
-  for (x=sector->blockbox[BOXLEFT] ; x<= sector->blockbox[BOXRIGHT] ; x++)
-    for (y=sector->blockbox[BOXBOTTOM];y<= sector->blockbox[BOXTOP] ; y++)
-      P_BlockThingsIterator (x, y, PIT_ChangeSector);
+  P_BlockThingsInBox(sector->blockbox[BOXLEFT], sector->blockbox[BOXRIGHT],
+                     sector->blockbox[BOXBOTTOM], sector->blockbox[BOXTOP],
+                     PIT_ChangeSector);
 
   return nofit;
 }
 
+// Bumped whenever a sector's thing list gains or loses a node, or has
+// its visited marks cleared, so P_CheckSector knows when it can carry on
+// down the list instead of rescanning it from the start.
+static unsigned int secnode_generation;
+
 void P_InitSectorSearch(mobj_in_sector_t *data, sector_t *sector)
 {
+  secnode_generation++;
+
   data->sector = sector;
 
   for (data->node = data->sector->touching_thinglist;
@@ -2983,22 +2958,38 @@ dboolean P_CheckSector(sector_t* sector, int crunch)
   // Things can arbitrarily be inserted and removed and it won't mess up.
   //
   // killough 4/7/98: simplified to avoid using complicated counter
+  //
+  // Everything ahead of the thing just processed has been visited, so
+  // unless the list changed underneath us, starting over would only walk
+  // back to where we are. Only rescan when it did.
 
   // Mark all things invalid
 
+  secnode_generation++;
   for (n=sector->touching_thinglist; n; n=n->m_snext)
     n->visited = false;
 
-  do
-    for (n=sector->touching_thinglist; n; n=n->m_snext)  // go through list
-      if (!n->visited)               // unprocessed thing found
+  n = sector->touching_thinglist;
+  while (n)  // go through list until all things left are marked valid
+    {
+    if (!n->visited)               // unprocessed thing found
+      {
+      n->visited  = true;          // mark thing as processed
+      if (!(n->m_thing->flags & MF_NOBLOCKMAP)) //jff 4/7/98 don't do these
         {
-        n->visited  = true;          // mark thing as processed
-        if (!(n->m_thing->flags & MF_NOBLOCKMAP)) //jff 4/7/98 don't do these
-          PIT_ChangeSector(n->m_thing);    // process it
-        break;                 // exit and start over
+        unsigned int generation = secnode_generation;
+
+        PIT_ChangeSector(n->m_thing);    // process it
+
+        if (secnode_generation != generation)
+          {
+          n = sector->touching_thinglist;  // start over
+          continue;
+          }
         }
-  while (n);  // repeat from scratch until all things left are marked valid
+      }
+    n = n->m_snext;
+    }
 
   return nofit;
 }
@@ -3103,6 +3094,7 @@ msecnode_t* P_AddSecnode(sector_t* s, mobj_t* thing, msecnode_t* nextnode)
   // of the list.
 
   node = P_GetSecnode();
+  secnode_generation++;
 
   // killough 4/4/98, 4/7/98: mark new nodes unvisited.
   node->visited = 0;
@@ -3164,6 +3156,7 @@ msecnode_t* P_DelSecnode(msecnode_t* node)
     // Return this node to the freelist
 
     P_PutSecnode(node);
+    secnode_generation++;
     return(tn);
     }
   return(NULL);
@@ -3387,7 +3380,7 @@ dboolean PIT_CheckOnmobjZ(mobj_t * thing)
 // Checks if the new Z position is legal
 mobj_t *P_CheckOnmobj(mobj_t * thing)
 {
-    int xl, xh, yl, yh, bx, by;
+    int xl, xh, yl, yh;
     subsector_t *newsubsec;
     fixed_t x;
     fixed_t y;
@@ -3436,13 +3429,11 @@ mobj_t *P_CheckOnmobj(mobj_t * thing)
     yl = (tmbbox[BOXBOTTOM] - bmaporgy - MAXRADIUS) >> MAPBLOCKSHIFT;
     yh = (tmbbox[BOXTOP] - bmaporgy + MAXRADIUS) >> MAPBLOCKSHIFT;
 
-    for (bx = xl; bx <= xh; bx++)
-        for (by = yl; by <= yh; by++)
-            if (!P_BlockThingsIterator(bx, by, PIT_CheckOnmobjZ))
-            {
-                *tmthing = oldmo;
-                return onmobj;
-            }
+    if (!P_BlockThingsInBox(xl, xh, yl, yh, PIT_CheckOnmobjZ))
+    {
+        *tmthing = oldmo;
+        return onmobj;
+    }
     *tmthing = oldmo;
     return NULL;
 }
@@ -3666,7 +3657,7 @@ dboolean PIT_ThrustStompThing(mobj_t * thing)
 
 void PIT_ThrustSpike(mobj_t * actor)
 {
-    int xl, xh, yl, yh, bx, by;
+    int xl, xh, yl, yh;
     int x0, x2, y0, y2;
 
     tsthing = actor;
@@ -3682,9 +3673,7 @@ void PIT_ThrustSpike(mobj_t * actor)
     yh = (y2 - bmaporgy + MAXRADIUS) >> MAPBLOCKSHIFT;
 
     // stomp on any things contacted
-    for (bx = xl; bx <= xh; bx++)
-        for (by = yl; by <= yh; by++)
-            P_BlockThingsIterator(bx, by, PIT_ThrustStompThing);
+    P_BlockThingsInBox(xl, xh, yl, yh, PIT_ThrustStompThing);
 }
 
 static void CheckForPushSpecial(line_t * line, int side, mobj_t * mobj)
@@ -596,6 +596,173 @@ dboolean P_BlockThingsIterator(int x, int y, dboolean func(mobj_t*))
   return true;
 }
 
+//
+// Thing queries
+//
+// Each query walks its blocks in the order its callers have always used,
+// and the things in a block in blocklinks order, so a search moved onto
+// one of these visits exactly what it did before, in the same order.
+// Like P_BlockThingsIterator, a query stops as soon as func returns
+// false, and then returns false itself.
+//
+
+static dboolean P_BlockThingsAt(int index, dboolean func(mobj_t*))
+{
+  mobj_t *mobj;
+  for (mobj = blocklinks[index]; mobj; mobj = mobj->bnext)
+    if (!func(mobj))
+      return false;
+  return true;
+}
+
+// Blocks xl..xh, yl..yh, column by column
+dboolean P_BlockThingsInBox(int xl, int xh, int yl, int yh, dboolean func(mobj_t*))
+{
+  int bx, by;
+
+  for (bx = xl; bx <= xh; bx++)
+    for (by = yl; by <= yh; by++)
+      if (!P_BlockThingsIterator(bx, by, func))
+        return false;
+  return true;
+}
+
+// Every block holding a thing that could touch bbox, column by column
+dboolean P_BlockThingsNearBox(const fixed_t *bbox, dboolean func(mobj_t*))
+{
+  return P_BlockThingsInBox(P_GetSafeBlockX(bbox[BOXLEFT] - bmaporgx - MAXRADIUS),
+                            P_GetSafeBlockX(bbox[BOXRIGHT] - bmaporgx + MAXRADIUS),
+                            P_GetSafeBlockY(bbox[BOXBOTTOM] - bmaporgy - MAXRADIUS),
+                            P_GetSafeBlockY(bbox[BOXTOP] - bmaporgy + MAXRADIUS),
+                            func);
+}
+
+// Blocks within dist of x, y, row by row.  Unlike P_BlockThingsNearBox,
+// dist must already include whatever reach the things are given.
+dboolean P_BlockThingsInRadius(fixed_t x, fixed_t y, fixed_t dist, dboolean func(mobj_t*))
+{
+  int bx, by;
+  int xl, xh, yl, yh;
+
+  yh = P_GetSafeBlockY(y + dist - bmaporgy);
+  yl = P_GetSafeBlockY(y - dist - bmaporgy);
+  xh = P_GetSafeBlockX(x + dist - bmaporgx);
+  xl = P_GetSafeBlockX(x - dist - bmaporgx);
+
+  for (by = yl; by <= yh; by++)
+    for (bx = xl; bx <= xh; bx++)
+      if (!P_BlockThingsIterator(bx, by, func))
+        return false;
+  return true;
+}
+
+// The block holding x, y, then rings of blocks around it out to distance
+// blocks away, nearest ring first.  Rings are clipped to the map the way
+// Hexen's P_RoughMonsterSearch does it, which can visit an edge block
+// more than once.
+dboolean P_BlockThingsSpiral(fixed_t x, fixed_t y, int distance, dboolean func(mobj_t*))
+{
+  int blockX;
+  int blockY;
+  int startX, startY;
+  int blockIndex;
+  int firstStop;
+  int secondStop;
+  int thirdStop;
+  int finalStop;
+  int count;
+
+  startX = (x - bmaporgx) >> MAPBLOCKSHIFT;
+  startY = (y - bmaporgy) >> MAPBLOCKSHIFT;
+
+  if (startX >= 0 && startX < bmapwidth && startY >= 0 && startY < bmapheight)
+  {
+    if (!P_BlockThingsAt(startY*bmapwidth + startX, func))
+    {
+      return false;
+    }
+  }
+  for (count = 1; count <= distance; count++)
+  {
+    blockX = startX - count;
+    blockY = startY - count;
+
+    if (blockY < 0)
+    {
+      blockY = 0;
+    }
+    else if (blockY >= bmapheight)
+    {
+      blockY = bmapheight - 1;
+    }
+    if (blockX < 0)
+    {
+      blockX = 0;
+    }
+    else if (blockX >= bmapwidth)
+    {
+      blockX = bmapwidth - 1;
+    }
+    blockIndex = blockY * bmapwidth + blockX;
+    firstStop = startX + count;
+    if (firstStop < 0)
+    {
+      continue;
+    }
+    if (firstStop >= bmapwidth)
+    {
+      firstStop = bmapwidth - 1;
+    }
+    secondStop = startY + count;
+    if (secondStop < 0)
+    {
+      continue;
+    }
+    if (secondStop >= bmapheight)
+    {
+      secondStop = bmapheight - 1;
+    }
+    thirdStop = secondStop * bmapwidth + blockX;
+    secondStop = secondStop * bmapwidth + firstStop;
+    firstStop += blockY * bmapwidth;
+    finalStop = blockIndex;
+
+    // Trace the first block section (along the top)
+    for (; blockIndex <= firstStop; blockIndex++)
+    {
+      if (!P_BlockThingsAt(blockIndex, func))
+      {
+        return false;
+      }
+    }
+    // Trace the second block section (right edge)
+    for (blockIndex--; blockIndex <= secondStop; blockIndex += bmapwidth)
+    {
+      if (!P_BlockThingsAt(blockIndex, func))
+      {
+        return false;
+      }
+    }
+    // Trace the third block section (bottom edge)
+    for (blockIndex -= bmapwidth; blockIndex >= thirdStop; blockIndex--)
+    {
+      if (!P_BlockThingsAt(blockIndex, func))
+      {
+        return false;
+      }
+    }
+    // Trace the final block section (left edge)
+    for (blockIndex++; blockIndex > finalStop; blockIndex -= bmapwidth)
+    {
+      if (!P_BlockThingsAt(blockIndex, func))
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
 //
 // INTERCEPT ROUTINES
 //
@@ -908,72 +1075,52 @@ dboolean P_PathTraverse(fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2,
 }
 
 //
-// RoughBlockCheck
+// PIT_RoughTarget
 // [XA] adapted from Hexen -- used by P_RoughTargetSearch
 //
 
-static mobj_t *Hexen_RoughBlockCheck(mobj_t * mo, int index);
+static mobj_t *rough_mo;
+static angle_t rough_fov;
+static mobj_t *rough_target;
 
-static mobj_t *RoughBlockCheck(mobj_t *mo, int index, angle_t fov)
-{
-  mobj_t *link;
+static dboolean PIT_HexenRoughTarget(mobj_t *link);
 
-  if (hexen) return Hexen_RoughBlockCheck(mo, index);
+static dboolean PIT_RoughTarget(mobj_t *link)
+{
+  mobj_t *mo = rough_mo;
 
-  link = blocklinks[index];
-  while (link)
-  {
-    // skip non-shootable actors
-    if (!(link->flags & MF_SHOOTABLE))
-    {
-      link = link->bnext;
-      continue;
-    }
+  if (hexen) return PIT_HexenRoughTarget(link);
 
-    // skip dormant actors
-    if (link->flags2 & MF2_DORMANT)
-    {
-        link = link->bnext;
-        continue;
-    }
+  // skip non-shootable actors
+  if (!(link->flags & MF_SHOOTABLE))
+    return true;
 
-    // skip the projectile's owner
-    if (link == mo->target)
-    {
-      link = link->bnext;
-      continue;
-    }
+  // skip dormant actors
+  if (link->flags2 & MF2_DORMANT)
+    return true;
 
-    // skip actors on the same "team", unless infighting or deathmatching
-    if (mo->target &&
-      !((link->flags ^ mo->target->flags) & MF_FRIEND) &&
-      mo->target->target != link &&
-      !(deathmatch && link->player && mo->target->player))
-    {
-      link = link->bnext;
-      continue;
-    }
+  // skip the projectile's owner
+  if (link == mo->target)
+    return true;
 
-    // skip actors outside of specified FOV
-    if (fov > 0 && !P_CheckFov(mo, link, fov))
-    {
-      link = link->bnext;
-      continue;
-    }
+  // skip actors on the same "team", unless infighting or deathmatching
+  if (mo->target &&
+    !((link->flags ^ mo->target->flags) & MF_FRIEND) &&
+    mo->target->target != link &&
+    !(deathmatch && link->player && mo->target->player))
+    return true;
 
-    // skip actors not in line of sight
-    if (!P_CheckSight(mo, link))
-    {
-      link = link->bnext;
-      continue;
-    }
+  // skip actors outside of specified FOV
+  if (rough_fov > 0 && !P_CheckFov(mo, link, rough_fov))
+    return true;
 
-    // all good! return it.
-    return link;
-  }
+  // skip actors not in line of sight
+  if (!P_CheckSight(mo, link))
+    return true;
 
-  // couldn't find a valid target
-  return NULL;
+  // all good! return it.
+  rough_target = link;
+  return false;
 }
 
 //
@@ -985,106 +1132,13 @@ static mobj_t *RoughBlockCheck(mobj_t *mo, int index, angle_t fov)
 
 mobj_t *P_RoughTargetSearch(mobj_t *mo, angle_t fov, int distance)
 {
-  int blockX;
-  int blockY;
-  int startX, startY;
-  int blockIndex;
-  int firstStop;
-  int secondStop;
-  int thirdStop;
-  int finalStop;
-  int count;
-  mobj_t *target;
+  rough_mo = mo;
+  rough_fov = fov;
+  rough_target = NULL;
 
-  startX = (mo->x - bmaporgx) >> MAPBLOCKSHIFT;
-  startY = (mo->y - bmaporgy) >> MAPBLOCKSHIFT;
-
-  if (startX >= 0 && startX < bmapwidth && startY >= 0 && startY < bmapheight)
-  {
-    if ((target = RoughBlockCheck(mo, startY*bmapwidth + startX, fov)))
-    { // found a target right away
-      return target;
-    }
-  }
-  for (count = 1; count <= distance; count++)
-  {
-    blockX = startX - count;
-    blockY = startY - count;
-
-    if (blockY < 0)
-    {
-      blockY = 0;
-    }
-    else if (blockY >= bmapheight)
-    {
-      blockY = bmapheight - 1;
-    }
-    if (blockX < 0)
-    {
-      blockX = 0;
-    }
-    else if (blockX >= bmapwidth)
-    {
-      blockX = bmapwidth - 1;
-    }
-    blockIndex = blockY * bmapwidth + blockX;
-    firstStop = startX + count;
-    if (firstStop < 0)
-    {
-      continue;
-    }
-    if (firstStop >= bmapwidth)
-    {
-      firstStop = bmapwidth - 1;
-    }
-    secondStop = startY + count;
-    if (secondStop < 0)
-    {
-      continue;
-    }
-    if (secondStop >= bmapheight)
-    {
-      secondStop = bmapheight - 1;
-    }
-    thirdStop = secondStop * bmapwidth + blockX;
-    secondStop = secondStop * bmapwidth + firstStop;
-    firstStop += blockY * bmapwidth;
-    finalStop = blockIndex;
+  P_BlockThingsSpiral(mo->x, mo->y, distance, PIT_RoughTarget);
 
-    // Trace the first block section (along the top)
-    for (; blockIndex <= firstStop; blockIndex++)
-    {
-      if ((target = RoughBlockCheck(mo, blockIndex, fov)))
-      {
-        return target;
-      }
-    }
-    // Trace the second block section (right edge)
-    for (blockIndex--; blockIndex <= secondStop; blockIndex += bmapwidth)
-    {
-      if ((target = RoughBlockCheck(mo, blockIndex, fov)))
-      {
-        return target;
-      }
-    }
-    // Trace the third block section (bottom edge)
-    for (blockIndex -= bmapwidth; blockIndex >= thirdStop; blockIndex--)
-    {
-      if ((target = RoughBlockCheck(mo, blockIndex, fov)))
-      {
-        return target;
-      }
-    }
-    // Trace the final block section (left edge)
-    for (blockIndex++; blockIndex > finalStop; blockIndex -= bmapwidth)
-    {
-      if ((target = RoughBlockCheck(mo, blockIndex, fov)))
-      {
-        return target;
-      }
-    }
-  }
-  return NULL;
+  return rough_target;
 }
 
 // MAES: support 512x512 blockmaps.
@@ -1163,140 +1217,123 @@ intercepts_overrun_t intercepts_overrun[] =
 
 // hexen
 
-static mobj_t *Hexen_RoughBlockCheck(mobj_t * mo, int index)
+static dboolean PIT_HexenRoughTarget(mobj_t * link)
 {
-    mobj_t *link;
+    mobj_t *mo = rough_mo;
     mobj_t *master;
     angle_t angle;
 
-    link = blocklinks[index];
-    while (link)
+    if (mo->player)             // Minotaur looking around player
     {
-        if (mo->player)         // Minotaur looking around player
+        if ((link->flags & MF_COUNTKILL) ||
+            (link->player && (link != mo)))
         {
-            if ((link->flags & MF_COUNTKILL) ||
-                (link->player && (link != mo)))
+            if (!(link->flags & MF_SHOOTABLE))
             {
-                if (!(link->flags & MF_SHOOTABLE))
-                {
-                    link = link->bnext;
-                    continue;
-                }
-                if (link->flags2 & MF2_DORMANT)
-                {
-                    link = link->bnext;
-                    continue;
-                }
-                if ((link->type == HEXEN_MT_MINOTAUR) &&
-                    (link->special1.m == mo))
-                {
-                    link = link->bnext;
-                    continue;
-                }
-                if (netgame && !deathmatch && link->player)
-                {
-                    link = link->bnext;
-                    continue;
-                }
-                if (P_CheckSight(mo, link))
-                {
-                    return link;
-                }
+                return true;
+            }
+            if (link->flags2 & MF2_DORMANT)
+            {
+                return true;
+            }
+            if ((link->type == HEXEN_MT_MINOTAUR) &&
+                (link->special1.m == mo))
+            {
+                return true;
+            }
+            if (netgame && !deathmatch && link->player)
+            {
+                return true;
+            }
+            if (P_CheckSight(mo, link))
+            {
+                rough_target = link;
+                return false;
             }
-            link = link->bnext;
         }
-        else if (mo->type == HEXEN_MT_MINOTAUR)       // looking around minotaur
+    }
+    else if (mo->type == HEXEN_MT_MINOTAUR)   // looking around minotaur
+    {
+        master = mo->special1.m;
+        if ((link->flags & MF_COUNTKILL) ||
+            (link->player && (link != master)))
         {
-            master = mo->special1.m;
-            if ((link->flags & MF_COUNTKILL) ||
-                (link->player && (link != master)))
+            if (!(link->flags & MF_SHOOTABLE))
             {
-                if (!(link->flags & MF_SHOOTABLE))
-                {
-                    link = link->bnext;
-                    continue;
-                }
-                if (link->flags2 & MF2_DORMANT)
-                {
-                    link = link->bnext;
-                    continue;
-                }
-                if ((link->type == HEXEN_MT_MINOTAUR) &&
-                    (link->special1.m == mo->special1.m))
-                {
-                    link = link->bnext;
-                    continue;
-                }
-                if (netgame && !deathmatch && link->player)
-                {
-                    link = link->bnext;
-                    continue;
-                }
-                if (P_CheckSight(mo, link))
-                {
-                    return link;
-                }
+                return true;
+            }
+            if (link->flags2 & MF2_DORMANT)
+            {
+                return true;
+            }
+            if ((link->type == HEXEN_MT_MINOTAUR) &&
+                (link->special1.m == mo->special1.m))
+            {
+                return true;
+            }
+            if (netgame && !deathmatch && link->player)
+            {
+                return true;
+            }
+            if (P_CheckSight(mo, link))
+            {
+                rough_target = link;
+                return false;
             }
-            link = link->bnext;
         }
-        else if (mo->type == HEXEN_MT_MSTAFF_FX2)     // bloodscourge
+    }
+    else if (mo->type == HEXEN_MT_MSTAFF_FX2) // bloodscourge
+    {
+        if ((link->flags & MF_COUNTKILL ||
+             (link->player && link != mo->target))
+            && !(link->flags2 & MF2_DORMANT))
         {
-            if ((link->flags & MF_COUNTKILL ||
-                 (link->player && link != mo->target))
-                && !(link->flags2 & MF2_DORMANT))
+            if (!(link->flags & MF_SHOOTABLE))
             {
-                if (!(link->flags & MF_SHOOTABLE))
-                {
-                    link = link->bnext;
-                    continue;
-                }
-                if (netgame && !deathmatch && link->player)
-                {
-                    link = link->bnext;
-                    continue;
-                }
-                else if (P_CheckSight(mo, link))
+                return true;
+            }
+            if (netgame && !deathmatch && link->player)
+            {
+                return true;
+            }
+            else if (P_CheckSight(mo, link))
+            {
+                master = mo->target;
+                angle = R_PointToAngle2(master->x, master->y,
+                                        link->x, link->y) - master->angle;
+                angle >>= 24;
+                if (angle > 226 || angle < 30)
                 {
-                    master = mo->target;
-                    angle = R_PointToAngle2(master->x, master->y,
-                                            link->x, link->y) - master->angle;
-                    angle >>= 24;
-                    if (angle > 226 || angle < 30)
-                    {
-                        return link;
-                    }
+                    rough_target = link;
+                    return false;
                 }
             }
-            link = link->bnext;
         }
-        else                    // spirits
+    }
+    else                        // spirits
+    {
+        if ((link->flags & MF_COUNTKILL ||
+             (link->player && link != mo->target))
+            && !(link->flags2 & MF2_DORMANT))
         {
-            if ((link->flags & MF_COUNTKILL ||
-                 (link->player && link != mo->target))
-                && !(link->flags2 & MF2_DORMANT))
+            if (!(link->flags & MF_SHOOTABLE))
             {
-                if (!(link->flags & MF_SHOOTABLE))
-                {
-                    link = link->bnext;
-                    continue;
-                }
-                if (netgame && !deathmatch && link->player)
-                {
-                    link = link->bnext;
-                    continue;
-                }
-                if (link == mo->target)
-                {
-                    link = link->bnext;
-                    continue;
-                }
-                else if (P_CheckSight(mo, link))
-                {
-                    return link;
-                }
+                return true;
+            }
+            if (netgame && !deathmatch && link->player)
+            {
+                return true;
+            }
+            if (link == mo->target)
+            {
+                return true;
+            }
+            else if (P_CheckSight(mo, link))
+            {
+                rough_target = link;
+                return false;
             }
-            link = link->bnext;
         }
     }
-    return NULL;
+    return true;
 }
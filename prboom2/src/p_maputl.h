@@ -95,6 +95,10 @@ void    P_SetThingPosition(mobj_t *thing);
 dboolean P_BlockLinesIterator (int x, int y, dboolean func(line_t *));
 dboolean P_BlockLinesIterator2(int x, int y, dboolean func(line_t *));
 dboolean P_BlockThingsIterator(int x, int y, dboolean func(mobj_t *));
+dboolean P_BlockThingsInBox(int xl, int xh, int yl, int yh, dboolean func(mobj_t *));
+dboolean P_BlockThingsNearBox(const fixed_t *bbox, dboolean func(mobj_t *));
+dboolean P_BlockThingsInRadius(fixed_t x, fixed_t y, fixed_t dist, dboolean func(mobj_t *));
+dboolean P_BlockThingsSpiral(fixed_t x, fixed_t y, int distance, dboolean func(mobj_t *));
 dboolean P_PathTraverse(fixed_t x1, fixed_t y1, fixed_t x2, fixed_t y2,
                        int flags, dboolean trav(intercept_t *));
 
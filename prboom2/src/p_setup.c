@@ -67,6 +67,7 @@
 #include "dsda/mapinfo.h"
 #include "dsda/settings.h"
 #include "dsda/skip.h"
+#include "dsda/time.h"
 #include "dsda/tranmap.h"
 #include "dsda/udmf.h"
 #include "dsda/utility.h"
@@ -3001,7 +3002,9 @@ static void P_LoadBlockMap (int lump)
     (count /= 2) >= 0x10000 //e6y
   )
   {
+    dsda_BeginTimedPhase("P_CreateBlockMap");
     P_CreateBlockMap();
+    dsda_EndTimedPhase();
   }
   else
   {
@@ -3192,12 +3195,17 @@ static int P_GroupLines (void)
 static void P_LoadReject(int lump)
 {
   unsigned int length;
+  int total;
 
   length = W_SafeLumpLength(lump);
   rejectmatrix = W_SafeLumpByNum(lump);
 
+  dsda_BeginTimedPhase("P_GroupLines");
+  total = P_GroupLines();
+  dsda_EndTimedPhase();
+
   //e6y: check for overflow
-  RejectOverrun(length, &rejectmatrix, P_GroupLines());
+  RejectOverrun(length, &rejectmatrix, total);
 }
 
 //
@@ -3687,6 +3695,14 @@ void P_SetupLevel(int episode, int map, int playermask, skill_t skill)
   char  gl_lumpname[9];
   int   gl_lumpnum;
 
+  char  phase_name[32];
+
+  // find map name
+  strcpy(lumpname, MAPNAME(episode, map));
+
+  snprintf(phase_name, sizeof(phase_name), "P_SetupLevel %s", lumpname);
+  dsda_BeginTimedPhase(phase_name);
+
   //e6y
   totallive = 0;
 
@@ -3710,15 +3726,15 @@ void P_SetupLevel(int episode, int map, int playermask, skill_t skill)
   // Make sure all sounds are stopped before Z_FreeTag.
   S_Start();
 
+  dsda_BeginTimedPhase("Z_FreeLevel");
   Z_FreeLevel();
+  dsda_EndTimedPhase();
 
   P_InitThinkers();
 
   // if working with a devlopment map, reload it
   //    W_Reload ();     killough 1/31/98: W_Reload obsolete
 
-  // find map name
-  strcpy(lumpname, MAPNAME(episode, map));
   lumpnum = W_GetNumForName(lumpname);
 
   if (strlen(lumpname) < 6)
@@ -3782,11 +3798,22 @@ void P_SetupLevel(int episode, int map, int playermask, skill_t skill)
 
   dsda_ResetHealthGroups();
 
+  dsda_BeginTimedPhase("P_LoadVertexes");
   map_loader.load_vertexes(level_components.vertexes, level_components.gl_verts);
+  dsda_EndTimedPhase();
+
+  dsda_BeginTimedPhase("P_LoadSectors");
   map_loader.load_sectors(level_components.sectors);
+  dsda_EndTimedPhase();
+
+  dsda_BeginTimedPhase("P_LoadLineDefs");
   map_loader.allocate_sidedefs(level_components.sidedefs);
   map_loader.load_linedefs(level_components.linedefs);
+  dsda_EndTimedPhase();
+
+  dsda_BeginTimedPhase("P_LoadSideDefs");
   map_loader.load_sidedefs(level_components.sidedefs);
+  dsda_EndTimedPhase();
 
   P_PostProcessLineDefs();
 
@@ -3799,13 +3826,17 @@ void P_SetupLevel(int episode, int map, int playermask, skill_t skill)
   if (!samelevel || must_rebuild_blockmap)
   {
     must_rebuild_blockmap = false;
+    dsda_BeginTimedPhase("P_LoadBlockMap");
     P_LoadBlockMap(level_components.blockmap);
+    dsda_EndTimedPhase();
   }
   else
   {
     memset(blocklinks, 0, bmapwidth*bmapheight*sizeof(*blocklinks));
   }
 
+  dsda_BeginTimedPhase("P_LoadNodes");
+
   switch (nodesVersion)
   {
     case GL_V1_NODES:
@@ -3856,6 +3887,8 @@ void P_SetupLevel(int episode, int map, int playermask, skill_t skill)
       break;
   }
 
+  dsda_EndTimedPhase();
+
   if (!samelevel)
   {
     P_InitSubsectorsLines();
@@ -3865,9 +3898,13 @@ void P_SetupLevel(int episode, int map, int playermask, skill_t skill)
     numsubsectors, sizeof(map_subsectors[0]));
 
   // reject loading and underflow padding separated out into new function
+  dsda_BeginTimedPhase("P_LoadReject");
   P_LoadReject(level_components.reject);
+  dsda_EndTimedPhase();
 
+  dsda_BeginTimedPhase("P_RemoveSlimeTrails");
   P_RemoveSlimeTrails();    // killough 10/98: remove slime trails from wad
+  dsda_EndTimedPhase();
 
   // should be after P_RemoveSlimeTrails, because it changes vertexes
   R_CalcSegsLength();
@@ -3900,7 +3937,9 @@ void P_SetupLevel(int episode, int map, int playermask, skill_t skill)
     PO_ResetBlockMap(true);
   }
 
+  dsda_BeginTimedPhase("P_LoadThings");
   map_loader.load_things(level_components.things);
+  dsda_EndTimedPhase();
 
   if (map_format.polyobjs)
   {
@@ -3955,7 +3994,9 @@ void P_SetupLevel(int episode, int map, int playermask, skill_t skill)
   iquehead = iquetail = 0;
 
   // set up world state
+  dsda_BeginTimedPhase("P_SpawnSpecials");
   P_SpawnSpecials();
+  dsda_EndTimedPhase();
 
   dsda_WatchAfterLevelSetup();
 
@@ -3964,7 +4005,9 @@ void P_SetupLevel(int episode, int map, int playermask, skill_t skill)
   dsda_ApplyFadeTable();
 
   // preload graphics
+  dsda_BeginTimedPhase("R_PrecacheLevel");
   R_PrecacheLevel();
+  dsda_EndTimedPhase();
 
   if (V_IsOpenGLMode())
   {
@@ -3990,10 +4033,14 @@ void P_SetupLevel(int episode, int map, int playermask, skill_t skill)
     SN_StopAllSequences();
   }
 
+  AM_InitLineGrid();
+
   if (dsda_ShowMinimap())
   {
     AM_Start(false);
   }
+
+  dsda_EndTimedPhase();
 }
 
 //
@@ -4479,7 +4479,6 @@ void T_Pusher(pusher_t *p)
     mobj_t   *thing;
     msecnode_t* node;
     int xspeed,yspeed;
-    int xl,xh,yl,yh,bx,by;
     int radius;
     int ht = 0;
 
@@ -4521,13 +4520,7 @@ void T_Pusher(pusher_t *p)
         tmbbox[BOXRIGHT]  = p->x + radius;
         tmbbox[BOXLEFT]   = p->x - radius;
 
-        xl = P_GetSafeBlockX(tmbbox[BOXLEFT] - bmaporgx - MAXRADIUS);
-        xh = P_GetSafeBlockX(tmbbox[BOXRIGHT] - bmaporgx + MAXRADIUS);
-        yl = P_GetSafeBlockY(tmbbox[BOXBOTTOM] - bmaporgy - MAXRADIUS);
-        yh = P_GetSafeBlockY(tmbbox[BOXTOP] - bmaporgy + MAXRADIUS);
-        for (bx=xl ; bx<=xh ; bx++)
-            for (by=yl ; by<=yh ; by++)
-                P_BlockThingsIterator(bx,by,PIT_PushThing);
+        P_BlockThingsNearBox(tmbbox, PIT_PushThing);
         return;
         }
 
@@ -67,6 +67,7 @@
 #include "dsda/settings.h"
 #include "dsda/signal_context.h"
 #include "dsda/stretch.h"
+#include "dsda/time.h"
 #include "dsda/gl/render_scale.h"
 
 #include "hexen/a_action.h"
@@ -720,7 +721,9 @@ void R_Init (void)
   lprintf(LO_DEBUG, "\nR_LoadTrigTables: ");
   R_LoadTrigTables();
   lprintf(LO_DEBUG, "\nR_InitData: ");
+  dsda_BeginTimedPhase("R_InitData");
   R_InitData();
+  dsda_EndTimedPhase();
   R_SetViewSize();
   lprintf(LO_DEBUG, "\nR_Init: R_InitPlanes ");
   R_InitPlanes();
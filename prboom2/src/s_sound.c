@@ -191,6 +191,7 @@ void S_Init(void)
         S_sfx[i].lumpnum = -1;
 
       dsda_CacheSoundLumps();
+      I_PrecacheSounds();
 
       // {
       //   int i;
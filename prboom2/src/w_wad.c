@@ -341,6 +341,88 @@ unsigned W_LumpNameHash(const char *s)
   return hash;
 }
 
+// Packs an 8-character lump name into a single case-insensitive key.
+// Two names compare equal under strncasecmp(a, b, 8) exactly when their
+// keys are equal, so lookups only ever compare one integer.
+
+uint64_t W_LumpNameKey(const char *s)
+{
+  uint64_t key = 0;
+  int i;
+
+  for (i = 0; i < 8 && s[i]; ++i)
+    key |= (uint64_t) (byte) toupper(s[i]) << (i * 8);
+
+  return key;
+}
+
+//
+// Lump directory
+//
+// Each namespace has its own open-addressing table keyed by the packed name.
+// A slot holds the newest and the oldest lump with that name; the lumps in
+// between are linked through lumpinfo[].next (older) and lumpinfo[].prev
+// (newer), so the "last lump wins" lookup and the enumeration of every lump
+// sharing a name are both O(1) per step.
+//
+
+#define LUMP_NAMESPACES (ns_hires + 1)
+
+typedef struct
+{
+  uint64_t key;
+  int last;
+  int first;
+} lump_slot_t;
+
+typedef struct
+{
+  lump_slot_t *slots;
+  unsigned int mask;
+} lump_table_t;
+
+static lump_table_t lump_tables[LUMP_NAMESPACES];
+
+static unsigned int W_LumpKeyHash(uint64_t key)
+{
+  key *= 0x9E3779B97F4A7C15ull;
+
+  return (unsigned int) (key >> 32);
+}
+
+static lump_slot_t *W_LumpSlot(const lump_table_t *table, uint64_t key)
+{
+  unsigned int i;
+
+  if (!table->slots)
+    return NULL;
+
+  for (i = W_LumpKeyHash(key) & table->mask; ; i = (i + 1) & table->mask)
+  {
+    lump_slot_t *slot = &table->slots[i];
+
+    if (slot->last == LUMP_NOT_FOUND || slot->key == key)
+      return slot;
+  }
+}
+
+static const lump_slot_t *W_FindLumpSlot(uint64_t key, int li_namespace)
+{
+  const lump_slot_t *slot;
+
+  if (li_namespace < 0 || li_namespace >= LUMP_NAMESPACES)
+    return NULL;
+
+  slot = W_LumpSlot(&lump_tables[li_namespace], key);
+
+  return slot && slot->last != LUMP_NOT_FOUND ? slot : NULL;
+}
+
+static dboolean W_LumpMatches(int lump, uint64_t key, int li_namespace)
+{
+  return lumpinfo[lump].key == key && lumpinfo[lump].li_namespace == li_namespace;
+}
+
 //
 // W_CheckNumForName
 // Returns LUMP_NOT_FOUND if name not found.
@@ -350,48 +432,41 @@ unsigned W_LumpNameHash(const char *s)
 // single most important optimization of the original Doom sources, because
 // lump name lookup is used so often, and the original Doom used a sequential
 // search. For large wads with > 1000 lumps this meant an average of over
-// 500 were probed during every search. Now the average is under 2 probes per
-// search. There is no significant benefit to packing the names into longwords
-// with this new hashing algorithm, because the work to do the packing is
-// just as much work as simply doing the string comparisons with the new
-// algorithm, which minimizes the expected number of comparisons to under 2.
+// 500 were probed during every search.
 //
 // killough 4/17/98: add namespace parameter to prevent collisions
 // between different resources such as flats, sprites, colormaps
 //
+// The directory is now keyed by packed names with one table per namespace,
+// which keeps probes short for wads with tens of thousands of lumps.
+//
 
 // W_FindNumFromName, an iterative version of W_CheckNumForName
 // returns list of lump numbers for a given name (latest first)
 //
 int W_FindNumFromName2(const char *name, int li_namespace, int i)
 {
-  // Hash function maps the name to one of possibly numlump chains.
-  // It has been tuned so that the average chain length never exceeds 2.
+  uint64_t key = W_LumpNameKey(name);
 
-  // proff 2001/09/07 - check numlumps==0, this happens when called before WAD loaded
-  if (numlumps == 0)
-    i = LUMP_NOT_FOUND;
-  else
+  if (i < 0)
   {
-    if (i < 0)
-      i = lumpinfo[W_LumpNameHash(name) % (unsigned) numlumps].index;
-    else
-      i = lumpinfo[i].next;
-
-  // We search along the chain until end, looking for case-insensitive
-  // matches which also match a namespace tag. Separate hash tables are
-  // not used for each namespace, because the performance benefit is not
-  // worth the overhead, considering namespace collisions are rare in
-  // Doom wads.
+    const lump_slot_t *slot = W_FindLumpSlot(key, li_namespace);
 
-  while (i != LUMP_NOT_FOUND && (strncasecmp(lumpinfo[i].name, name, 8) ||
-                                 lumpinfo[i].li_namespace != li_namespace))
-    i = lumpinfo[i].next;
+    return slot ? slot->last : LUMP_NOT_FOUND;
   }
 
-  // Return the matching lump, or LUMP_NOT_FOUND if none found.
+  if (i >= numlumps)
+    return LUMP_NOT_FOUND;
 
-  return i;
+  if (W_LumpMatches(i, key, li_namespace))
+    return lumpinfo[i].next;
+
+  // The previous result was not one of ours - fall back to the older lumps
+  while (--i >= 0)
+    if (W_LumpMatches(i, key, li_namespace))
+      return i;
+
+  return LUMP_NOT_FOUND;
 }
 
 //
@@ -400,21 +475,65 @@ int W_FindNumFromName2(const char *name, int li_namespace, int i)
 
 void W_HashLumps(void)
 {
+  int counts[LUMP_NAMESPACES] = { 0 };
   int i;
 
-  for (i=0; i<numlumps; i++)
-    lumpinfo[i].index = LUMP_NOT_FOUND;         // mark slots empty
+  for (i = 0; i < LUMP_NAMESPACES; ++i)
+  {
+    Z_Free(lump_tables[i].slots);
+    lump_tables[i].slots = NULL;
+    lump_tables[i].mask = 0;
+  }
+
+  for (i = 0; i < numlumps; i++)
+  {
+    lumpinfo[i].key = W_LumpNameKey(lumpinfo[i].name);
+    lumpinfo[i].next = LUMP_NOT_FOUND;
+    lumpinfo[i].prev = LUMP_NOT_FOUND;
+    counts[lumpinfo[i].li_namespace]++;
+  }
+
+  // Keep each table at most half full
+  for (i = 0; i < LUMP_NAMESPACES; ++i)
+  {
+    unsigned int size = 8;
+    unsigned int j;
+
+    if (!counts[i])
+      continue;
+
+    while (size < 2 * (unsigned int) counts[i])
+      size <<= 1;
+
+    lump_tables[i].slots = Z_Malloc(size * sizeof(*lump_tables[i].slots));
+    lump_tables[i].mask = size - 1;
+
+    for (j = 0; j < size; ++j)
+      lump_tables[i].slots[j].last = LUMP_NOT_FOUND;
+  }
+
+  // Insert lumps in first-to-last order, so that the last lump of a given
+  // name is found first, observing pwad ordering rules. killough
+
+  for (i = 0; i < numlumps; i++)
+  {
+    lump_slot_t *slot;
 
-  // Insert nodes to the beginning of each chain, in first-to-last
-  // lump order, so that the last lump of a given name appears first
-  // in any chain, observing pwad ordering rules. killough
+    slot = W_LumpSlot(&lump_tables[lumpinfo[i].li_namespace], lumpinfo[i].key);
 
-  for (i=0; i<numlumps; i++)
-    {                                           // hash function:
-      int j = W_LumpNameHash(lumpinfo[i].name) % (unsigned) numlumps;
-      lumpinfo[i].next = lumpinfo[j].index;     // Prepend to list
-      lumpinfo[j].index = i;
+    if (slot->last == LUMP_NOT_FOUND)
+    {
+      slot->key = lumpinfo[i].key;
+      slot->first = i;
+    }
+    else
+    {
+      lumpinfo[i].next = slot->last;
+      lumpinfo[slot->last].prev = i;
     }
+
+    slot->last = i;
+  }
 }
 
 // End of lump hashing -- killough 1/31/98
@@ -457,17 +576,19 @@ int W_CheckNumForNameInternal(const char *name)
 }
 
 // W_ListNumFromName
-// calls W_FindNumFromName and returns the lumps in ascending order
+// returns the global lumps with the given name in ascending order
 //
 int W_ListNumFromName(const char *name, int lump)
 {
-  int i, next;
+  uint64_t key = W_LumpNameKey(name);
+  const lump_slot_t *slot;
 
-  for (i = LUMP_NOT_FOUND; (next = W_FindNumFromName(name, i)) != LUMP_NOT_FOUND; i = next)
-    if (next == lump)
-      break;
+  if (W_LumpNumExists(lump) && W_LumpMatches(lump, key, ns_global))
+    return lumpinfo[lump].prev;
 
-  return i;
+  slot = W_FindLumpSlot(key, ns_global);
+
+  return slot ? slot->first : LUMP_NOT_FOUND;
 }
 
 // W_Init
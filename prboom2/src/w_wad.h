@@ -36,6 +36,7 @@
 #define __W_WAD__
 
 #include <stddef.h>
+#include <stdint.h>
 
 //
 // TYPES
@@ -115,7 +116,10 @@ typedef struct
   int   size;
 
   // killough 1/31/98: hash table fields, used for ultra-fast hash table lookup
-  int index, next;
+  // key: upper-cased name packed into 64 bits (see W_LumpNameKey)
+  // next / prev: older / newer lump with the same name in the same namespace
+  uint64_t key;
+  int next, prev;
 
   // killough 4/17/98: namespace tags, to prevent conflicts between resources
   li_namespace_e li_namespace; // haleyjd 05/21/02: renamed from "namespace"
@@ -172,6 +176,7 @@ int W_LumpNameExists2(const char *name, int ns);
 char *AddDefaultExtension(char *, const char *);  // killough 1/18/98
 void ExtractFileBase(const char *, char *);       // killough
 unsigned W_LumpNameHash(const char *s);           // killough 1/31/98
+uint64_t W_LumpNameKey(const char *s);
 void W_HashLumps(void);                           // cph 2001/07/07 - made public
 int W_LumpNumInPortWad(int lump);
 
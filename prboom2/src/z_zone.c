@@ -78,6 +78,10 @@ static const size_t HEADER_SIZE = sizeof(memblock_t);
 
 static memblock_t *blockbytag[ZONE_MAX];
 
+// Running totals for the load timeline
+static unsigned long long alloc_count;
+static unsigned long long alloc_bytes;
+
 /* Z_Malloc
  * cph - the algorithm here was a very simple first-fit round-robin
  *  one - just keep looping around, freeing everything we can until
@@ -118,6 +122,9 @@ static void *Z_MallocTag(size_t size, int tag)
   block->tag = tag;           // tag
   block = (memblock_t *)((char *) block + HEADER_SIZE);
 
+  ++alloc_count;
+  alloc_bytes += size;
+
   return block;
 }
 
@@ -187,6 +194,12 @@ static char *Z_StrdupTag(const char *s, int tag)
   return strcpy(Z_MallocTag(strlen(s)+1, tag), s);
 }
 
+void Z_AllocationStats(unsigned long long *count, unsigned long long *bytes)
+{
+  *count = alloc_count;
+  *bytes = alloc_bytes;
+}
+
 void *Z_Malloc(size_t size)
 {
   return Z_MallocTag(size, ZONE_STATIC);